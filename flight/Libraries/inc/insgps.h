@@ -63,6 +63,9 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 //! Compute an update of the state covariance
 void INSCovariancePrediction(float dT);
 
+//! Compute an update of the state covariance over several state predictions
+void INSCovariancePredictionBatch(float dT, uint16_t steps);
+
 //! Correct the state and covariance estimate based on the sensors that were updated
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
 
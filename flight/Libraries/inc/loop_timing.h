@@ -0,0 +1,40 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @file       loop_timing.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Control loop latency and jitter histograms
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOOP_TIMING_H
+#define LOOP_TIMING_H
+
+#include <stdint.h>
+
+int32_t loop_timing_init(void);
+void loop_timing_gyro_sampled(void);
+void loop_timing_loop_done(uint32_t period_us, uint32_t expected_us);
+void loop_timing_outputs_written(void);
+
+#endif /* LOOP_TIMING_H */
+
+/**
+ * @}
+ */
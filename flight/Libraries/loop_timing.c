@@ -0,0 +1,179 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       loop_timing.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Control loop latency and jitter histograms
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * The sensor code stamps each gyro sample, stabilization passes on the
+ * stamp of the sample its output was computed from, and the actuator
+ * measures the latency once it has written the outputs. Stabilization also
+ * reports each loop period. Both go into histograms with power of two
+ * bucket bounds, so counting a loop is a count leading zeros and an
+ * increment, and LoopTiming is published about once a second.
+ *
+ * Stabilization and the actuator run at the same priority, so the actuator
+ * normally writes an output while stabilization waits for the next sample.
+ * If it falls a whole loop behind, the latency is measured from the newer
+ * sample and reads low.
+ *
+ * The two tasks share the pending output and the latency fields, so those
+ * are only touched with interrupts disabled, for a few instructions at a
+ * time. Publishing copies the object out under the same lock and sends
+ * the copy.
+ */
+
+#include "openpilot.h"
+#include "loop_timing.h"
+#include "looptiming.h"
+
+// Private constants
+#define PUBLISH_PERIOD_US 1000000
+
+#define LATENCY_SHIFT 6		/* First bucket is under 64us */
+#define JITTER_SHIFT 3		/* First bucket is under 8us */
+
+DONT_BUILD_IF(LOOPTIMING_LATENCY_NUMELEM != LOOPTIMING_JITTER_NUMELEM,
+		looptimingBuckets);
+
+// Private variables
+static LoopTimingData timing;
+
+static volatile uint32_t gyro_time;
+static uint32_t output_gyro_time;
+static bool output_pending;
+
+static uint32_t since_publish_us;
+
+/**
+ * @brief Histogram bucket of a time
+ * @param[in] us the time
+ * @param[in] shift log2 of the upper bound of the first bucket
+ * @return the bucket; the last one holds everything over the bounds
+ */
+static inline int bucket(uint32_t us, int shift)
+{
+	us >>= shift;
+
+	if (!us) {
+		return 0;
+	}
+
+	int b = 32 - __builtin_clz(us);
+
+	return (b < LOOPTIMING_LATENCY_NUMELEM) ? b :
+		(LOOPTIMING_LATENCY_NUMELEM - 1);
+}
+
+/**
+ * @brief Initialize the loop timing object
+ * @return 0 on success, -1 if the object could not be initialized
+ */
+int32_t loop_timing_init(void)
+{
+	if (LoopTimingInitialize() == -1) {
+		return -1;
+	}
+
+	LoopTimingGet(&timing);
+
+	return 0;
+}
+
+/**
+ * @brief Note the arrival of a gyro sample
+ */
+void loop_timing_gyro_sampled(void)
+{
+	gyro_time = PIOS_DELAY_GetRaw();
+}
+
+/**
+ * @brief Account a stabilization loop; called as its output is handed on
+ * @param[in] period_us time since the previous loop
+ * @param[in] expected_us the period the loop should run at
+ */
+void loop_timing_loop_done(uint32_t period_us, uint32_t expected_us)
+{
+	uint32_t sample_time = gyro_time;
+
+	PIOS_IRQ_Disable();
+	output_gyro_time = sample_time;
+	output_pending = true;
+	PIOS_IRQ_Enable();
+
+	// Only this task touches the jitter fields
+	uint32_t jitter_us = (period_us > expected_us) ?
+		(period_us - expected_us) : (expected_us - period_us);
+
+	timing.Jitter[bucket(jitter_us, JITTER_SHIFT)]++;
+
+	if (jitter_us > timing.MaxJitter) {
+		timing.MaxJitter = jitter_us;
+	}
+
+	since_publish_us += period_us;
+
+	if (since_publish_us >= PUBLISH_PERIOD_US) {
+		since_publish_us = 0;
+
+		LoopTimingData published;
+
+		PIOS_IRQ_Disable();
+		published = timing;
+		timing.MaxJitter = 0;
+		timing.MaxLatency = 0;
+		PIOS_IRQ_Enable();
+
+		LoopTimingSet(&published);
+	}
+}
+
+/**
+ * @brief Account the latency of an output; called once it is written
+ */
+void loop_timing_outputs_written(void)
+{
+	uint32_t now = PIOS_DELAY_GetRaw();
+
+	PIOS_IRQ_Disable();
+
+	if (output_pending) {
+		output_pending = false;
+
+		uint32_t latency_us = PIOS_DELAY_DiffuS2(output_gyro_time, now);
+
+		timing.Latency[bucket(latency_us, LATENCY_SHIFT)]++;
+
+		if (latency_us > timing.MaxLatency) {
+			timing.MaxLatency = latency_us;
+		}
+	}
+
+	PIOS_IRQ_Enable();
+}
+
+/**
+ * @}
+ */
@@ -29,13 +29,92 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <math.h>
 #include "pios.h"
 #include "lpfilter.h"
+#include "misc_math.h"
 
 #define MAX_FILTER_WIDTH		16
 
+//! Biquads in a lowpass filter; enough for 8th order
+#define LPFILTER_MAX_BIQUADS		4
+
+//! A peak must be this many times the mean of the range to be followed
+#define LPFILTER_NOTCH_PEAK_RATIO	3.0f
+
+//! How far a notch moves towards a new peak at each update
+#define LPFILTER_NOTCH_SMOOTHING	0.3f
+
+/*
+ * Where SIMD is available every biquad is run over four axes at once,
+ * using GCC vector extensions (SSE or NEON in flightd); otherwise, as on
+ * the Cortex-M targets, the same code runs one axis at a time.
+ */
+#if defined(__SSE__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef float lpfilter_vec __attribute__((vector_size(16)));
+#define LPFILTER_VEC_LANES		4
+
+static inline lpfilter_vec lpfilter_splat(float f)
+{
+	return (lpfilter_vec) { f, f, f, f };
+}
+
+/* Element by element, so as not to stall on the caller's float stores */
+static inline lpfilter_vec lpfilter_load_partial(const float *p, int n)
+{
+	switch (n) {
+	case 1:
+		return (lpfilter_vec) { p[0], 0, 0, 0 };
+	case 2:
+		return (lpfilter_vec) { p[0], p[1], 0, 0 };
+	default:
+		return (lpfilter_vec) { p[0], p[1], p[2], 0 };
+	}
+}
+
+static inline void lpfilter_store_partial(float *p, lpfilter_vec v, int n)
+{
+	p[0] = v[0];
+
+	if (n > 1)
+		p[1] = v[1];
+	if (n > 2)
+		p[2] = v[2];
+}
+#else
+typedef float lpfilter_vec;
+#define LPFILTER_VEC_LANES		1
+
+static inline lpfilter_vec lpfilter_splat(float f)
+{
+	return f;
+}
+
+static inline lpfilter_vec lpfilter_load_partial(const float *p, int n)
+{
+	return *p;
+}
+
+static inline void lpfilter_store_partial(float *p, lpfilter_vec v, int n)
+{
+	*p = v;
+}
+#endif
+
+static inline lpfilter_vec lpfilter_load(const float *p)
+{
+	lpfilter_vec v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void lpfilter_store(float *p, lpfilter_vec v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
 static const float lpfilter_butterworth_factors[16] = {
 	// 2nd order
 	1.4142f,
@@ -59,47 +138,113 @@ static const float lpfilter_butterworth_factors[16] = {
 	0.3902f, 1.1111f, 1.6629f, 1.9616f
 };
 
-struct lpfilter_biquad_state {
-	float x1, x2, y1, y2;
-};
-
-struct lpfilter_biquad {
-	float b0, a1, a2;
-	struct lpfilter_biquad_state *s;
-};
-
-struct lpfilter_first_order {
-	float alpha;
-	float *prev;
+/* Coefficients, then state, of a biquad stage; each is an array of lanes */
+enum {
+	LPFILTER_B0, LPFILTER_B1, LPFILTER_B2, LPFILTER_A1, LPFILTER_A2,
+	LPFILTER_Z1, LPFILTER_Z2,
+	LPFILTER_STAGE_ARRAYS
 };
 
+/*
+ * The whole filter is a single allocation, with its state kept as a
+ * structure of arrays: each coefficient and state variable of a stage is
+ * an array over the axes (padded to a whole number of vectors), so all
+ * axes of a stage are worked on together out of adjacent memory.
+ *
+ * data[] holds the first order state, then each biquad stage, then the
+ * centers of a notch filter.
+ */
 struct lpfilter_state {
-
-	struct lpfilter_first_order *first_order;
-	struct lpfilter_biquad *biquad[4];
 	uint8_t order;
 	uint8_t width;
+	uint8_t lanes;
+	uint8_t stages;
+	uint8_t max_stages;
+	bool first_order;
+	bool notch;
+
+	float alpha;
+	float q;
+	float dT;
 
+	float data[];
 };
 
-void lpfilter_construct_single_biquad(struct lpfilter_biquad *b, float cutoff, float dT, float q, uint8_t width)
+static inline float *lpfilter_stage(struct lpfilter_state *filter, int stage)
 {
-	float f = 1.0f / tanf((float)M_PI*cutoff*dT);
+	return filter->data + filter->lanes * (1 + stage * LPFILTER_STAGE_ARRAYS);
+}
 
-	// Skipping calculation of b1 and b2, since this only going to do Butterworth.
-	// These terms are optimized away in the actual filtering calculation.
-	b->b0 = 1.0f / (1.0f + q*f + f*f);
-	b->a1 = 2.0f * (f*f - 1.0f) * b->b0;
-	b->a2 = -(1.0f - q*f + f*f) * b->b0;
+static inline float *lpfilter_centers(struct lpfilter_state *filter)
+{
+	return lpfilter_stage(filter, filter->max_stages);
+}
+
+/**
+ * Allocate a filter, or check an existing one can be reused.
+ * \param[in,out] filter_ptr The filter
+ * \param[in] width Number of axes filtered
+ * \param[in] max_stages Biquad stages to make room for
+ * \param[in] notch Whether this is a notch filter
+ */
+static struct lpfilter_state *lpfilter_alloc(lpfilter_state_t *filter_ptr,
+		uint8_t width, uint8_t max_stages, bool notch)
+{
+	if (!filter_ptr) {
+		// Whyyyyyyy?
+		PIOS_Assert(0);
+	}
 
-	b->s = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad_state)*width);
-	if(!b->s)
+	if (width == 0 || width > MAX_FILTER_WIDTH)
 		PIOS_Assert(0);
 
-	memset((void*)b->s, 0, sizeof(struct lpfilter_biquad_state)*width);
+	if (!*filter_ptr) {
+		uint8_t lanes = (width + LPFILTER_VEC_LANES - 1) &
+			~(LPFILTER_VEC_LANES - 1);
+		size_t floats = lanes * (2 + max_stages * LPFILTER_STAGE_ARRAYS);
+		size_t size = sizeof(struct lpfilter_state) + floats * sizeof(float);
+
+		*filter_ptr = PIOS_malloc_no_dma(size);
+		if (!*filter_ptr)
+			PIOS_Assert(0);
+
+		memset(*filter_ptr, 0, size);
+
+		(*filter_ptr)->width = width;
+		(*filter_ptr)->lanes = lanes;
+		(*filter_ptr)->max_stages = max_stages;
+		(*filter_ptr)->notch = notch;
+	}
+
+	struct lpfilter_state *filter = *filter_ptr;
+
+	if (filter->width != width || filter->notch != notch) {
+		// We can't free memory, so if some caller keeps tossing varying
+		// filter widths while updating an already allocated filter, go fail.
+		PIOS_Assert(0);
+	}
+
+	return filter;
 }
 
-void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, int o, uint8_t width)
+/**
+ * Set the coefficients of one lane of a biquad stage.  a1 and a2 are
+ * stored negated, so that the stage only adds.
+ */
+static void lpfilter_set_biquad(struct lpfilter_state *filter, int stage,
+		int lane, float b0, float b1, float b2, float a1, float a2)
+{
+	float *s = lpfilter_stage(filter, stage);
+	int lanes = filter->lanes;
+
+	s[LPFILTER_B0 * lanes + lane] = b0;
+	s[LPFILTER_B1 * lanes + lane] = b1;
+	s[LPFILTER_B2 * lanes + lane] = b2;
+	s[LPFILTER_A1 * lanes + lane] = a1;
+	s[LPFILTER_A2 * lanes + lane] = a2;
+}
+
+static void lpfilter_construct_biquads(struct lpfilter_state *filt, float cutoff, float dT, int o)
 {
 	// Amount of biquad filters needed.
 	int len = o >> 1;
@@ -113,65 +258,184 @@ void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, i
 		addr += i >> 1;
 	}
 
-	// Create all necessary biquads and allocate, too, if not yet done so.
+	float f = 1.0f / tanf((float)M_PI*cutoff*dT);
+
 	for(int i = 0; i < len; i++)
 	{
-		if(!filt->biquad[i]) {
-			filt->biquad[i] = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad));
-			if(!filt->biquad[i])
-				PIOS_Assert(0);
-		}
-		lpfilter_construct_single_biquad(filt->biquad[i], cutoff, dT, lpfilter_butterworth_factors[addr+i], width);
+		float q = lpfilter_butterworth_factors[addr+i];
+
+		// Butterworth lowpass, so b1 = 2 * b0 and b2 = b0
+		float b0 = 1.0f / (1.0f + q*f + f*f);
+		float a1 = 2.0f * (f*f - 1.0f) * b0;
+		float a2 = -(1.0f - q*f + f*f) * b0;
+
+		for (int lane = 0; lane < filt->lanes; lane++)
+			lpfilter_set_biquad(filt, i, lane, b0, 2.0f * b0, b0, a1, a2);
 	}
+
+	filt->stages = len;
 }
 
 void lpfilter_create(lpfilter_state_t *filter_ptr, float cutoff, float dT, uint8_t order, uint8_t width)
 {
-	if(!filter_ptr) {
-		// Whyyyyyyy?
-		PIOS_Assert(0);
-	}
-
-	if(!*filter_ptr) {
-		*filter_ptr = PIOS_malloc_no_dma(sizeof(struct lpfilter_state));
-		if(!*filter_ptr)
-			PIOS_Assert(0);
-		memset(*filter_ptr, 0, sizeof(struct lpfilter_state));
-	}
-
-	lpfilter_state_t filter = *filter_ptr;
+	struct lpfilter_state *filter = lpfilter_alloc(filter_ptr, width,
+			LPFILTER_MAX_BIQUADS, false);
 
-	if((filter->width != 0 && filter->width != width) || (width > MAX_FILTER_WIDTH)) {
-		// We can't free memory, so if some caller keeps tossing varying
-		// filter widths while updating an already allocated filter, go fail.
-		PIOS_Assert(0);
-	}
+	// Start again from rest
+	memset(filter->data, 0, filter->lanes * (1 + filter->max_stages *
+				LPFILTER_STAGE_ARRAYS) * sizeof(float));
 
 	// Clamp order count. If zero, this bypasses the filter.
 	if(order == 0) {
 		filter->order = 0;
+		filter->stages = 0;
+		filter->first_order = false;
 		return;
 	} else if(order > 8) order = 8;
 
-	if(order & 0x1) {
-		// Filter is odd, allocate the first order filter.
-		if(!filter->first_order) {
-			filter->first_order = PIOS_malloc_no_dma(sizeof(struct lpfilter_first_order));
-			if(!filter->first_order)
-				PIOS_Assert(0);
+	// Filter is odd, so needs the first order filter.
+	filter->first_order = order & 0x1;
+	filter->alpha = expf(-2.0f * (float)(M_PI) * cutoff * dT);
 
-			filter->first_order->prev = PIOS_malloc_no_dma(sizeof(float)*width);
-			if(!filter->first_order->prev)
-				PIOS_Assert(0);
-		}
+	filter->order = order;
+	lpfilter_construct_biquads(filter, cutoff, dT, order);
+}
+
+/**
+ * Set up a notch filter, or update an existing one.
+ * \param[in,out] filter_ptr The filter
+ * \param[in] center Frequency to reject, in Hz; zero or less bypasses it
+ * until a notch is placed by lpfilter_notch_set or lpfilter_notch_track
+ * \param[in] q Quality factor; the width of the notch is center / q
+ * \param[in] dT Sample period, in seconds
+ * \param[in] width Number of axes filtered
+ */
+void lpfilter_notch_create(lpfilter_state_t *filter_ptr, float center, float q, float dT, uint8_t width)
+{
+	struct lpfilter_state *filter = lpfilter_alloc(filter_ptr, width, 1, true);
+
+	memset(filter->data, 0, filter->lanes * (2 + LPFILTER_STAGE_ARRAYS) *
+			sizeof(float));
+
+	filter->q = q;
+	filter->dT = dT;
+	filter->first_order = false;
 
-		filter->first_order->alpha = expf(-2.0f * (float)(M_PI) * cutoff * dT);
-		memset((void*)filter->first_order->prev, 0, sizeof(float)*width);
+	filter->stages = 0;
+
+	if (center <= 0 || q <= 0)
+		return;
+
+	for (int axis = 0; axis < filter->width; axis++)
+		lpfilter_notch_set(filter, axis, center);
+}
+
+/**
+ * Move the notch of one axis, keeping the filter state.
+ * \param[in] filter The notch filter
+ * \param[in] axis Axis to move the notch of
+ * \param[in] center Frequency to reject, in Hz
+ */
+void lpfilter_notch_set(lpfilter_state_t filter, uint8_t axis, float center)
+{
+	if (!filter || !filter->notch || filter->q <= 0)
+		return;
+
+	if (axis >= filter->width)
+		PIOS_Assert(0);
+
+	if (!filter->stages) {
+		// Was bypassed; let the other axes through untouched
+		for (int lane = 0; lane < filter->lanes; lane++)
+			lpfilter_set_biquad(filter, 0, lane, 1, 0, 0, 0, 0);
+
+		filter->stages = 1;
 	}
 
-	filter->order = order;
-	filter->width = width;
-	lpfilter_construct_biquads(filter, cutoff, dT, order, width);
+	// Keep clear of DC and Nyquist, where the notch degenerates
+	float nyquist = 0.5f / filter->dT;
+	center = bound_min_max(center, 0.02f * nyquist, 0.95f * nyquist);
+
+	float w0 = 2.0f * (float)M_PI * center * filter->dT;
+	float cs = cosf(w0);
+	float alpha = sinf(w0) / (2.0f * filter->q);
+	float a0 = 1.0f + alpha;
+
+	lpfilter_set_biquad(filter, 0, axis,
+			1.0f / a0, -2.0f * cs / a0, 1.0f / a0,
+			2.0f * cs / a0, -(1.0f - alpha) / a0);
+
+	lpfilter_centers(filter)[axis] = center;
+}
+
+/**
+ * Follow the strongest vibration in a spectrum with the notch of one axis.
+ * The notch only moves for a peak that stands well clear of the rest of
+ * the range, and then only part of the way, so that it doesn't chase
+ * noise.
+ * \param[in] filter The notch filter
+ * \param[in] axis Axis the spectrum is of
+ * \param[in] spectrum Magnitude of each frequency bin
+ * \param[in] bins Number of bins
+ * \param[in] bin_hz Width of a bin, in Hz
+ * \param[in] min_hz Lowest frequency to look for a peak at
+ * \param[in] max_hz Highest frequency to look for a peak at
+ * \return The frequency now rejected, or 0 if no notch is placed yet
+ */
+float lpfilter_notch_track(lpfilter_state_t filter, uint8_t axis,
+		const float *spectrum, uint16_t bins, float bin_hz,
+		float min_hz, float max_hz)
+{
+	if (!filter || !filter->notch || axis >= filter->width)
+		return 0;
+
+	float center = lpfilter_centers(filter)[axis];
+
+	int lo = ceilf(min_hz / bin_hz);
+	int hi = floorf(max_hz / bin_hz);
+
+	if (lo < 1)
+		lo = 1;
+	if (hi > bins - 1)
+		hi = bins - 1;
+	if (hi - lo < 2)
+		return center;
+
+	int peak = lo;
+	float sum = 0;
+
+	for (int i = lo; i <= hi; i++) {
+		sum += spectrum[i];
+
+		if (spectrum[i] > spectrum[peak])
+			peak = i;
+	}
+
+	if (spectrum[peak] < LPFILTER_NOTCH_PEAK_RATIO * sum / (hi - lo + 1))
+		return center;
+
+	// Interpolate between bins by fitting a parabola to the peak
+	float offset = 0;
+
+	if (peak > lo && peak < hi) {
+		float a = spectrum[peak - 1];
+		float b = spectrum[peak];
+		float c = spectrum[peak + 1];
+		float d = a - 2.0f * b + c;
+
+		if (d < 0)
+			offset = 0.5f * (a - c) / d;
+	}
+
+	float freq = (peak + offset) * bin_hz;
+
+	// A notch that isn't placed yet goes straight to the peak
+	if (center > 0)
+		freq = center + LPFILTER_NOTCH_SMOOTHING * (freq - center);
+
+	lpfilter_notch_set(filter, axis, freq);
+
+	return lpfilter_centers(filter)[axis];
 }
 
 float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
@@ -183,33 +447,28 @@ float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
 		PIOS_Assert(0);
 	}
 
-	int order = filter->order;
-
-	// Order at zero means bypass.
-	if(!order)
+	// Nothing to do means bypass.
+	if (!filter->first_order && !filter->stages)
 		return sample;
 
-	if(order & 0x1) {
+	int lanes = filter->lanes;
+
+	if (filter->first_order) {
 		// Odd order filter
-		filter->first_order->prev[axis] *= filter->first_order->alpha;
-		filter->first_order->prev[axis] += (1 - filter->first_order->alpha) * sample;
-		sample = filter->first_order->prev[axis];
+		filter->data[axis] *= filter->alpha;
+		filter->data[axis] += (1 - filter->alpha) * sample;
+		sample = filter->data[axis];
 	}
 
-	// Run all generated biquads.
-	order >>= 1;
-	for(int i = 0; i < order; i++)
-	{
-		struct lpfilter_biquad *b = filter->biquad[i];
-		struct lpfilter_biquad_state *s = &b->s[axis];
+	for (int i = 0; i < filter->stages; i++) {
+		float *s = lpfilter_stage(filter, i) + axis;
 
-		float y = b->b0 * (sample + 2.0f * s->x1 + s->x2) + b->a1 * s->y1 + b->a2 * s->y2;
+		float y = s[LPFILTER_B0 * lanes] * sample + s[LPFILTER_Z1 * lanes];
 
-		s->y2 = s->y1;
-		s->y1 = y;
-
-		s->x2 = s->x1;
-		s->x1 = sample;
+		s[LPFILTER_Z1 * lanes] = s[LPFILTER_B1 * lanes] * sample +
+			s[LPFILTER_Z2 * lanes] + s[LPFILTER_A1 * lanes] * y;
+		s[LPFILTER_Z2 * lanes] = s[LPFILTER_B2 * lanes] * sample +
+			s[LPFILTER_A2 * lanes] * y;
 
 		sample = y;
 	}
@@ -217,43 +476,73 @@ float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
 	return sample;
 }
 
-void lpfilter_run(lpfilter_state_t filter, float *sample)
+/**
+ * Run the stages of a filter over a set of samples, a vector at a time.
+ * \param[in] filter The filter
+ * \param[in,out] x Samples, one per axis
+ */
+static void lpfilter_run_lanes(struct lpfilter_state *filter, float *x)
 {
-	if(!filter) return;
-	int order = filter->order;
-
-	// Order at zero means bypass.
-	if(order == 0) return;
-
-	if(order & 0x1) {
-		// Odd order filter
-		for(int i = 0; i < filter->width; i++)
-		{
-			filter->first_order->prev[i] *= filter->first_order->alpha;
-			filter->first_order->prev[i] += (1 - filter->first_order->alpha) * sample[i];
-			sample[i] = filter->first_order->prev[i];
+	// Everything the loop needs is fetched up front; the compiler can't
+	// tell the state stores don't touch these
+	const int lanes = filter->lanes;
+	const int width = filter->width;
+	const int stages = filter->stages;
+	const bool first_order = filter->first_order;
+	const lpfilter_vec alpha = lpfilter_splat(filter->alpha);
+	const lpfilter_vec beta = lpfilter_splat(1.0f - filter->alpha);
+	float * const prev = filter->data;
+	float * const biquads = lpfilter_stage(filter, 0);
+
+	for (int v = 0; v < lanes; v += LPFILTER_VEC_LANES) {
+		// The last vector may only be partly used
+		int n = width - v;
+		lpfilter_vec sample;
+
+		if (n >= LPFILTER_VEC_LANES)
+			sample = lpfilter_load(x + v);
+		else
+			sample = lpfilter_load_partial(x + v, n);
+
+		if (first_order) {
+			sample = lpfilter_load(prev + v) * alpha + beta * sample;
+			lpfilter_store(prev + v, sample);
 		}
-	}
 
-	// Run all generated biquads.
-	order >>= 1;
-	for(int i = 0; i < order; i++)
-	{
-		struct lpfilter_biquad *b = filter->biquad[i];
+		// Biquads, in transposed direct form II
+		float *s = biquads + v;
 
-		for(int j = 0; j < filter->width; j++)
-		{
-			struct lpfilter_biquad_state *s = &b->s[j];
+		for (int i = 0; i < stages; i++, s += lanes * LPFILTER_STAGE_ARRAYS) {
+			lpfilter_vec z1 = lpfilter_load(s + LPFILTER_Z1 * lanes);
+			lpfilter_vec z2 = lpfilter_load(s + LPFILTER_Z2 * lanes);
 
-			float y = b->b0 * (sample[j] + 2.0f * s->x1 + s->x2) + b->a1 * s->y1 + b->a2 * s->y2;
+			lpfilter_vec y = lpfilter_load(s + LPFILTER_B0 * lanes) * sample + z1;
 
-			s->y2 = s->y1;
-			s->y1 = y;
+			z1 = lpfilter_load(s + LPFILTER_B1 * lanes) * sample + z2 +
+				lpfilter_load(s + LPFILTER_A1 * lanes) * y;
+			z2 = lpfilter_load(s + LPFILTER_B2 * lanes) * sample +
+				lpfilter_load(s + LPFILTER_A2 * lanes) * y;
 
-			s->x2 = s->x1;
-			s->x1 = sample[j];
+			lpfilter_store(s + LPFILTER_Z1 * lanes, z1);
+			lpfilter_store(s + LPFILTER_Z2 * lanes, z2);
 
-			sample[j] = y;
+			sample = y;
 		}
+
+		if (n >= LPFILTER_VEC_LANES)
+			lpfilter_store(x + v, sample);
+		else
+			lpfilter_store_partial(x + v, sample, n);
 	}
 }
+
+void lpfilter_run(lpfilter_state_t filter, float *sample)
+{
+	if(!filter) return;
+
+	// Nothing to do means bypass.
+	if (!filter->first_order && !filter->stages)
+		return;
+
+	lpfilter_run_lanes(filter, sample);
+}
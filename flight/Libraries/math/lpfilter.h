@@ -36,4 +36,10 @@ void lpfilter_create(lpfilter_state_t *filter_ptr, float cutoff, float dT, uint8
 float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample);
 void lpfilter_run(lpfilter_state_t filter, float *sample);
 
+void lpfilter_notch_create(lpfilter_state_t *filter_ptr, float center, float q, float dT, uint8_t width);
+void lpfilter_notch_set(lpfilter_state_t filter, uint8_t axis, float center);
+float lpfilter_notch_track(lpfilter_state_t filter, uint8_t axis,
+		const float *spectrum, uint16_t bins, float bin_hz,
+		float min_hz, float max_hz);
+
 #endif // FILTER_H
@@ -0,0 +1,221 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath Filtering support libraries
+ * @{
+ *
+ * @file       spectrum.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Real FFT and magnitude spectra
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdint.h>
+#include <math.h>
+#include "spectrum.h"
+
+/**
+ * Apply a Hann window to a block of samples.
+ * \param[in,out] data The samples
+ * \param[in] n Number of samples
+ */
+void spectrum_window_hann(float *data, uint16_t n)
+{
+	float step = 2.0f * (float)M_PI / (n - 1);
+
+	for (uint16_t i = 0; i < n; i++)
+		data[i] *= 0.5f - 0.5f * cosf(step * i);
+}
+
+/**
+ * In place radix-2 FFT of interleaved complex data.
+ * \param[in,out] data m complex values, real part first
+ * \param[in] m Number of values; a power of two
+ */
+static void fft_complex(float *data, uint16_t m)
+{
+	// Bit reversed reordering
+	for (uint16_t i = 1, j = 0; i < m; i++) {
+		uint16_t bit = m >> 1;
+
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if (i < j) {
+			float re = data[2 * i], im = data[2 * i + 1];
+
+			data[2 * i] = data[2 * j];
+			data[2 * i + 1] = data[2 * j + 1];
+			data[2 * j] = re;
+			data[2 * j + 1] = im;
+		}
+	}
+
+	// Butterflies; each twiddle factor is computed once per stage
+	for (uint16_t len = 2; len <= m; len <<= 1) {
+		uint16_t half = len >> 1;
+		float step = -2.0f * (float)M_PI / len;
+
+		for (uint16_t k = 0; k < half; k++) {
+			float wr = cosf(step * k);
+			float wi = sinf(step * k);
+
+			for (uint16_t i = k; i < m; i += len) {
+				float *a = &data[2 * i];
+				float *b = &data[2 * (i + half)];
+
+				float tr = b[0] * wr - b[1] * wi;
+				float ti = b[0] * wi + b[1] * wr;
+
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+}
+
+/**
+ * In place FFT of real samples, as a complex FFT of half the length.
+ *
+ * On return data[2k], data[2k+1] are the real and imaginary parts of bin k,
+ * for 0 < k < n/2. Bins 0 and n/2 are real; they are in data[0] and
+ * data[1].
+ * \param[in,out] data The samples, then the transform
+ * \param[in] n Number of samples; a power of two, at least 4
+ */
+void spectrum_rfft(float *data, uint16_t n)
+{
+	uint16_t m = n / 2;
+
+	// Even samples are the real parts, odd the imaginary ones
+	fft_complex(data, m);
+
+	float z0r = data[0], z0i = data[1];
+
+	data[0] = z0r + z0i;
+	data[1] = z0r - z0i;
+
+	// Untangle the transforms of the even and odd samples, a bin and its
+	// mirror at a time
+	float step = -2.0f * (float)M_PI / n;
+
+	for (uint16_t k = 1; k <= m / 2; k++) {
+		uint16_t j = m - k;
+
+		float ar = data[2 * k], ai = data[2 * k + 1];
+		float br = data[2 * j], bi = data[2 * j + 1];
+
+		float evr = 0.5f * (ar + br);
+		float evi = 0.5f * (ai - bi);
+		float odr = 0.5f * (ai + bi);
+		float odi = -0.5f * (ar - br);
+
+		float wr = cosf(step * k);
+		float wi = sinf(step * k);
+
+		float tr = odr * wr - odi * wi;
+		float ti = odr * wi + odi * wr;
+
+		data[2 * k] = evr + tr;
+		data[2 * k + 1] = evi + ti;
+		data[2 * j] = evr - tr;
+		data[2 * j + 1] = ti - evi;
+	}
+}
+
+/**
+ * Add the magnitude spectrum of a transform to a running sum.
+ *
+ * Magnitudes are scaled to the amplitude of a sinusoid in the samples,
+ * assuming they were Hann windowed.
+ * \param[in] fft Output of spectrum_rfft
+ * \param[in] n Number of samples transformed
+ * \param[in,out] magnitude n/2 bins, from DC up to just below Nyquist
+ */
+void spectrum_accumulate(const float *fft, uint16_t n, float *magnitude)
+{
+	// 2/n for a one sided spectrum, and 2 for the Hann window's gain
+	float scale = 4.0f / n;
+
+	magnitude[0] += 0.5f * scale * fabsf(fft[0]);
+
+	for (uint16_t k = 1; k < n / 2; k++)
+		magnitude[k] += scale * sqrtf(fft[2 * k] * fft[2 * k] +
+				fft[2 * k + 1] * fft[2 * k + 1]);
+}
+
+/**
+ * Find the strongest peak in a range of a magnitude spectrum, interpolating
+ * between bins.
+ * \param[in] magnitude The spectrum
+ * \param[in] bins Number of bins
+ * \param[in] bin_hz Width of a bin, in Hz
+ * \param[in] min_hz Lowest frequency to look at
+ * \param[in] max_hz Highest frequency to look at
+ * \param[out] peak_magnitude Magnitude of the peak bin, if not NULL
+ * \return The frequency of the peak, or 0 if the range is empty
+ */
+float spectrum_peak(const float *magnitude, uint16_t bins, float bin_hz,
+		float min_hz, float max_hz, float *peak_magnitude)
+{
+	int lo = ceilf(min_hz / bin_hz);
+	int hi = floorf(max_hz / bin_hz);
+
+	if (lo < 1)
+		lo = 1;
+	if (hi > bins - 2)
+		hi = bins - 2;
+
+	if (peak_magnitude)
+		*peak_magnitude = 0;
+
+	if (hi < lo)
+		return 0;
+
+	int best = lo;
+
+	for (int k = lo + 1; k <= hi; k++) {
+		if (magnitude[k] > magnitude[best])
+			best = k;
+	}
+
+	if (peak_magnitude)
+		*peak_magnitude = magnitude[best];
+
+	// Fit a parabola through the peak and its neighbours
+	float l = magnitude[best - 1];
+	float c = magnitude[best];
+	float r = magnitude[best + 1];
+	float denom = l - 2.0f * c + r;
+	float offset = 0;
+
+	if (denom < 0)
+		offset = 0.5f * (l - r) / denom;
+
+	return (best + offset) * bin_hz;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath Filtering support libraries
+ * @{
+ *
+ * @file       spectrum.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Real FFT and magnitude spectra
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+
+void spectrum_window_hann(float *data, uint16_t n);
+void spectrum_rfft(float *data, uint16_t n);
+void spectrum_accumulate(const float *fft, uint16_t n, float *magnitude);
+float spectrum_peak(const float *magnitude, uint16_t bins, float bin_hz,
+		float min_hz, float max_hz, float *peak_magnitude);
+
+#endif /* SPECTRUM_H */
+
+/**
+ * @}
+ * @}
+ */
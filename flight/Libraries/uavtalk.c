@@ -367,13 +367,14 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
 	case UAVTALK_STATE_DATA:
 
-		// update the CRC
-		iproc->cs = PIOS_CRC_updateByte(iproc->cs, rxbyte);
-
 		connection->rxBuffer[iproc->rxCount++] = rxbyte;
 		if (iproc->rxCount < iproc->length)
 			break;
 
+		// update the CRC over the whole payload at once
+		iproc->cs = PIOS_CRC_updateCRC(iproc->cs, connection->rxBuffer,
+				iproc->length);
+
 		iproc->state = UAVTALK_STATE_CS;
 		iproc->rxCount = 0;
 		break;
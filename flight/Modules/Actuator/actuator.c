@@ -52,6 +52,7 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "loop_timing.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -255,7 +256,7 @@ int32_t ActuatorInitialize()
 }
 MODULE_HIPRI_INITCALL(ActuatorInitialize, ActuatorStart);
 
-static float get_curve2_source(ActuatorDesiredData *desired,
+static float get_curve2_source(const ActuatorDesiredData *desired,
 		SystemSettingsAirframeTypeOptions airframe_type,
 		MixerSettingsCurve2SourceOptions source,
 		float throttle_val)
@@ -373,7 +374,7 @@ static void compute_mixer()
 }
 
 static void fill_desired_vector(
-		ActuatorDesiredData *desired,
+		const ActuatorDesiredData *desired,
 		float val1, float val2,
 		float (*cmd_vector)[MIXERSETTINGS_MIXER1VECTOR_NUMELEM])
 {
@@ -616,6 +617,8 @@ static void post_process_scale_and_commit(float *motor_vect,
 	}
 
 	PIOS_Servo_Update();
+
+	loop_timing_outputs_written();
 }
 
 static void normalize_input_data(uint32_t this_systime,
@@ -623,13 +626,10 @@ static void normalize_input_data(uint32_t this_systime,
 		bool *armed, bool *spin_while_armed, bool *stabilize_now)
 {
 	static float manual_throt = -1;
-	float throttle_val = 0;
-	ActuatorDesiredData desired;
+	float throttle_val;
 
 	static FlightStatusData flightStatus;
 
-	ActuatorDesiredGet(&desired);
-
 	if (flight_status_updated) {
 		FlightStatusGet(&flightStatus);
 		flight_status_updated = false;
@@ -647,32 +647,43 @@ static void normalize_input_data(uint32_t this_systime,
 	*armed = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED;
 	*spin_while_armed = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
 
-	if (airframe_type == SYSTEMSETTINGS_AIRFRAMETYPE_HELICP) {
-		// Helis set throttle from manual control's throttle value,
-		// unless in failsafe.
-		// TODO: Audit and determine whether this check is even required
-		if (flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_FAILSAFE) {
-			throttle_val = manual_throt;
+	UAVObjReadView view = { 0 };
+
+	// Mix straight from ActuatorDesired instead of copying it out; if
+	// stabilization updated it underneath us, go around again.
+	do {
+		const ActuatorDesiredData *desired =
+			ActuatorDesiredReadBegin(&view);
+
+		throttle_val = 0;
+
+		if (airframe_type == SYSTEMSETTINGS_AIRFRAMETYPE_HELICP) {
+			// Helis set throttle from manual control's throttle value,
+			// unless in failsafe.
+			// TODO: Audit and determine whether this check is even required
+			if (flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_FAILSAFE) {
+				throttle_val = manual_throt;
+			}
+		} else {
+			throttle_val = desired->Thrust;
 		}
-	} else {
-		throttle_val = desired.Thrust;
-	}
 
-	if (!*armed) {
-		throttle_val = 0.0f;
-	}
+		if (!*armed) {
+			throttle_val = 0.0f;
+		}
 
-	*stabilize_now = throttle_val != 0.0f;
+		float val1 = throttle_val;
 
-	float val1 = throttle_val;
+		//The source for the secondary curve is selectable
+		float val2 = collective_curve(
+				get_curve2_source(desired, airframe_type, curve2_src,
+					throttle_val),
+				curve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
 
-	//The source for the secondary curve is selectable
-	float val2 = collective_curve(
-			get_curve2_source(&desired, airframe_type, curve2_src,
-				throttle_val),
-			curve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+		fill_desired_vector(desired, val1, val2, desired_vect);
+	} while (!ActuatorDesiredReadEnd(&view));
 
-	fill_desired_vector(&desired, val1, val2, desired_vect);
+	*stabilize_now = throttle_val != 0.0f;
 }
 
 static void actuator_settings_update()
@@ -84,6 +84,11 @@
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define FAILSAFE_TIMEOUT_MS 10
 
+//! Entries in the INS state history, for delayed measurements
+#define INS_HISTORY_LEN 16
+//! Time between INS state history entries
+#define INS_HISTORY_PERIOD_US 20000
+
 // Private types
 
 // Track the initialization state of the complementary filter
@@ -133,6 +138,20 @@ struct cfvert {
 	float baro_zero;
 };
 
+//! Where the INS put the vehicle at some recent time
+struct ins_history_entry {
+	uint32_t time_us;
+	float pos[3];
+	float vel[3];
+};
+
+//! Ring of recent INS states, to compare delayed measurements against
+struct ins_history {
+	struct ins_history_entry entries[INS_HISTORY_LEN];
+	uint8_t head;	//!< Next entry to write
+	uint8_t count;	//!< Valid entries
+};
+
 // Private variables
 static struct pios_thread *attitudeTaskHandle;
 
@@ -157,6 +176,7 @@ static const float zeros[3] = {0.0f, 0.0f, 0.0f};
 
 static struct complementary_filter_state complementary_filter_state;
 static struct cfvert cfvert; //!< State information for vertical filter
+static struct ins_history ins_history;
 
 static float dT_expected = 0.001f;	// assume 1KHz if we don't know.
 
@@ -187,6 +207,14 @@ static int32_t setAttitudeINSGPS();
 static int32_t setNavigationINSGPS();
 static void updateNedAccel();
 
+//! Forget the INS state history
+static void ins_history_reset(struct ins_history *hist);
+//! Record the current INS state, if it is time for a new entry
+static void ins_history_record(struct ins_history *hist, uint32_t now_us);
+//! How far the INS state has moved since a delayed measurement was taken
+static void ins_history_delta(struct ins_history *hist, uint32_t now_us,
+		uint16_t delay_ms, float dpos[3], float dvel[3]);
+
 //! A low pass filter on the accels which helps with vibration resistance
 static void apply_accel_filter(const float * raw, float * filtered);
 static int32_t getNED(GPSPositionData * gpsPosition, float * NED);
@@ -1086,6 +1114,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	static uint32_t ins_last_time = 0;
 	static uint32_t ins_init_time = 0;
 
+	// Time and state predictions the covariance is behind by
+	static float cov_dT;
+	static uint16_t cov_steps;
+
 	static enum {INS_INIT, INS_WARMUP, INS_RUNNING} ins_state;
 
 	float NED[3] = {0.0f, 0.0f, 0.0f};
@@ -1247,6 +1279,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		ins_last_time = PIOS_DELAY_GetRaw();	
 		ins_init_time = ins_last_time;
 
+		cov_dT = 0;
+		cov_steps = 0;
+		ins_history_reset(&ins_history);
+
 		return 0;
 	} else if (ins_state == INS_INIT)
 		return 0;
@@ -1298,8 +1334,13 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	// Advance the state estimate
 	INSStatePrediction(gyros, &accelsData.x, dT);
 
-	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	uint32_t now_us = PIOS_DELAY_GetuS();
+	ins_history_record(&ins_history, now_us);
+
+	// The covariance only needs advancing as often as configured, and
+	// before each correction (below)
+	cov_dT += dT;
+	cov_steps++;
 
 	if(mag_updated) {
 		sensors |= MAG_SENSORS;
@@ -1376,12 +1417,57 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		NED[2] = -(baroData.Altitude + baro_offset);
 	}
 
+	// Advance the covariance estimate
+	if (sensors || cov_steps >= insSettings.CovarianceDecimation) {
+		INSCovariancePredictionBatch(cov_dT, cov_steps);
+
+		cov_dT = 0;
+		cov_steps = 0;
+	}
+
+	float baro_alt = baroData.Altitude + baro_offset;
+
+	// Measurements that lag the gyros are moved on by as much as the
+	// estimate has moved since they were taken
+	if (outdoor_mode && (sensors & (HORIZ_POS_SENSORS | VERT_POS_SENSORS))) {
+		float dpos[3], dvel[3];
+
+		ins_history_delta(&ins_history, now_us,
+				insSettings.SensorDelay[INSSETTINGS_SENSORDELAY_GPSPOS],
+				dpos, dvel);
+
+		for (int i = 0; i < 3; i++)
+			NED[i] += dpos[i];
+	}
+
+	if (outdoor_mode && (sensors & (HORIZ_VEL_SENSORS | VERT_VEL_SENSORS))) {
+		float dpos[3], dvel[3];
+
+		ins_history_delta(&ins_history, now_us,
+				insSettings.SensorDelay[INSSETTINGS_SENSORDELAY_GPSVEL],
+				dpos, dvel);
+
+		for (int i = 0; i < 3; i++)
+			vel[i] += dvel[i];
+	}
+
+	if (sensors & BARO_SENSOR) {
+		float dpos[3], dvel[3];
+
+		ins_history_delta(&ins_history, now_us,
+				insSettings.SensorDelay[INSSETTINGS_SENSORDELAY_BARO],
+				dpos, dvel);
+
+		// Altitude is up, the state down
+		baro_alt -= dpos[2];
+	}
+
 	/*
 	 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
 	 * although probably should occur within INS itself
 	 */
 	if (sensors)
-		INSCorrection(&magData.x, NED, vel, ( baroData.Altitude + baro_offset ), sensors);
+		INSCorrection(&magData.x, NED, vel, baro_alt, sensors);
 
 	// Export the state and variance for monitoring the EKF
 	INSStateData state;
@@ -1451,6 +1537,97 @@ static void apply_accel_filter(const float * raw, float * filtered)
 	}
 }
 
+/**
+ * Forget the INS state history, as when the INS is reinitialized.
+ * @param[in] hist the history
+ */
+static void ins_history_reset(struct ins_history *hist)
+{
+	hist->head = 0;
+	hist->count = 0;
+}
+
+/**
+ * Record the current INS position and velocity, if it has been long
+ * enough since the last entry.
+ * @param[in] hist the history
+ * @param[in] now_us the current time
+ */
+static void ins_history_record(struct ins_history *hist, uint32_t now_us)
+{
+	if (hist->count) {
+		uint8_t last = (hist->head + INS_HISTORY_LEN - 1) % INS_HISTORY_LEN;
+
+		if (now_us - hist->entries[last].time_us < INS_HISTORY_PERIOD_US)
+			return;
+	}
+
+	struct ins_history_entry *entry = &hist->entries[hist->head];
+
+	entry->time_us = now_us;
+	INSGetState(entry->pos, entry->vel, NULL, NULL, NULL);
+
+	hist->head = (hist->head + 1) % INS_HISTORY_LEN;
+	if (hist->count < INS_HISTORY_LEN)
+		hist->count++;
+}
+
+/**
+ * Find how far the INS position and velocity have changed since a
+ * measurement that is delay_ms old was taken. Between entries of the
+ * history the state is interpolated; measurements older than the history
+ * are compared with its oldest entry.
+ * @param[in] hist the history
+ * @param[in] now_us the current time
+ * @param[in] delay_ms the age of the measurement
+ * @param[out] dpos the change in position since then
+ * @param[out] dvel the change in velocity since then
+ */
+static void ins_history_delta(struct ins_history *hist, uint32_t now_us,
+		uint16_t delay_ms, float dpos[3], float dvel[3])
+{
+	for (int i = 0; i < 3; i++)
+		dpos[i] = dvel[i] = 0;
+
+	if (delay_ms == 0 || hist->count == 0)
+		return;
+
+	struct ins_history_entry current = { .time_us = now_us };
+	INSGetState(current.pos, current.vel, NULL, NULL, NULL);
+
+	uint32_t age_us = delay_ms * 1000;
+
+	// Walk back from now to the first entry at least as old as the
+	// measurement, keeping the newer neighbour to interpolate with
+	const struct ins_history_entry *newer = &current;
+	const struct ins_history_entry *older = &current;
+
+	for (int i = 1; i <= hist->count; i++) {
+		newer = older;
+		older = &hist->entries[(hist->head + INS_HISTORY_LEN - i) % INS_HISTORY_LEN];
+
+		if (now_us - older->time_us >= age_us)
+			break;
+	}
+
+	// Fraction of the way from the older entry to the newer one; nothing
+	// is older than the oldest entry, so clamp to that
+	float frac = 0;
+	uint32_t older_age = now_us - older->time_us;
+	uint32_t span = newer->time_us - older->time_us;
+
+	if (older_age > age_us && span)
+		frac = (float) (older_age - age_us) / span;
+
+	for (int i = 0; i < 3; i++) {
+		float then_pos = older->pos[i] + frac * (newer->pos[i] - older->pos[i]);
+		float then_vel = older->vel[i] + frac * (newer->vel[i] - older->vel[i]);
+
+		dpos[i] = current.pos[i] - then_pos;
+		dvel[i] = current.vel[i] - then_vel;
+	}
+}
+
 /**
  * @brief Convert the GPS LLA position into NED coordinates
  * @note this method uses a taylor expansion around the home coordinates
@@ -1484,20 +1661,28 @@ static void updateNedAccel()
 	float accel_ned[3];
 	const float TAU = 0.95f;
 
+	UAVObjReadView view = { 0 };
+
 	// Collect downsampled attitude data
-	AccelsData accels;
-	AccelsGet(&accels);		
-	accel[0] = accels.x;
-	accel[1] = accels.y;
-	accel[2] = accels.z;
-	
+	do {
+		const AccelsData *accels = AccelsReadBegin(&view);
+
+		accel[0] = accels->x;
+		accel[1] = accels->y;
+		accel[2] = accels->z;
+	} while (!AccelsReadEnd(&view));
+
 	//rotate avg accels into earth frame and store it
-	AttitudeActualData attitudeActual;
-	AttitudeActualGet(&attitudeActual);
-	q[0]=attitudeActual.q1;
-	q[1]=attitudeActual.q2;
-	q[2]=attitudeActual.q3;
-	q[3]=attitudeActual.q4;
+	do {
+		const AttitudeActualData *attitudeActual =
+			AttitudeActualReadBegin(&view);
+
+		q[0] = attitudeActual->q1;
+		q[1] = attitudeActual->q2;
+		q[2] = attitudeActual->q3;
+		q[3] = attitudeActual->q4;
+	} while (!AttitudeActualReadEnd(&view));
+
 	Quaternion2R(q, Rbe);
 	for (uint8_t i = 0; i < 3; i++) {
 		accel_ned[i] = 0;
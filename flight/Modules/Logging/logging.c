@@ -106,6 +106,7 @@ static void updateSettings();
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
+static uint32_t dropped_bytes;
 static bool destination_onboard_flash;
 
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
@@ -231,6 +232,8 @@ static void loggingTask(void *parameters)
 
 	LoggingStatsGet(&loggingData);
 	loggingData.BytesLogged = 0;
+	loggingData.BytesDropped = 0;
+	loggingData.BufferHighWater = 0;
 	
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 	if (destination_onboard_flash) {
@@ -355,6 +358,18 @@ static void loggingTask(void *parameters)
 				PIOS_Thread_Sleep_Until(&now, LOGGING_PERIOD_MS);
 
 				LoggingStatsBytesLoggedSet(&written_bytes);
+				LoggingStatsBytesDroppedSet(&dropped_bytes);
+
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+				if (destination_onboard_flash) {
+					int32_t high_water = PIOS_STREAMFS_BufferHighWater(logging_com_id);
+
+					if (high_water >= 0) {
+						uint32_t buffer_high_water = high_water;
+						LoggingStatsBufferHighWaterSet(&buffer_high_water);
+					}
+				}
+#endif
 
 				now = PIOS_Thread_Systime();
 			}
@@ -468,8 +483,10 @@ static int32_t send_data_nonblock(void *ctx, uint8_t *data, int32_t length)
 {
 	(void) ctx;
 
-	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0)
+	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0) {
+		dropped_bytes += length;
 		return -1;
+	}
 
 	written_bytes += length;
 
@@ -37,6 +37,7 @@
 #include "misc_math.h"
 #include "lpfilter.h"
 #include "sensors.h"
+#include "loop_timing.h"
 
 #if defined(PIOS_INCLUDE_PX4FLOW)
 #include "pios_px4flow_priv.h"
@@ -58,6 +59,7 @@ extern pios_i2c_t external_i2c_adapter_id;
 #include "inssettings.h"
 #include "magnetometer.h"
 #include "magbias.h"
+#include "vibrationanalysispeaks.h"
 #include "coordinate_conversions.h"
 
 // Private constants
@@ -94,6 +96,7 @@ static void mag_calibration_prelemari(MagnetometerData *mag);
 static void mag_calibration_fix_length(MagnetometerData *mag);
 
 static void updateTemperatureComp(float temperature, float *temp_bias);
+static void update_gyro_notch();
 static void sensors_settings_update();
 
 // Private variables
@@ -101,6 +104,7 @@ static INSSettingsData insSettings;
 static AccelsData accelsData;
 
 static volatile bool settings_updated = true;
+static volatile bool peaks_updated = false;
 
 // These values are initialized by settings but can be updated by the attitude algorithm
 static bool bias_correct_gyro = true;
@@ -128,6 +132,10 @@ static enum mag_calibration_algo mag_calibration_algo = MAG_CALIBRATION_PRELEMAR
 static lpfilter_state_t gyro_filter;
 static lpfilter_state_t accel_filter;
 
+//! Optional notch after the gyro lowpass, moved to follow VibrationAnalysisPeaks if tracking
+static lpfilter_state_t gyro_notch;
+static bool gyro_notch_tracking;
+
 /**
  * API for sensor fusion algorithms:
  * Configure(struct pios_queue *gyro, struct pios_queue *accel, struct pios_queue *mag, struct pios_queue *baro)
@@ -150,7 +158,8 @@ int32_t sensors_init(void)
 		|| MagBiasInitialize() == -1 \
 		|| AttitudeSettingsInitialize() == -1 \
 		|| SensorSettingsInitialize() == -1 \
-		|| INSSettingsInitialize() == -1) {
+		|| INSSettingsInitialize() == -1 \
+		|| VibrationAnalysisPeaksInitialize() == -1) {
 
 		return -1;
 	}
@@ -199,6 +208,7 @@ int32_t sensors_init(void)
 	AttitudeSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 	SensorSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 	INSSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
+	VibrationAnalysisPeaksConnectCallbackCtx(UAVObjCbSetFlag, &peaks_updated);
 
 #ifdef PIOS_INCLUDE_SIMSENSORS
 	simsensors_init();
@@ -287,6 +297,7 @@ bool sensors_step()
 		good_runs = 0;
 		test_good_run = false;
 	} else {
+		loop_timing_gyro_sampled();
 		ret = true;
 	}
 
@@ -369,6 +380,11 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 
 	lpfilter_run(gyro_filter, gyros_out);
 
+	if (gyro_notch_tracking && peaks_updated)
+		update_gyro_notch();
+
+	lpfilter_run(gyro_notch, gyros_out);
+
 	GyrosData gyrosData;
 	gyrosData.temperature = gyros->temperature;
 
@@ -665,6 +681,33 @@ static void mag_calibration_fix_length(MagnetometerData *mag)
 	}
 }
 
+/**
+ * Move the gyro notch to the strongest vibration found by the
+ * VibrationAnalysis module. The peaks are in the body frame while the notch
+ * runs on the sensor axes, so the strongest of the three is used for all of
+ * them; the frame vibrates at the same frequencies on every axis.
+ */
+static void update_gyro_notch()
+{
+	peaks_updated = false;
+
+	VibrationAnalysisPeaksData peaks;
+	VibrationAnalysisPeaksGet(&peaks);
+
+	int strongest = 0;
+
+	for (int i = 1; i < 3; i++) {
+		if (peaks.Magnitude[i] > peaks.Magnitude[strongest])
+			strongest = i;
+	}
+
+	if (peaks.Frequency[strongest] <= 0)
+		return;
+
+	for (int i = 0; i < 3; i++)
+		lpfilter_notch_set(gyro_notch, i, peaks.Frequency[strongest]);
+}
+
 /**
  * Locally cache some variables from the AtttitudeSettings object
  */
@@ -747,6 +790,15 @@ static void sensors_settings_update()
 
 	lpfilter_create(&gyro_filter, sensorSettings.LowpassCutoff, gyro_dT, sensorSettings.LowpassOrder, 3);
 	lpfilter_create(&accel_filter, sensorSettings.LowpassCutoff, accel_dT, sensorSettings.LowpassOrder, 3);
+
+	gyro_notch_tracking = sensorSettings.GyroNotchTracking ==
+		SENSORSETTINGS_GYRONOTCHTRACKING_VIBRATIONANALYSIS;
+
+	// Only take the memory for the notch once it is wanted; after that a
+	// center of 0 bypasses it until tracking (if on) places it
+	if (gyro_notch || sensorSettings.GyroNotchCenter > 0 || gyro_notch_tracking)
+		lpfilter_notch_create(&gyro_notch, sensorSettings.GyroNotchCenter,
+				sensorSettings.GyroNotchQ, gyro_dT, 3);
 }
 /**
   * @}
@@ -69,6 +69,7 @@
 
 // Sensors subsystem which runs in this task
 #include "sensors.h"
+#include "loop_timing.h"
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
@@ -221,6 +222,10 @@ int32_t StabilizationInitialize()
 		return -1;
 	}
 
+	if (loop_timing_init() != 0) {
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -386,7 +391,7 @@ static void stabilizationTask(void* parameters)
 	StabilizationDesiredData stabDesired;
 	RateDesiredData rateDesired;
 	AttitudeActualData attitudeActual;
-	GyrosData gyrosData;
+	float gyro_filtered[3];
 	FlightStatusData flightStatus;
 	SystemSettingsAirframeTypeOptions airframe_type;
 
@@ -419,6 +424,8 @@ static void stabilizationTask(void* parameters)
 
 	smoothcontrol_update_dT(rc_smoothing, dT_expected);
 
+	uint32_t period_expected_us = dT_expected * 1000000;
+
 	if (dT_expected < 0.0004f) {
 		// For future 3.2KHz-- 640ms period
 		ident_shift = 8;
@@ -480,7 +487,8 @@ static void stabilizationTask(void* parameters)
 
 		static bool frequency_wrong = false;
 
-		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
+		uint32_t period_us = PIOS_DELAY_DiffuS(timeval);
+		float dT = period_us * 1.0e-6f;
 		timeval = PIOS_DELAY_GetRaw();
 
 		if (iteration < 100) {
@@ -517,7 +525,16 @@ static void stabilizationTask(void* parameters)
 
 		StabilizationDesiredGet(&stabDesired);
 		AttitudeActualGet(&attitudeActual);
-		GyrosGet(&gyrosData);
+
+		UAVObjReadView gyros_view = { 0 };
+
+		do {
+			const GyrosData *gyros = GyrosReadBegin(&gyros_view);
+
+			gyro_filtered[0] = gyros->x;
+			gyro_filtered[1] = gyros->y;
+			gyro_filtered[2] = gyros->z;
+		} while (!GyrosReadEnd(&gyros_view));
 
 		actuatorDesired.Thrust = stabDesired.Thrust;
 
@@ -616,8 +633,6 @@ static void stabilizationTask(void* parameters)
 				&attitudeActual,
 				local_attitude_error, &horizon_rate_fraction);
 
-		float *gyro_filtered = &gyrosData.x;
-
 		/* Maintain a second-order, lower cutof freq variant for
 		 * dynamic flight modes.
 		 */
@@ -1083,6 +1098,12 @@ static void stabilizationTask(void* parameters)
 		// Save dT
 		actuatorDesired.UpdateTime = dT * 1000;
 
+		// The first loops are still settling; keep them out of the
+		// jitter statistics
+		if (iteration >= 100) {
+			loop_timing_loop_done(period_us, period_expected_us);
+		}
+
 		ActuatorDesiredSet(&actuatorDesired);
 
 		if(flightStatus.Armed != FLIGHTSTATUS_ARMED_ARMED ||
@@ -103,6 +103,9 @@ extern annuncdac_dev_t pios_dac_annunciator_id;
 
 #endif
 
+/* How often to erase flash ahead of a settings garbage collection */
+#define SETTINGS_MAINTENANCE_PERIOD_MS 10000
+
 // Private types
 
 /**
@@ -256,6 +259,10 @@ static void systemTask(void *parameters)
 		FlightStatusConnectCallback(configurationUpdatedCb);
 #endif
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+	uint32_t last_maintenance = PIOS_Thread_Systime();
+#endif
+
 	// Main system loop
 	while (1) {
 		int32_t delayTime = processPeriodicUpdates();
@@ -266,6 +273,24 @@ static void systemTask(void *parameters)
 			// If object persistence is updated call the callback
 			objectUpdatedCb(&ev, NULL, NULL, 0);
 		}
+
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+		// Erase flash ahead of the next settings garbage collection,
+		// but never when armed: erasing can stall the processor.  Only
+		// try every so often, so the stall doesn't land right after boot
+		// or on every pass after a collection.  Putting it off is safe:
+		// a save that finds the next arena not yet erased erases it
+		// itself, as it did before.
+		uint8_t armed;
+		FlightStatusArmedGet(&armed);
+		if (armed == FLIGHTSTATUS_ARMED_DISARMED &&
+				PIOS_Thread_Systime() - last_maintenance >=
+					SETTINGS_MAINTENANCE_PERIOD_MS) {
+			extern uintptr_t pios_uavo_settings_fs_id;
+			PIOS_FLASHFS_Maintenance(pios_uavo_settings_fs_id);
+			last_maintenance = PIOS_Thread_Systime();
+		}
+#endif
 	}
 }
 
@@ -869,14 +894,16 @@ static void updateSystemAlarms()
 		AlarmsClear(SYSTEMALARMS_ALARM_EVENTSYSTEM);
 	}
 
+	SystemStatsGet(&stats);
 	if (objStats.lastCallbackErrorID || objStats.lastQueueErrorID || evStats.lastErrorID) {
-		SystemStatsData sysStats;
-		SystemStatsGet(&sysStats);
-		sysStats.EventSystemWarningID = evStats.lastErrorID;
-		sysStats.ObjectManagerCallbackID = objStats.lastCallbackErrorID;
-		sysStats.ObjectManagerQueueID = objStats.lastQueueErrorID;
-		SystemStatsSet(&sysStats);
+		stats.EventSystemWarningID = evStats.lastErrorID;
+		stats.ObjectManagerCallbackID = objStats.lastCallbackErrorID;
+		stats.ObjectManagerQueueID = objStats.lastQueueErrorID;
 	}
+	stats.ObjectManagerLockContentions = objStats.lockContentions;
+	stats.ObjectManagerReadRetries = objStats.lockFreeReadRetries;
+	stats.ObjectManagerEventBacklog = objStats.eventBacklogHighWater;
+	SystemStatsSet(&stats);
 #endif
 }
 
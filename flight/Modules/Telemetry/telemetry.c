@@ -38,11 +38,13 @@
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
 #include "sessionmanaging.h"
+#include "sessionobjecttable.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
 
 #include "pios_hal.h"
+#include "pios_bl_helper.h"
 
 #include <uavtalk.h>
 
@@ -54,6 +56,9 @@
 #define TELEM_QUEUE_SIZE 60
 #endif
 
+/* Where the firmware description has the SHA1 of the UAVO definitions */
+#define FW_DESC_UAVOSHA1_OFFSET 60
+
 #ifndef TELEM_STACK_SIZE
 #define TELEM_STACK_SIZE 624
 #endif
@@ -134,6 +139,8 @@ static uintptr_t getComPort();
 static void session_managing_updated(UAVObjEvent * ev, void *ctx, void *obj,
 		int len);
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
+static void session_object_table_updated(UAVObjEvent * ev, void *ctx,
+		void *obj, int len);
 
 static int32_t fileReqCallback(void *ctx, uint8_t *buf,
                 uint32_t file_id, uint32_t offset, uint32_t len);
@@ -185,7 +192,8 @@ int32_t TelemetryInitialize(void)
 {
 	if (FlightTelemetryStatsInitialize() == -1 ||
 			GCSTelemetryStatsInitialize() == -1 ||
-			SessionManagingInitialize() == -1) {
+			SessionManagingInitialize() == -1 ||
+			SessionObjectTableInitialize() == -1) {
 		return -1;
 	}
 
@@ -206,6 +214,7 @@ int32_t TelemetryInitialize(void)
 			ackCallback, reqCallback, fileReqCallback);
 
 	SessionManagingConnectCallback(session_managing_updated);
+	SessionObjectTableConnectCallback(session_object_table_updated);
 
 	//register the new uavo instance callback function in the uavobjectmanager
 	UAVObjRegisterNewInstanceCB(update_object_instances);
@@ -960,6 +969,70 @@ static void session_managing_updated(UAVObjEvent * ev, void *ctx, void *obj, int
 	}
 }
 
+/**
+ * SessionObjectTable object updated callback
+ *
+ * Answers a request for the object table from FirstIndex on, a page at a
+ * time, so that the GCS learns about every object in a few round trips
+ * rather than one per object.  The session ID the GCS hands out is kept
+ * in SessionManaging, as the per object handshake does.
+ */
+static void session_object_table_updated(UAVObjEvent * ev, void *ctx,
+		void *obj, int len)
+{
+	(void) ctx; (void) obj; (void) len;
+
+	if (ev->event != EV_UNPACKED) {
+		return;
+	}
+
+	/* These are too big for the stack of the telemetry rx task, which
+	 * is where this is called from */
+	static SessionObjectTableData table;
+	static uint8_t description[FW_DESC_UAVOSHA1_OFFSET +
+		SESSIONOBJECTTABLE_UAVOHASH_NUMELEM];
+
+	SessionObjectTableGet(&table);
+
+	uint8_t count = UAVObjCount();
+
+	table.NumberOfObjects = count;
+
+	for (uint8_t i = 0; i < SESSIONOBJECTTABLE_OBJECTID_NUMELEM; i++) {
+		uint16_t index = table.FirstIndex + i;
+
+		if (index < count) {
+			table.ObjectID[i] = UAVObjIDByIndex(index);
+			table.ObjectInstances[i] = UAVObjGetNumInstances(
+					UAVObjGetByID(table.ObjectID[i]));
+		} else {
+			table.ObjectID[i] = 0;
+			table.ObjectInstances[i] = 0;
+		}
+	}
+
+	PIOS_BL_HELPER_FLASH_Read_Description(description, sizeof(description));
+	memcpy(table.UAVOHash, description + FW_DESC_UAVOSHA1_OFFSET,
+			SESSIONOBJECTTABLE_UAVOHASH_NUMELEM);
+
+	/* The answer has to be set before anything else is updated: while
+	 * other events are pending, the object manager drops an update a
+	 * callback makes to its own object */
+	SessionObjectTableSet(&table);
+
+	SessionManagingData sessionManaging;
+	SessionManagingGet(&sessionManaging);
+
+	if (sessionManaging.SessionID != table.SessionID) {
+		sessionManaging.SessionID = table.SessionID;
+		sessionManaging.NumberOfObjects = count;
+		sessionManaging.ObjectOfInterestIndex = 0;
+		sessionManaging.ObjectID = 0;
+		sessionManaging.ObjectInstances = 0;
+		SessionManagingSet(&sessionManaging);
+	}
+}
+
 /**
  * New UAVO object instance callback
  * This is called from the uavobjectmanager
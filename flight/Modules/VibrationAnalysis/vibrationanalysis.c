@@ -7,7 +7,8 @@
  *
  * @file       vibrationanalysis.c
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
- * @brief      Gathers data on the accels to estimate vibration
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Computes vibration spectra of the accels or gyros
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -28,22 +29,28 @@
  */
 
 /**
- * Input objects: @ref Accels, @ref VibrationAnalysisSettings
- * Output object: @ref VibrationAnalysisOutput
+ * Input objects: @ref Accels or @ref Gyros, @ref VibrationAnalysisSettings
+ * Output objects: @ref VibrationAnalysisOutput, @ref VibrationAnalysisPeaks
  *
- * This module executes on a timer trigger. When the module is
- * triggered it will update the data of VibrationAnalysiOutput,
- * with the accumulated accelerometer samples. 
+ * The sensor is averaged down to one sample every SampleRate ms, and the
+ * samples are gathered into windows of FFTWindowSize. Each window is Hann
+ * windowed and transformed onboard; the magnitude spectra of Averaging
+ * windows are averaged, then sent as VibrationAnalysisOutput instances of
+ * 16 bins each (one per new sample, so as not to flood telemetry), and the
+ * strongest peak of each axis goes to VibrationAnalysisPeaks.
  */
 
 #include "openpilot.h"
 #include "physical_constants.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "spectrum.h"
 
 #include "accels.h"
+#include "gyros.h"
 #include "modulesettings.h"
 #include "vibrationanalysisoutput.h"
+#include "vibrationanalysispeaks.h"
 #include "vibrationanalysissettings.h"
 
 
@@ -51,24 +58,18 @@
 
 #define MAX_QUEUE_SIZE 2
 
-#define STACK_SIZE_BYTES (200 + 448 + 16 + (2*3*window_size)*0) // The memory requirement grows linearly 
-																				  // with window size. The constant is multiplied
-																				  // by 0 in order to reflect the fact that the
-																				  // malloc'ed memory is not taken from the module 
-																				  // but instead from the heap. Nonetheless, we 
-																				  // can know a priori how much RAM this module 
-																				  // will take.
+#define STACK_SIZE_BYTES (200 + 448 + 16 + 128) // The sample and spectrum buffers are
+                                                // malloc'ed from the heap, and grow
+                                                // with the window size: 16*window_size
+                                                // bytes, or 16kB for 1024 points.
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 #define SETTINGS_THROTTLING_MS 100
 
-#define MAX_ACCEL_RANGE 16                          // Maximum accelerometer resolution in [g]
-#define FLOAT_TO_FIXED (32768/(MAX_ACCEL_RANGE*2)-1) // This is the scaling constant that scales input floats
-#define VIBRATION_ELEMENTS_COUNT 16  // Number of elements per object Instance
+#define VIBRATION_ELEMENTS_COUNT 16  // Number of bins per object Instance
+#define MAX_FIXED_SCALE 1000.0f      // Finest fixed point scale of the sent bins
 
-#define MAX_WINDOW_SIZE 1024
-
-// Comment for larger smaller buffers and much better accuracy. The maximum window size will be allocated.
-#define USE_SINGLE_INSTANCE_BUFFERS 1
+#define ACCELS_RANGE (16 * GRAVITY)  // Largest sample held, in m/s^2
+#define GYROS_RANGE 2000.0f          // Largest sample held, in deg/s
 
 // Uncomment to enable freeing buffer memory if the PIOS_free method does something useful
 // #define PIOS_FREE_IMPLEMENTED 1
@@ -80,22 +81,29 @@ static struct pios_queue *queue;
 static bool module_enabled = false;
 
 static struct VibrationAnalysis_data {
-	uint16_t accels_sum_count;
+	uint16_t sum_count;
 	uint16_t window_size;
-    uint16_t buffers_size;
-	uint16_t instances;
-
-	float accels_data_sum_x;
-	float accels_data_sum_y;
-	float accels_data_sum_z;
-	
-	float accels_static_bias_x; // In all likelyhood, the initial values will be close to 
-	float accels_static_bias_y; // (0,0,-g). In the case where they are not, this will still  
-	float accels_static_bias_z; // converge to the true bias in a few thousand measurements.	
-	
-	int16_t *accel_buffer_x;
-	int16_t *accel_buffer_y;
-	int16_t *accel_buffer_z;
+	uint16_t buffers_size;       // Largest window the buffers hold
+	uint16_t sample_count;
+	uint16_t sample_rate_ms;
+
+	uint8_t source;
+	uint8_t averaging;
+	uint8_t windows;             // Windows accumulated in the spectrum
+
+	bool publishing;
+	uint16_t publish_index;
+	float scale;
+
+	float data_sum[3];
+	float static_bias[3];        // Drifts slowly to the mean, e.g. (0,0,-g)
+	                             // for the accels
+
+	float sample_scale;          // Fixed point scale of the held samples
+	int16_t *samples[3];         // window_size samples of each axis
+	float *fft;                  // window_size floats, shared by the axes as
+	                             // they are transformed one after another
+	float *spectrum[3];          // window_size/2 magnitude bins of each axis
 } *vtd;
 
 
@@ -107,190 +115,172 @@ static void VibrationAnalysisTask(void *parameters);
 *   Because this module can have a big footprint this will ensure we can
 *   reduce it when something fails.
 */
-static void VibrationAnalysisCleanup(void) {
-    // Cleanup allocated memory
-    module_enabled = false;
-
-    // Stop main task
-    if (taskHandle != NULL) {
-        TaskMonitorRemove(task);
-        PIOS_Thread_Delete(taskHandle);
-        taskHandle = NULL;
-    }
+static void VibrationAnalysisCleanup(void)
+{
+	// Cleanup allocated memory
+	module_enabled = false;
+
+	// Stop main task
+	if (taskHandle != NULL) {
+		TaskMonitorRemove(task);
+		PIOS_Thread_Delete(taskHandle);
+		taskHandle = NULL;
+	}
 
 #ifdef PIOS_FREE_IMPLEMENTED
-    // Cleanup
-    if (vtd != NULL) {
-        PIOS_free(vtd);
-        vtd = NULL;        
-    }
-
-    if (vtd->accel_buffer_x != NULL){
-        PIOS_free(vtd->accel_buffer_x);
-        vtd->accel_buffer_x = NULL;
-    }
-    
-    if (vtd->accel_buffer_y != NULL) {
-        PIOS_free(vtd->accel_buffer_y);
-        vtd->accel_buffer_y = NULL;
-
-    }
-
-    if (vtd->accel_buffer_z != NULL) {
-        PIOS_free(vtd->accel_buffer_z);
-        vtd->accel_buffer_z = NULL;
-    }
+	if (vtd != NULL) {
+		for (int i = 0; i < 3; i++) {
+			PIOS_free(vtd->samples[i]);
+			PIOS_free(vtd->spectrum[i]);
+		}
+
+		PIOS_free(vtd->fft);
+		PIOS_free(vtd);
+		vtd = NULL;
+	}
 #endif
+}
+
+/**
+ * Restart acquisition from an empty window and spectrum
+ */
+static void VibrationAnalysisRestart(void)
+{
+	for (int i = 0; i < 3; i++) {
+		vtd->data_sum[i] = 0;
+		memset(vtd->spectrum[i], 0,
+				vtd->window_size / 2 * sizeof(*vtd->spectrum[i]));
+	}
 
+	vtd->sum_count = 0;
+	vtd->sample_count = 0;
+	vtd->windows = 0;
+	vtd->publishing = false;
 }
 
 /**
- * Start the module, called on startup
+ * Start the module, called on startup, and (re)configure it from the
+ * settings
  */
 static int32_t VibrationAnalysisStart(void)
 {
-	
 	if (!module_enabled)
 		return -1;
 
-    //Get the window size
-    uint16_t window_size; // Make a local copy in order to check settings before allocating memory
-    uint16_t instances = 1;
-
-    // Allocate and initialize the static data storage only if module is enabled the first time
-    if (vtd == NULL){
-        vtd = (struct VibrationAnalysis_data *) PIOS_malloc(sizeof(struct VibrationAnalysis_data));
-        if (vtd == NULL) {
-            module_enabled = false;
-            return -1;
-        }
-        
-        // make sure that all struct values are zeroed...
-        memset(vtd, 0, sizeof(struct VibrationAnalysis_data));
-        //... except for Z axis static bias
-        vtd->accels_static_bias_z -= GRAVITY; // [See note in definition of VibrationAnalysis_data structure]
-    }
-
-    VibrationAnalysisSettingsFFTWindowSizeOptions window_size_enum;
-    VibrationAnalysisSettingsFFTWindowSizeGet(&window_size_enum);
-    switch (window_size_enum) {
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_16:
-            window_size = 16;
-            break;
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_64:
-            window_size = 64;
-            break;
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_256:
-            window_size = 256;
-            break;
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_1024:
-            window_size = 1024;
-            break;
-        default:
-            //This represents a serious configuration error. Do not start module.
-            module_enabled = false;
-            return -1;
-            break;
-    }
-
-    // Is the new window size different?
-    // Will happen upon initialization and when the window size changes
-    if (window_size != vtd->window_size) {
-
-        instances = window_size / VIBRATION_ELEMENTS_COUNT;
-
-#ifndef USE_SINGLE_INSTANCE_BUFFERS
-        // Check number of existing instances
-        uint16_t existing_instances = VibrationAnalysisOutputGetNumInstances();
-        if(existing_instances < instances) {
-            //Create missing instances
-            for (int i = existing_instances; i < instances; i++) {
-                uint16_t ret = VibrationAnalysisOutputCreateInstance();
-                if (ret == 0) {
-                    // This fails when it's a metaobject. Not a very helpful test.
-                    module_enabled = false;
-                    return -1;
-                }
-            }
-        }
-
-        // We need at least these instances
-        if (VibrationAnalysisOutputGetNumInstances() < instances) {
-            return -1;
-        }
-#endif
+	// Allocate and initialize the static data storage only if module is enabled the first time
+	if (vtd == NULL) {
+		vtd = (struct VibrationAnalysis_data *) PIOS_malloc(sizeof(struct VibrationAnalysis_data));
+		if (vtd == NULL) {
+			module_enabled = false;
+			return -1;
+		}
+
+		// make sure that all struct values are zeroed...
+		memset(vtd, 0, sizeof(struct VibrationAnalysis_data));
+		//... except for Z axis static bias
+		vtd->static_bias[2] = -GRAVITY;
+	}
 
-#ifdef PIOS_FREE_IMPLEMENTED        
-        // Delete existing buffers
-        if (vtd->accel_buffer_x != NULL)
-            PIOS_free(vtd->accel_buffer_x);
-        if (vtd->accel_buffer_y != NULL)
-            PIOS_free(vtd->accel_buffer_y);
-        if (vtd->accel_buffer_z != NULL)
-            PIOS_free(vtd->accel_buffer_z);
-#endif
+	VibrationAnalysisSettingsData settings;
+	VibrationAnalysisSettingsGet(&settings);
+
+	uint16_t window_size; // Make a local copy in order to check settings before allocating memory
+
+	switch (settings.FFTWindowSize) {
+	case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_16:
+		window_size = 16;
+		break;
+	case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_64:
+		window_size = 64;
+		break;
+	case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_256:
+		window_size = 256;
+		break;
+	case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_1024:
+		window_size = 1024;
+		break;
+	default:
+		//This represents a serious configuration error. Do not start module.
+		module_enabled = false;
+		return -1;
+	}
 
-        // Clear buffers
-        memset(vtd, 0, sizeof(struct VibrationAnalysis_data));
-        vtd->accels_static_bias_z -= GRAVITY; // [See note in definition of VibrationAnalysis_data structure]
+	// Grow the buffers if the window does not fit. Without a working
+	// PIOS_free the old ones are lost, so they are never shrunk.
+	if (window_size > vtd->buffers_size) {
+#ifdef PIOS_FREE_IMPLEMENTED
+		PIOS_free(vtd->fft);
+#endif
+		vtd->fft = PIOS_malloc(window_size * sizeof(*vtd->fft));
+		if (vtd->fft == NULL) {
+			VibrationAnalysisCleanup();
+			return -1;
+		}
 
-        // Now place the window size into the buffer
-        vtd->window_size = window_size;
-        vtd->instances = instances;
-        
-#ifdef USE_SINGLE_INSTANCE_BUFFERS
-        vtd->buffers_size = VIBRATION_ELEMENTS_COUNT; 
-#else
+		for (int i = 0; i < 3; i++) {
+#ifdef PIOS_FREE_IMPLEMENTED
+			PIOS_free(vtd->samples[i]);
+			PIOS_free(vtd->spectrum[i]);
+#endif
+			vtd->samples[i] = PIOS_malloc(window_size * sizeof(*vtd->samples[i]));
+			vtd->spectrum[i] = PIOS_malloc(window_size / 2 * sizeof(*vtd->spectrum[i]));
 
-    #ifdef PIOS_FREE_IMPLEMENTED        
-        vtd->buffers_size = window_size;
-    #else
-        vtd->buffers_size = MAX_WINDOW_SIZE; 
+			if (vtd->samples[i] == NULL || vtd->spectrum[i] == NULL) {
+				VibrationAnalysisCleanup();
+				return -1;
+			}
+		}
 
-    #endif
+		vtd->buffers_size = window_size;
+	}
 
-#endif
+	uint16_t sample_rate_ms = settings.SampleRate > 0 ? settings.SampleRate : 1; //Ensure sampleRate never is 0.
+	uint8_t averaging = settings.Averaging > 0 ? settings.Averaging : 1;
+
+	// Start over if anything changed; partial windows and spectra of the
+	// old configuration mean nothing
+	if (window_size != vtd->window_size || sample_rate_ms != vtd->sample_rate_ms ||
+			averaging != vtd->averaging || settings.Source != vtd->source) {
+		// Listen to the configured sensor (not connected yet the first time)
+		if (vtd->source == VIBRATIONANALYSISSETTINGS_SOURCE_GYROS) {
+			UAVObjDisconnectQueue(GyrosHandle(), queue);
+		} else {
+			UAVObjDisconnectQueue(AccelsHandle(), queue);
+		}
+
+		if (settings.Source == VIBRATIONANALYSISSETTINGS_SOURCE_GYROS) {
+			GyrosConnectQueue(queue);
+		} else {
+			AccelsConnectQueue(queue);
+		}
+
+		if (settings.Source != vtd->source) {
+			vtd->static_bias[0] = 0;
+			vtd->static_bias[1] = 0;
+			vtd->static_bias[2] =
+				(settings.Source == VIBRATIONANALYSISSETTINGS_SOURCE_ACCELS) ? -GRAVITY : 0;
+		}
+
+		// Samples are held as int16, covering the full range of the sensor
+		vtd->sample_scale = INT16_MAX /
+			((settings.Source == VIBRATIONANALYSISSETTINGS_SOURCE_ACCELS) ?
+				ACCELS_RANGE : GYROS_RANGE);
+
+		vtd->window_size = window_size;
+		vtd->sample_rate_ms = sample_rate_ms;
+		vtd->averaging = averaging;
+		vtd->source = settings.Source;
+
+		VibrationAnalysisRestart();
+	}
 
+	// Start main task
+	if (taskHandle == NULL) {
+		taskHandle = PIOS_Thread_Create(VibrationAnalysisTask, "VibrationAnalysis", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+		task = TaskMonitorAdd(TASKINFO_RUNNING_VIBRATIONANALYSIS, taskHandle);
+	}
 
-        //Create new buffers if needed.
-        if (vtd->accel_buffer_x == NULL) {
-            vtd->accel_buffer_x = (int16_t *) PIOS_malloc(vtd->buffers_size*sizeof(typeof(*vtd->accel_buffer_x)));
-            if (vtd->accel_buffer_x == NULL) {
-                VibrationAnalysisCleanup();
-
-                module_enabled = false;
-                return -1;
-            }
-        }
-
-        if (vtd->accel_buffer_y == NULL) {
-            vtd->accel_buffer_y = (int16_t *) PIOS_malloc(vtd->buffers_size*sizeof(typeof(*vtd->accel_buffer_y)));
-            if (vtd->accel_buffer_y == NULL) {
-                VibrationAnalysisCleanup();
-
-                module_enabled = false;
-                return -1;
-            }
-        }
-
-        if (vtd->accel_buffer_z == NULL) {
-            vtd->accel_buffer_z = (int16_t *) PIOS_malloc(vtd->buffers_size*sizeof(typeof(*vtd->accel_buffer_z)));
-            if (vtd->accel_buffer_z == NULL) {
-                VibrationAnalysisCleanup();
-
-                module_enabled = false;
-                return -1;
-            }
-        }
-    }
-    
-    // Start main task
-    if (taskHandle == NULL) {
-        taskHandle = PIOS_Thread_Create(VibrationAnalysisTask, "VibrationAnalysis", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-        task = TaskMonitorAdd(TASKINFO_RUNNING_VIBRATIONANALYSIS, taskHandle);
-    }
-
-    return 0;
+	return 0;
 }
 
 
@@ -300,10 +290,10 @@ static int32_t VibrationAnalysisStart(void)
 static int32_t VibrationAnalysisInitialize(void)
 {
 	if (ModuleSettingsInitialize() == -1) {
-        module_enabled = false;
-        return -1;
-    }
-	
+		module_enabled = false;
+		return -1;
+	}
+
 #ifdef MODULE_VibrationAnalysis_BUILTIN
 	module_enabled = true;
 #else
@@ -315,177 +305,221 @@ static int32_t VibrationAnalysisInitialize(void)
 		module_enabled = false;
 	}
 #endif
-	
+
 	if (!module_enabled) //If module not enabled...
 		return -1;
 
 	// Initialize UAVOs
-	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1) {
-        module_enabled = false;
-        return -1;
-    }
-		
-	// Create object queue
+	if (VibrationAnalysisSettingsInitialize() == -1 ||
+			VibrationAnalysisOutputInitialize() == -1 ||
+			VibrationAnalysisPeaksInitialize() == -1) {
+		module_enabled = false;
+		return -1;
+	}
+
+	// Create object queue; VibrationAnalysisStart connects it to the source
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
-		
+
 	return 0;
-	
 }
 MODULE_INITCALL(VibrationAnalysisInitialize, VibrationAnalysisStart)
 
+/**
+ * Transform the full window and add it to the spectrum; once enough
+ * windows are in, average them, find the peaks and start sending.
+ */
+static void VibrationAnalysisWindowDone(void)
+{
+	uint16_t bins = vtd->window_size / 2;
+
+	for (int i = 0; i < 3; i++) {
+		for (uint16_t k = 0; k < vtd->window_size; k++)
+			vtd->fft[k] = vtd->samples[i][k] / vtd->sample_scale;
+
+		spectrum_window_hann(vtd->fft, vtd->window_size);
+		spectrum_rfft(vtd->fft, vtd->window_size);
+		spectrum_accumulate(vtd->fft, vtd->window_size, vtd->spectrum[i]);
+	}
+
+	if (++vtd->windows < vtd->averaging)
+		return;
+
+	float bin_hz = 1000.0f / (vtd->sample_rate_ms * vtd->window_size);
+	float largest = 0;
+
+	VibrationAnalysisPeaksData peaks;
+	peaks.BinWidth = bin_hz;
+
+	for (int i = 0; i < 3; i++) {
+		for (uint16_t k = 0; k < bins; k++) {
+			vtd->spectrum[i][k] /= vtd->windows;
+
+			if (vtd->spectrum[i][k] > largest)
+				largest = vtd->spectrum[i][k];
+		}
+
+		// Bin 1 still holds what is left of the bias
+		float magnitude;
+		peaks.Frequency[i] = spectrum_peak(vtd->spectrum[i], bins, bin_hz,
+				2 * bin_hz, bins * bin_hz, &magnitude);
+		peaks.Magnitude[i] = magnitude;
+	}
+
+	VibrationAnalysisPeaksSet(&peaks);
+
+	// As fine a fixed point scale as the largest bin allows
+	vtd->scale = MAX_FIXED_SCALE;
+	if (largest * vtd->scale > INT16_MAX)
+		vtd->scale = INT16_MAX / largest;
+
+	vtd->publishing = true;
+	vtd->publish_index = 0;
+}
+
+/**
+ * Send the next 16 bins of the spectrum
+ */
+static void VibrationAnalysisPublish(void)
+{
+	uint16_t bins = vtd->window_size / 2;
+	uint16_t first = vtd->publish_index * VIBRATION_ELEMENTS_COUNT;
+
+	VibrationAnalysisOutputData output;
+	memset(&output, 0, sizeof(output));
+
+	output.scale = vtd->scale;
+	output.samples = bins;
+	output.index = vtd->publish_index;
+
+	for (uint16_t k = 0; k < VIBRATION_ELEMENTS_COUNT && first + k < bins; k++) {
+		output.x[k] = vtd->spectrum[0][first + k] * vtd->scale;
+		output.y[k] = vtd->spectrum[1][first + k] * vtd->scale;
+		output.z[k] = vtd->spectrum[2][first + k] * vtd->scale;
+	}
+
+	VibrationAnalysisOutputInstSet(0, &output);
+	VibrationAnalysisOutputInstUpdated(0);
+
+	vtd->publish_index++;
+
+	if (vtd->publish_index * VIBRATION_ELEMENTS_COUNT >= bins) {
+		// All sent; the next spectrum starts from scratch
+		for (int i = 0; i < 3; i++)
+			memset(vtd->spectrum[i], 0, bins * sizeof(*vtd->spectrum[i]));
+
+		vtd->windows = 0;
+		vtd->publishing = false;
+	}
+}
 
 static void VibrationAnalysisTask(void *parameters)
 {
-    uint32_t lastSysTime;
-    uint32_t lastSettingsUpdateTime;
-    uint8_t runAnalysisFlag = VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF; // By default, turn analysis off
-    uint16_t sampleRate_ms = 100; // Default sample rate of 100ms
-    uint16_t sample_count;
-    
-    UAVObjEvent ev;
-    
-    // Listen for updates.
-    AccelsConnectQueue(queue);
-
-    // Main task loop
-    VibrationAnalysisOutputData vibrationAnalysisOutputData;
-    sample_count = 0;
-    lastSysTime = PIOS_Thread_Systime();
-    lastSettingsUpdateTime = PIOS_Thread_Systime() - SETTINGS_THROTTLING_MS;
-    
-    vibrationAnalysisOutputData.samples = vtd->window_size;
-    vibrationAnalysisOutputData.scale = FLOAT_TO_FIXED;
-
-#ifdef USE_SINGLE_INSTANCE_BUFFERS
-    uint16_t instance_number = 0;
-#endif
+	uint32_t lastSysTime;
+	uint32_t lastSettingsUpdateTime;
+	uint8_t runAnalysisFlag = VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF; // By default, turn analysis off
+
+	UAVObjEvent ev;
+
+	lastSysTime = PIOS_Thread_Systime();
+	lastSettingsUpdateTime = PIOS_Thread_Systime() - SETTINGS_THROTTLING_MS;
+
+	// Main module task, never exit from while loop
+	while (module_enabled) {
+		// Only check settings once every 100ms
+		if (PIOS_Thread_Systime() - lastSettingsUpdateTime > SETTINGS_THROTTLING_MS) {
+			//First check if the analysis is active
+			VibrationAnalysisSettingsTestingStatusGet(&runAnalysisFlag);
+
+			// If analysis is turned off, delay and then loop.
+			if (runAnalysisFlag == VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF) {
+				PIOS_Thread_Sleep(200);
+				continue;
+			}
+
+			//Reconfigure any parameter
+			if (VibrationAnalysisStart() != 0)
+				break;	// Out of memory, or bad settings
+
+			lastSettingsUpdateTime = PIOS_Thread_Systime();
+		}
+
+		// Wait until the sensor object is updated, and never time out
+		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
+			/**
+			 * Accumulate sensor data. The averaging is a crude low pass
+			 * filter ahead of the decimation to the sample rate.
+			 */
+			float data[3];
+
+			if (vtd->source == VIBRATIONANALYSISSETTINGS_SOURCE_GYROS) {
+				GyrosData gyros_data;
+				GyrosGet(&gyros_data);
+
+				data[0] = gyros_data.x;
+				data[1] = gyros_data.y;
+				data[2] = gyros_data.z;
+			} else {
+				AccelsData accels_data;
+				AccelsGet(&accels_data);
+
+				data[0] = accels_data.x;
+				data[1] = accels_data.y;
+				data[2] = accels_data.z;
+			}
+
+			for (int i = 0; i < 3; i++)
+				vtd->data_sum[i] += data[i];
+
+			vtd->sum_count++;
+		}
+
+		// If not enough time has passed, keep accumulating data
+		if (PIOS_Thread_Systime() - lastSysTime < vtd->sample_rate_ms || vtd->sum_count == 0) {
+			continue;
+		}
+
+		lastSysTime = PIOS_Thread_Systime();
+
+		for (int i = 0; i < 3; i++) {
+			//Calculate averaged value
+			float avg = vtd->data_sum[i] / vtd->sum_count;
+
+			//Calculate DC bias
+			float alpha = .005; //Hard-coded to drift very slowly
+			vtd->static_bias[i] = alpha * avg + (1 - alpha) * vtd->static_bias[i];
+
+			// Add averaged value to the window, and remove DC bias.
+			float sample = (avg - vtd->static_bias[i]) * vtd->sample_scale;
+			if (sample > INT16_MAX)
+				sample = INT16_MAX;
+			else if (sample < -INT16_MAX)
+				sample = -INT16_MAX;
+
+			vtd->samples[i][vtd->sample_count] = sample;
+
+			//Reset the accumulator
+			vtd->data_sum[i] = 0;
+		}
+
+		vtd->sum_count = 0;
+
+		// Spread sending the last spectrum over the next window's samples
+		if (vtd->publishing)
+			VibrationAnalysisPublish();
+
+		// Advance sample and process the window when full
+		if (++vtd->sample_count == vtd->window_size) {
+			vtd->sample_count = 0;
+
+			// Only window_size / 32 instances to send, which is done
+			// long before the next window fills; but never mix spectra
+			if (!vtd->publishing)
+				VibrationAnalysisWindowDone();
+		}
+	}
 
-    uint8_t  runningAcquisition = 0;
-
-    // Main module task, never exit from while loop
-    while (module_enabled)
-    {
-
-        // Only check settings once every 100ms and not in the middle of a buffer accumulation to reduce artifacts
-        if (PIOS_Thread_Systime() - lastSettingsUpdateTime > SETTINGS_THROTTLING_MS && runningAcquisition == 0) {
-
-            //First check if the analysis is active
-            VibrationAnalysisSettingsTestingStatusGet(&runAnalysisFlag);
-            
-            // If analysis is turned off, delay and then loop.
-            if (runAnalysisFlag == VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF) {
-                PIOS_Thread_Sleep(200);
-                continue;
-            }
-            // Get sample rate
-            VibrationAnalysisSettingsSampleRateGet(&sampleRate_ms);
-            sampleRate_ms = sampleRate_ms > 0 ? sampleRate_ms : 1; //Ensure sampleRate never is 0.
-            
-            //Reconfigure any parameter
-            VibrationAnalysisStart();
-            
-            vibrationAnalysisOutputData.samples = vtd->window_size;
-
-            lastSettingsUpdateTime = PIOS_Thread_Systime();
-
-            runningAcquisition = 1;
-        }
-        
-
-        // Wait until the Accels object is updated, and never time out
-        if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-            /**
-             * Accumulate accelerometer data. This would be a great place to add a 
-             * high-pass filter, in order to eliminate the DC bias from gravity.
-             * Until then, a DC bias subtraction has been added in the main loop.
-             */
-            
-            AccelsData accels_data;
-            AccelsGet(&accels_data);
-            
-            vtd->accels_data_sum_x += accels_data.x;
-            vtd->accels_data_sum_y += accels_data.y;
-            vtd->accels_data_sum_z += accels_data.z;
-            
-            vtd->accels_sum_count++;
-        }
-        
-        // If not enough time has passed, keep accumulating data
-        if (PIOS_Thread_Systime() - lastSysTime < sampleRate_ms) {
-            continue;
-        }
-        
-        
-        lastSysTime = PIOS_Thread_Systime();
-        
-        //Calculate averaged values
-        float accels_avg_x = vtd->accels_data_sum_x / vtd->accels_sum_count;
-        float accels_avg_y = vtd->accels_data_sum_y / vtd->accels_sum_count;
-        float accels_avg_z = vtd->accels_data_sum_z / vtd->accels_sum_count;
-        
-        //Calculate DC bias
-        float alpha = .005; //Hard-coded to drift very slowly
-        vtd->accels_static_bias_x = alpha*accels_avg_x + (1-alpha)*vtd->accels_static_bias_x;
-        vtd->accels_static_bias_y = alpha*accels_avg_y + (1-alpha)*vtd->accels_static_bias_y;
-        vtd->accels_static_bias_z = alpha*accels_avg_z + (1-alpha)*vtd->accels_static_bias_z;
-        
-        // Add averaged values to the buffer, and remove DC bias.
-        vtd->accel_buffer_x[sample_count] = (accels_avg_x - vtd->accels_static_bias_x)*FLOAT_TO_FIXED;
-        vtd->accel_buffer_y[sample_count] = (accels_avg_y - vtd->accels_static_bias_y)*FLOAT_TO_FIXED;
-        vtd->accel_buffer_z[sample_count] = (accels_avg_z - vtd->accels_static_bias_z)*FLOAT_TO_FIXED;
-        
-        //Reset the accumulators
-        vtd->accels_data_sum_x = 0;
-        vtd->accels_data_sum_y = 0;
-        vtd->accels_data_sum_z = 0;
-        vtd->accels_sum_count = 0;
-
-        // Advance sample and reset when at buffer end
-        sample_count++;
-
-        // Process and dump an instance at a time
-#ifdef USE_SINGLE_INSTANCE_BUFFERS
-        if (sample_count == vtd->buffers_size) {
-            // Dump an instance
-
-            for (uint16_t k = 0; k < VIBRATION_ELEMENTS_COUNT; k++) {
-                vibrationAnalysisOutputData.index = instance_number;
-                vibrationAnalysisOutputData.x[k] = vtd->accel_buffer_x[k];
-                vibrationAnalysisOutputData.y[k] = vtd->accel_buffer_y[k];
-                vibrationAnalysisOutputData.z[k] = vtd->accel_buffer_z[k];
-            }
-            
-            VibrationAnalysisOutputInstSet(0, &vibrationAnalysisOutputData);
-            VibrationAnalysisOutputInstUpdated(0);
-
-            // Increase the instance number or reset it
-            instance_number = (instance_number + 1) % vtd->instances;
-#else
-        // Or process and dump the full window using multiple instances
-        // This will probably introduce less artifacts at the cost of higher memory consumption
-        if (sample_count == vtd->window_size) {
-            for (uint16_t i = 0; i < vtd->instances; i++) {
-                for (uint16_t k = 0; k < VIBRATION_ELEMENTS_COUNT; k++) {
-                    vibrationAnalysisOutputData.index = i;
-                    vibrationAnalysisOutputData.x[k] = vtd->accel_buffer_x[k + VIBRATION_ELEMENTS_COUNT * i];
-                    vibrationAnalysisOutputData.y[k] = vtd->accel_buffer_y[k + VIBRATION_ELEMENTS_COUNT * i];
-                    vibrationAnalysisOutputData.z[k] = vtd->accel_buffer_z[k + VIBRATION_ELEMENTS_COUNT * i];
-                }
-
-                VibrationAnalysisOutputInstSet(i, &vibrationAnalysisOutputData);
-                VibrationAnalysisOutputInstUpdated(i);
-            }
-            
-#endif
-            // Erase buffer
-            memset(vtd->accel_buffer_x, 0, vtd->buffers_size*sizeof(typeof(*(vtd->accel_buffer_x))));
-            memset(vtd->accel_buffer_y, 0, vtd->buffers_size*sizeof(typeof(*(vtd->accel_buffer_y))));
-            memset(vtd->accel_buffer_z, 0, vtd->buffers_size*sizeof(typeof(*(vtd->accel_buffer_z))));
-
-            sample_count = 0;
-            runningAcquisition = 0;
-        }
-    }
+	while (true)
+		PIOS_Thread_Sleep(PIOS_THREAD_TIMEOUT_MAX);
 }
 
 /**
@@ -11,6 +11,11 @@
 
 #include <stdbool.h>
 
+#if defined(FLIGHT_POSIX)
+/* The simulator has memory to spare for the sliced tables */
+#include "uavtalk_crc.h"
+#endif
+
 // CRC lookup table
 static const uint8_t crc_table[256] = {
 	0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
@@ -152,6 +157,9 @@ uint8_t PIOS_CRC_updateByte(uint8_t crc, const uint8_t data)
  */
 uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t* data, int32_t length)
 {
+#if defined(FLIGHT_POSIX)
+	return uavtalk_crc_update(crc, data, length);
+#else
 	// use registers for speed
 	register int32_t len = length;
 	register uint8_t crc8 = crc;
@@ -161,6 +169,7 @@ uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t* data, int32_t length)
 		crc8 = crc_table[crc8 ^ *p++];
 	
 	return crc8;
+#endif
 }
 
 /**
@@ -31,9 +31,17 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memmove */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
+/*
+ * Active slots moved to the next arena by each save while a garbage
+ * collection is in progress.  The collection starts early enough to be
+ * finished, a few slots at a time, before the log fills up.
+ */
+#define LOGFS_GC_SLOTS_PER_SAVE 4
+
 /*
  * Filesystem state data tracked in RAM
  */
@@ -42,6 +50,22 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+/*
+ * Where the active version of one object instance lives in the active arena.
+ * The index is kept sorted by (obj_id, obj_inst_id).
+ */
+struct logfs_index_entry {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t slot_id;
+};
+
+/* What we know about each arena without reading its header */
+struct logfs_arena_info {
+	uint32_t erase_count;
+	bool erased;		/* erased and not yet put to use */
+};
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -55,6 +79,28 @@ struct logfs_state {
 	uint16_t num_free_slots;   /* slots in free state */
 	uint16_t num_active_slots; /* slots in active state */
 
+	/* RAM index of the active slots, rebuilt on mount and kept up to date
+	 * as objects are appended and obsoleted.  When it is complete, an
+	 * object that isn't in it isn't in the log either; otherwise (it was
+	 * too small, or the log held duplicates) misses fall back to a scan.
+	 */
+	struct logfs_index_entry *index;
+	uint16_t index_max;
+	uint16_t index_len;
+	bool index_complete;
+
+	uint8_t num_arenas;
+	struct logfs_arena_info *arenas;
+
+	/* Incremental garbage collection: active slots of the active arena
+	 * below gc_src_slot have been copied to gc_arena_id, which is
+	 * reserved (so ignored on mount) until the copy is complete.
+	 */
+	bool gc_active;
+	uint8_t gc_arena_id;
+	uint16_t gc_src_slot;
+	uint16_t gc_dst_slot;
+
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
@@ -101,8 +147,12 @@ enum arena_state {
 struct arena_header {
 	uint32_t magic;
 	enum arena_state state;
+	uint32_t erase_count;	/* set along with the header after each erase */
 } __attribute__((packed));
 
+/* Erase count of arenas formatted before the count was kept, or torn during an erase */
+#define ARENA_ERASE_COUNT_UNKNOWN 0xFFFFFFFF
+
 
 /****************************************
  * Arena life-cycle transition functions
@@ -113,9 +163,12 @@ struct arena_header {
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_id)
+static int32_t logfs_erase_arena(struct logfs_state *logfs, uint8_t arena_id)
 {
 	uintptr_t arena_addr = logfs_get_addr (logfs, arena_id, 0);
+	uint32_t erase_count = logfs->arenas[arena_id].erase_count + 1;
+
+	logfs->arenas[arena_id].erased = false;
 
 	/* Erase all of the sectors in the arena */
 	if (PIOS_FLASH_erase_range(logfs->partition_id, arena_addr, logfs->cfg->arena_size) != 0) {
@@ -124,8 +177,9 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
 
 	/* Mark this arena as fully erased */
 	struct arena_header arena_hdr = {
-		.magic = logfs->cfg->fs_magic,
-		.state = ARENA_STATE_ERASED,
+		.magic       = logfs->cfg->fs_magic,
+		.state       = ARENA_STATE_ERASED,
+		.erase_count = erase_count,
 	};
 
 	if (PIOS_FLASH_write_data(logfs->partition_id,
@@ -135,6 +189,9 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
 		return -2;
 	}
 
+	logfs->arenas[arena_id].erase_count = erase_count;
+	logfs->arenas[arena_id].erased      = true;
+
 	/* Arena is ready to be activated */
 	return 0;
 }
@@ -145,7 +202,7 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
  * @note Arena must have been previously erased before calling this
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t logfs_reserve_arena (const struct logfs_state *logfs, uint8_t arena_id)
+static int32_t logfs_reserve_arena (struct logfs_state *logfs, uint8_t arena_id)
 {
 	uintptr_t arena_addr = logfs_get_addr (logfs, arena_id, 0);
 
@@ -164,6 +221,7 @@ static int32_t logfs_reserve_arena (const struct logfs_state *logfs, uint8_t are
 
 	/* Set the arena state to reserved */
 	arena_hdr.state = ARENA_STATE_RESERVED;
+	logfs->arenas[arena_id].erased = false;
 
 	/* Write the arena header back to flash */
 	if (PIOS_FLASH_write_data(logfs->partition_id,
@@ -182,11 +240,9 @@ static int32_t logfs_reserve_arena (const struct logfs_state *logfs, uint8_t are
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t logfs_erase_all_arenas(const struct logfs_state *logfs)
+static int32_t logfs_erase_all_arenas(struct logfs_state *logfs)
 {
-	uint16_t num_arenas = logfs->partition_size / logfs->cfg->arena_size;
-
-	for (uint16_t arena = 0; arena < num_arenas; arena++) {
+	for (uint16_t arena = 0; arena < logfs->num_arenas; arena++) {
 		if (logfs_erase_arena(logfs, arena) != 0)
 			return -1;
 	}
@@ -200,7 +256,7 @@ static int32_t logfs_erase_all_arenas(const struct logfs_state *logfs)
  * @note Arena must have been previously erased or reserved before calling this
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t logfs_activate_arena(const struct logfs_state *logfs, uint8_t arena_id)
+static int32_t logfs_activate_arena(struct logfs_state *logfs, uint8_t arena_id)
 {
 	uintptr_t arena_addr = logfs_get_addr(logfs, arena_id, 0);
 
@@ -221,6 +277,7 @@ static int32_t logfs_activate_arena(const struct logfs_state *logfs, uint8_t are
 
 	/* Mark this arena as active */
 	arena_hdr.state = ARENA_STATE_ACTIVE;
+	logfs->arenas[arena_id].erased = false;
 	if (PIOS_FLASH_write_data(logfs->partition_id,
 					arena_addr,
 					(uint8_t *)&arena_hdr,
@@ -306,6 +363,110 @@ static int32_t logfs_find_active_arena(const struct logfs_state *logfs)
 	return -1;
 }
 
+/**
+ * @brief Load the erase count and state of every arena
+ * @return 0 if success, < 0 on failure
+ * @note Arenas whose count was lost are assumed to be as worn as the worst
+ *       of the others
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_scan_arenas(struct logfs_state *logfs)
+{
+	uint32_t max_count = 0;
+
+	for (uint8_t arena_id = 0; arena_id < logfs->num_arenas; arena_id++) {
+		struct arena_header arena_hdr;
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						logfs_get_addr (logfs, arena_id, 0),
+						(uint8_t *)&arena_hdr,
+						sizeof (arena_hdr)) != 0) {
+			return -1;
+		}
+
+		struct logfs_arena_info *arena = &logfs->arenas[arena_id];
+
+		if (arena_hdr.magic == logfs->cfg->fs_magic) {
+			arena->erase_count = arena_hdr.erase_count;
+			arena->erased      = (arena_hdr.state == ARENA_STATE_ERASED);
+		} else {
+			arena->erase_count = ARENA_ERASE_COUNT_UNKNOWN;
+			arena->erased      = false;
+		}
+
+		if (arena->erase_count != ARENA_ERASE_COUNT_UNKNOWN &&
+			arena->erase_count > max_count) {
+			max_count = arena->erase_count;
+		}
+	}
+
+	for (uint8_t arena_id = 0; arena_id < logfs->num_arenas; arena_id++) {
+		if (logfs->arenas[arena_id].erase_count == ARENA_ERASE_COUNT_UNKNOWN) {
+			logfs->arenas[arena_id].erase_count = max_count;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Obsolete any active arena other than the one being mounted
+ * @return 0 if success, < 0 on failure
+ * @note A power cut between activating the new arena and obsoleting the old
+ *       one at the end of a garbage collection leaves two arenas active with
+ *       the same contents.  Only one of them may live on.
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_obsolete_stale_arenas(struct logfs_state *logfs, uint8_t active_arena_id)
+{
+	for (uint8_t arena_id = 0; arena_id < logfs->num_arenas; arena_id++) {
+		if (arena_id == active_arena_id) {
+			continue;
+		}
+
+		struct arena_header arena_hdr;
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						logfs_get_addr (logfs, arena_id, 0),
+						(uint8_t *)&arena_hdr,
+						sizeof (arena_hdr)) != 0) {
+			return -1;
+		}
+
+		if ((arena_hdr.state == ARENA_STATE_ACTIVE) &&
+			(arena_hdr.magic == logfs->cfg->fs_magic)) {
+			if (logfs_obsolete_arena(logfs, arena_id) != 0) {
+				return -2;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Choose the arena the next garbage collection moves to
+ * @return the least worn arena, counting the erase it still needs
+ * @note Ties go to the first arena after the active one, so that a fresh
+ *       filesystem cycles through its arenas in order
+ */
+static uint8_t logfs_next_arena(const struct logfs_state *logfs)
+{
+	uint8_t best_id = 0;
+	uint32_t best_cost = 0;
+
+	for (uint8_t i = 1; i < logfs->num_arenas; i++) {
+		uint8_t arena_id = (logfs->active_arena_id + i) % logfs->num_arenas;
+		const struct logfs_arena_info *arena = &logfs->arenas[arena_id];
+		uint32_t cost = arena->erase_count + (arena->erased ? 0 : 1);
+
+		if (i == 1 || cost < best_cost) {
+			best_id   = arena_id;
+			best_cost = cost;
+		}
+	}
+
+	return best_id;
+}
+
 /*
  * The bits within these enum values must progress ONLY
  * from 1 -> 0 so that we can write later ones on top
@@ -397,12 +558,91 @@ static bool logfs_log_is_full(const struct logfs_state *logfs)
 	return (logfs->num_free_slots == 0);
 }
 
+/**
+ * @brief Binary search the slot index for an object instance
+ * @param[out] pos position of the entry, or where it would be inserted
+ * @return true if the object instance is in the index
+ */
+static bool logfs_index_search(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t *pos)
+{
+	uint16_t lo = 0;
+	uint16_t hi = logfs->index_len;
+
+	while (lo < hi) {
+		uint16_t mid = (lo + hi) / 2;
+		const struct logfs_index_entry *entry = &logfs->index[mid];
+
+		if (entry->obj_id < obj_id ||
+			(entry->obj_id == obj_id && entry->obj_inst_id < obj_inst_id)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	*pos = lo;
+
+	return (lo < logfs->index_len &&
+		logfs->index[lo].obj_id == obj_id &&
+		logfs->index[lo].obj_inst_id == obj_inst_id);
+}
+
+/**
+ * @brief Record that the active version of an object instance is in a slot
+ * @note If the index is full the object is left out and the index is marked
+ *       incomplete, so lookups that miss go back to scanning the log
+ */
+static void logfs_index_insert(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+	uint16_t pos;
+
+	if (logfs_index_search(logfs, obj_id, obj_inst_id, &pos)) {
+		/* Two active versions: only a scan can find all of them now */
+		logfs->index[pos].slot_id = slot_id;
+		logfs->index_complete = false;
+		return;
+	}
+
+	if (logfs->index_len >= logfs->index_max) {
+		logfs->index_complete = false;
+		return;
+	}
+
+	memmove(&logfs->index[pos + 1], &logfs->index[pos],
+		(logfs->index_len - pos) * sizeof(logfs->index[0]));
+
+	logfs->index[pos] = (struct logfs_index_entry) {
+		.obj_id      = obj_id,
+		.obj_inst_id = obj_inst_id,
+		.slot_id     = slot_id,
+	};
+	logfs->index_len++;
+}
+
+/**
+ * @brief Forget an object instance that is no longer active
+ */
+static void logfs_index_remove(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t pos;
+
+	if (!logfs_index_search(logfs, obj_id, obj_inst_id, &pos)) {
+		return;
+	}
+
+	logfs->index_len--;
+	memmove(&logfs->index[pos], &logfs->index[pos + 1],
+		(logfs->index_len - pos) * sizeof(logfs->index[0]));
+}
+
 static int32_t logfs_unmount_log(struct logfs_state *logfs)
 {
 	PIOS_Assert (logfs->mounted);
 
 	logfs->num_active_slots = 0;
 	logfs->num_free_slots   = 0;
+	logfs->index_len        = 0;
+	logfs->index_complete   = false;
 	logfs->mounted          = false;
 
 	return 0;
@@ -415,8 +655,10 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_active_slots = 0;
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
+	logfs->index_len        = 0;
+	logfs->index_complete   = (logfs->index != NULL);
 
-	/* Scan the log to find out how full it is */
+	/* Scan the log to find out how full it is and index what is in it */
 	for (uint16_t slot_id = 1;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
@@ -442,6 +684,7 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			logfs_index_insert(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -475,6 +718,12 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->index) {
+		PIOS_free(logfs->index);
+	}
+	if (logfs->arenas) {
+		PIOS_free(logfs->arenas);
+	}
 	PIOS_free(logfs);
 }
 
@@ -520,11 +769,36 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
 
+	/* Without room for an index the filesystem still works, by scanning */
+	logfs->index_max = cfg->index_entries;
+	if (logfs->index_max == 0) {
+		logfs->index_max = (cfg->arena_size / cfg->slot_size) - 1;
+	}
+	logfs->index = (struct logfs_index_entry *)PIOS_malloc_no_dma(logfs->index_max * sizeof(*logfs->index));
+	if (!logfs->index) {
+		logfs->index_max = 0;
+	}
+	logfs->index_len      = 0;
+	logfs->index_complete = false;
+
+	logfs->num_arenas = partition_size / cfg->arena_size;
+	logfs->arenas     = (struct logfs_arena_info *)PIOS_malloc_no_dma(logfs->num_arenas * sizeof(*logfs->arenas));
+	if (!logfs->arenas) {
+		rc = -1;
+		goto out_exit;
+	}
+	logfs->gc_active = false;
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
 		goto out_exit;
 	}
 
+	if (logfs_scan_arenas(logfs) != 0) {
+		rc = -2;
+		goto out_end_trans;
+	}
+
 	bool found = false;
 	int32_t arena_id;
 	for (uint8_t try = 0; !found && try < 2; try++) {
@@ -549,6 +823,12 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 		goto out_end_trans;
 	}
 
+	/* Settle a garbage collection that was cut short */
+	if (logfs_obsolete_stale_arenas(logfs, arena_id) != 0) {
+		rc = -2;
+		goto out_end_trans;
+	}
+
 	/* We've found an active arena, mount it */
 	if (logfs_mount_log(logfs, arena_id) != 0) {
 		/* Failed to mount the log, something is broken */
@@ -586,19 +866,32 @@ out_exit:
 	return rc;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
-	PIOS_Assert (logfs->mounted);
+/*
+ * Should garbage collection start ahead of the log filling up?  Only once
+ * it would free more slots than are left, and no later than copying
+ * LOGFS_GC_SLOTS_PER_SAVE slots per save can keep ahead of the saves
+ * (each of which adds another slot to copy).
+ */
+static bool logfs_gc_due(const struct logfs_state *logfs)
+{
+	uint16_t num_slots = (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1;
+	uint16_t num_dead_slots = num_slots - logfs->num_free_slots - logfs->num_active_slots;
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+	return (num_dead_slots > logfs->num_free_slots) &&
+		(logfs->num_free_slots * (LOGFS_GC_SLOTS_PER_SAVE - 1) <=
+			logfs->num_active_slots + LOGFS_GC_SLOTS_PER_SAVE);
+}
 
-	/* Compute destination arena */
-	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_start (struct logfs_state *logfs)
+{
+	uint8_t dst_arena_id = logfs_next_arena(logfs);
 
-	/* Erase destination arena */
-	if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
-		return -1;
+	/* Erase destination arena, unless that was already done in the background */
+	if (!logfs->arenas[dst_arena_id].erased) {
+		if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
+			return -1;
+		}
 	}
 
 	/* Reserve the destination arena so we can start filling it */
@@ -607,33 +900,80 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 		return -2;
 	}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
+	logfs->gc_active   = true;
+	logfs->gc_arena_id = dst_arena_id;
+	logfs->gc_src_slot = 1;
+	logfs->gc_dst_slot = 1;
+
+	return 0;
+}
+
+/**
+ * @brief Carry on with garbage collection, starting it if it is due
+ * @param[in] max_copies how many active slots to copy before returning
+ * @return 0 if success, < 0 on failure
+ * @note New versions of objects keep going to the active arena while the
+ *       collection is in progress, so that a power cut at any point leaves
+ *       a complete active arena behind.
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_garbage_collect (struct logfs_state *logfs, uint16_t max_copies)
+{
+	PIOS_Assert (logfs->mounted);
+
+	if (!logfs->gc_active) {
+		if (!logfs_log_is_full(logfs) && !logfs_gc_due(logfs)) {
+			return 0;
+		}
+
+		if (logfs_gc_start(logfs) != 0) {
+			return -1;
+		}
+	}
+
+	/* Source arena is the active arena */
+	uint8_t src_arena_id = logfs->active_arena_id;
+	uint8_t dst_arena_id = logfs->gc_arena_id;
+
+	/* Copy active slots from active arena to destination arena, up to the end of the log */
+	uint16_t src_end = (logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+	uint16_t copies = 0;
+	while (logfs->gc_src_slot < src_end && copies < max_copies) {
 		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
+		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, logfs->gc_src_slot);
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						src_addr,
 						(uint8_t *)&slot_hdr,
 						sizeof (slot_hdr)) != 0) {
+			/* Give up on this destination; the next attempt starts afresh */
+			logfs->gc_active = false;
 			return -3;
 		}
 
 		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
+			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, logfs->gc_dst_slot);
 			if (logfs_raw_copy_bytes(logfs,
 							src_addr,
 							sizeof(slot_hdr) + slot_hdr.obj_size,
 							dst_addr) != 0) {
 				/* Failed to copy all bytes */
+				logfs->gc_active = false;
 				return -4;
 			}
-			dst_slot_id++;
+			logfs->gc_dst_slot++;
+			copies++;
 		}
+
+		logfs->gc_src_slot++;
+	}
+
+	if (logfs->gc_src_slot < src_end) {
+		/* More to copy on the next save */
+		return 0;
 	}
 
+	logfs->gc_active = false;
+
 	/* Activate the destination arena */
 	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
 		return -5;
@@ -644,7 +984,7 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 		return -6;
 	}
 
-	/* Obsolete the source arena */
+	/* Obsolete the source arena; it gets erased when it's next needed */
 	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
 		return -7;
 	}
@@ -658,7 +998,7 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *curr_slot, uint32_t obj_id, uint16_t obj_inst_id)
+static int16_t logfs_object_find_next (const struct logfs_state *logfs, uint8_t arena_id, struct slot_header *slot_hdr, uint16_t *curr_slot, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	PIOS_Assert(slot_hdr);
 	PIOS_Assert(curr_slot);
@@ -669,7 +1009,7 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	for (uint16_t slot_id = *curr_slot;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
-		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+		uintptr_t slot_addr = logfs_get_addr (logfs, arena_id, slot_id);
 
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						slot_addr,
@@ -694,17 +1034,91 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	return -1;
 }
 
+/**
+ * @brief Find the active slot holding an object instance
+ * @param[out] slot_hdr header of the slot found
+ * @param[out] slot_id the slot found
+ * @return 0 if found, -1 if not found, -2 if reading flash failed
+ * @note Must be called while holding the flash transaction lock
+ */
+static int16_t logfs_object_find (struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t pos;
+
+	if (logfs_index_search(logfs, obj_id, obj_inst_id, &pos)) {
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, logfs->index[pos].slot_id);
+
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)slot_hdr,
+						sizeof (*slot_hdr)) != 0) {
+			return -2;
+		}
+		if (slot_hdr->state == SLOT_STATE_ACTIVE &&
+			slot_hdr->obj_id      == obj_id &&
+			slot_hdr->obj_inst_id == obj_inst_id) {
+			*slot_id = logfs->index[pos].slot_id;
+			return 0;
+		}
+
+		/* The index is stale; stop trusting it until the next mount */
+		PIOS_DEBUG_Assert(0);
+		logfs_index_remove(logfs, obj_id, obj_inst_id);
+		logfs->index_complete = false;
+	} else if (logfs->index_complete) {
+		/* Everything active is indexed, so there's nothing to scan for */
+		return -1;
+	}
+
+	*slot_id = 0;
+	return logfs_object_find_next (logfs, logfs->active_arena_id, slot_hdr, slot_id, obj_id, obj_inst_id);
+}
+
+/**
+ * @brief Obsolete the copy garbage collection made of an object instance
+ * @return 0 if success (or there was no copy), < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int8_t logfs_gc_delete_copy (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t slot_id = 0;
+	struct slot_header slot_hdr;
+
+	switch (logfs_object_find_next (logfs, logfs->gc_arena_id, &slot_hdr, &slot_id, obj_id, obj_inst_id)) {
+	case 0:
+		break;
+	case -1:
+		return 0;
+	default:
+		return -1;
+	}
+
+	slot_hdr.state = SLOT_STATE_OBSOLETE;
+	if (PIOS_FLASH_write_data(logfs->partition_id,
+					logfs_get_addr (logfs, logfs->gc_arena_id, slot_id),
+					(uint8_t *)&slot_hdr,
+					sizeof(slot_hdr)) != 0) {
+		return -2;
+	}
+
+	return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
 
+	/*
+	 * Keep going until nothing is found, in case the log holds more than
+	 * one active version.  With a complete index the second lookup is
+	 * answered from RAM.
+	 */
 	bool more = true;
-	uint16_t curr_slot_id = 0;
 	do {
+		uint16_t curr_slot_id;
 		struct slot_header slot_hdr;
-		switch (logfs_object_find_next (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
+		switch (logfs_object_find (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
 		case 0:
 			/* Found a matching slot.  Obsolete it. */
 			slot_hdr.state = SLOT_STATE_OBSOLETE;
@@ -719,6 +1133,15 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs_index_remove(logfs, obj_id, obj_inst_id);
+
+			/* If it was already moved by garbage collection, drop the copy too */
+			if (logfs->gc_active && curr_slot_id < logfs->gc_src_slot) {
+				if (logfs_gc_delete_copy (logfs, obj_id, obj_inst_id) != 0) {
+					rc = -3;
+					goto out_exit;
+				}
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -831,6 +1254,7 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs_index_insert(logfs, obj_id, obj_inst_id, free_slot_id);
 	return 0;
 }
 
@@ -856,6 +1280,8 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
  * @retval -4 if filesystem is entirely full and garbage collection won't help
  * @retval -5 if garbage collection failed
  * @retval -6 if filesystem is full even after garbage collection should have freed space
+ * @note Once the log is getting full, each save also moves a few active slots
+ *       to the next arena, rather than one save moving all of them at once.
  * @retval -7 if writing the new object to the filesystem failed
  */
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
@@ -896,7 +1322,7 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	/* Is garbage collection required? */
 	if (logfs_log_is_full(logfs)) {
 		/* Note: Log Full means the log is full but may contain obsolete slots so gc may free some space */
-		if (logfs_garbage_collect(logfs) != 0) {
+		if (logfs_garbage_collect(logfs, UINT16_MAX) != 0) {
 			rc = -5;
 			goto out_end_trans;
 		}
@@ -911,6 +1337,9 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 			rc = -6;
 			goto out_end_trans;
 		}
+	} else if (logfs_garbage_collect(logfs, LOGFS_GC_SLOTS_PER_SAVE) != 0) {
+		rc = -5;
+		goto out_end_trans;
 	}
 
 	/* We have room for our new object.  Append it to the log. */
@@ -963,9 +1392,9 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	}
 
 	/* Find the object in the log */
-	uint16_t slot_id = 0;
+	uint16_t slot_id;
 	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
 		/* Object does not exist in fs */
 		rc = -3;
 		goto out_end_trans;
@@ -1066,6 +1495,7 @@ int32_t PIOS_FLASHFS_Format(uintptr_t fs_id)
 	if (logfs->mounted) {
 		logfs_unmount_log(logfs);
 	}
+	logfs->gc_active = false;
 
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -2;
@@ -1099,6 +1529,74 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Do housekeeping that would otherwise hold up a later save
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if failed to erase the arena for the next garbage collection
+ * @note Erasing stalls internal flash for a long time, so this should only
+ *       be called when nothing time critical is running.
+ */
+int32_t PIOS_FLASHFS_Maintenance(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	/* Nothing to do while a collection is underway or once the next arena
+	 * is ready.  A save from another task may have started a collection
+	 * into the next arena, so this is only known with the flash held. */
+	if (logfs->gc_active || logfs->arenas[logfs_next_arena(logfs)].erased) {
+		rc = 0;
+		goto out_end_trans;
+	}
+
+	if (logfs_erase_arena(logfs, logfs_next_arena(logfs)) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	rc = 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
+/**
+ * @brief Get the number of times an arena has been erased
+ * @param[in] fs_id The filesystem to query
+ * @param[in] arena_id The arena to query
+ * @param[out] erase_count The number of erases
+ * @return 0 if success, -1 if fs_id or arena_id is not valid
+ */
+int32_t PIOS_FLASHFS_Logfs_GetEraseCount(uintptr_t fs_id, uint8_t arena_id, uint32_t *erase_count)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs) || arena_id >= logfs->num_arenas) {
+		return -1;
+	}
+
+	*erase_count = logfs->arenas[arena_id].erase_count;
+
+	return 0;
+}
+
 /**
  * @}
  * @}
@@ -134,8 +134,17 @@ bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeou
 
 	chSysLock();
 
-	if (chThdSelf() != mtx->mtx.m_owner)
-		chMtxLockS(&mtx->mtx);
+	if (chThdSelf() != mtx->mtx.m_owner) {
+		if (timeout_ms == 0) {
+			/* Only a zero timeout (try lock) is supported */
+			if (!chMtxTryLockS(&mtx->mtx)) {
+				chSysUnlock();
+				return false;
+			}
+		} else {
+			chMtxLockS(&mtx->mtx);
+		}
+	}
 
 	++mtx->count;
 
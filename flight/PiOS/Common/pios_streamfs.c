@@ -87,7 +87,24 @@ struct streamfs_state {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
-	uint8_t *com_buffer;
+
+	/*
+	 * Data from the COM fifo is gathered into write_size blocks that
+	 * end on write_size boundaries of the arena, so each one is
+	 * programmed with a single page aligned write.  One block fills
+	 * while the other one waits for (or is being written by) the task.
+	 * buf_mutex only covers the copying and bookkeeping, never flash
+	 * access.
+	 */
+	struct pios_mutex *buf_mutex;
+	uint8_t *block[2];
+	uint8_t fill_block;
+	uint16_t fill_len;
+	uint16_t fill_target;
+	uint32_t fill_offset;
+	int8_t flush_block;
+	uint16_t flush_len;
+	uint32_t buffer_high_water;
 
 	/* Information for current file handle */
 	bool file_open_writing;
@@ -510,61 +527,159 @@ static int32_t streamfs_scan_filesystem(struct streamfs_state *streamfs)
 	return 0;
 }
 
-static void PIOS_STREAMFS_Task(void *parameters)
+/**
+ * @brief Restart block buffering at the start of an arena
+ * @note Must be called while holding buf_mutex
+ */
+static void streamfs_reset_blocks(struct streamfs_state *streamfs)
 {
-	struct streamfs_state *streamfs = parameters;
+	streamfs->fill_len = 0;
+	streamfs->fill_offset = 0;
+	streamfs->fill_target = streamfs->cfg->write_size;
+	streamfs->flush_block = -1;
+	streamfs->flush_len = 0;
+}
+
+/**
+ * @brief Move data from the COM fifo into the block being filled
+ *
+ * A completed block is handed to the task if it is idle, otherwise data
+ * is left in the fifo until the task catches up.  While no file is open
+ * for writing the fifo is drained and the data discarded.
+ * @note Must be called while holding buf_mutex
+ */
+static void streamfs_fill_blocks(struct streamfs_state *streamfs)
+{
+	const uint32_t data_size = streamfs->cfg->arena_size -
+		sizeof(struct streamfs_footer);
+
+	while (streamfs->tx_out_cb) {
+		if (streamfs->fill_len == streamfs->fill_target) {
+			if (streamfs->flush_block >= 0) {
+				/* Both blocks are full; back-pressure */
+				break;
+			}
+
+			streamfs->flush_block = streamfs->fill_block;
+			streamfs->flush_len = streamfs->fill_len;
+
+			streamfs->fill_block ^= 1;
+			streamfs->fill_offset += streamfs->fill_len;
+			if (streamfs->fill_offset >= data_size) {
+				streamfs->fill_offset = 0;
+			}
+
+			/* Stop at the next page boundary, or at the footer */
+			uint32_t write_size = streamfs->cfg->write_size;
+			streamfs->fill_len = 0;
+			streamfs->fill_target = MIN(write_size - streamfs->fill_offset % write_size,
+					data_size - streamfs->fill_offset);
+
+			PIOS_Semaphore_Give(streamfs->sem);
+		}
+
+		uint16_t bytes = (streamfs->tx_out_cb)(
+			streamfs->tx_out_context,
+			streamfs->block[streamfs->fill_block] + streamfs->fill_len,
+			streamfs->fill_target - streamfs->fill_len,
+			NULL, NULL);
+
+		if (!streamfs->file_open_writing) {
+			if (bytes == 0) {
+				break;
+			}
+
+			continue;
+		}
+
+		streamfs->fill_len += bytes;
 
-	bool tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		if (bytes == 0) {
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Write out the block waiting to be flushed, if any
+ * @return 0 if there was nothing to write or it was written, < 0 if
+ * the flash could not be written
+ * @note Must be called while holding the mutex (not buf_mutex) and the
+ * flash transaction lock
+ */
+static int32_t streamfs_flush_block(struct streamfs_state *streamfs)
+{
+	bool tmp = PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	int8_t block = streamfs->flush_block;
+	uint16_t len = streamfs->flush_len;
+
+	PIOS_Mutex_Unlock(streamfs->buf_mutex);
+
+	if (block < 0) {
+		return 0;
+	}
+
+	/* The producer leaves this block alone until flush_block is cleared */
+	int32_t rc = streamfs_append_to_file(streamfs, streamfs->block[block], len);
+
+	tmp = PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	PIOS_Assert(tmp);
 
+	streamfs->flush_block = -1;
+
+	/* Make up for anything held back while both blocks were full */
+	streamfs_fill_blocks(streamfs);
+
+	PIOS_Mutex_Unlock(streamfs->buf_mutex);
+
+	return (rc < 0) ? rc : 0;
+}
+
+static void PIOS_STREAMFS_Task(void *parameters)
+{
+	struct streamfs_state *streamfs = parameters;
+
 	while (1) {
-		int32_t bytes_to_write = 0;
-
-		if (streamfs->tx_out_cb) {
-			bytes_to_write = (streamfs->tx_out_cb)(
-				streamfs->tx_out_context,
-				streamfs->com_buffer,
-				streamfs->cfg->write_size,
-				NULL, NULL);
-		}
+		bool tmp = PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		PIOS_Assert(tmp);
+
+		streamfs_fill_blocks(streamfs);
+		bool pending = streamfs->flush_block >= 0;
 
-		if (bytes_to_write <= 0) {
+		PIOS_Mutex_Unlock(streamfs->buf_mutex);
+
+		if (!pending) {
 			// Block here until woken.
-			PIOS_Mutex_Unlock(streamfs->mutex);
 			PIOS_Semaphore_Take(streamfs->sem, PIOS_SEMAPHORE_TIMEOUT_MAX);
-			tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
-			PIOS_Assert(tmp);
 			continue;
 		}
 
+		tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		PIOS_Assert(tmp);
+
 		if (!streamfs->file_open_writing) {
-			// Drain out pending data while file not open
+			// File was closed under us; Close wrote out the blocks
+			tmp = PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+			PIOS_Assert(tmp);
+			streamfs_reset_blocks(streamfs);
+			PIOS_Mutex_Unlock(streamfs->buf_mutex);
+
+			PIOS_Mutex_Unlock(streamfs->mutex);
 			continue;
 		}
 
 		if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
 			PIOS_Mutex_Unlock(streamfs->mutex);
 			PIOS_Thread_Sleep(50);	// Don't spin
-			tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
-			PIOS_Assert(tmp);
 			continue;
 		}
 
-		// Flush available data from PIOS_COM interface to
-		// file system
-		while (bytes_to_write > 0) {
-			if (streamfs_append_to_file(streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
-				break;
-			}
-
-			bytes_to_write = (streamfs->tx_out_cb)(
-					streamfs->tx_out_context,
-					streamfs->com_buffer,
-					streamfs->cfg->write_size,
-					NULL, NULL);
-		}
+		streamfs_flush_block(streamfs);
 
 		PIOS_FLASH_end_transaction(streamfs->partition_id);
+		PIOS_Mutex_Unlock(streamfs->mutex);
 	}
 }
 
@@ -600,6 +715,9 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	/* sector_size must exceed write_size */
 	PIOS_Assert(cfg->arena_size > cfg->write_size);
 
+	/* Blocks are handed around with 16 bit lengths */
+	PIOS_Assert(cfg->write_size > 0 && cfg->write_size <= UINT16_MAX);
+
 	int8_t rc;
 
 	struct streamfs_state *streamfs;
@@ -610,8 +728,11 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		goto out_exit;
 	}
 
-	streamfs->com_buffer = (uint8_t *)PIOS_malloc(cfg->write_size);
-	if (!streamfs->com_buffer) {
+	streamfs->block[0] = (uint8_t *)PIOS_malloc(cfg->write_size);
+	streamfs->block[1] = (uint8_t *)PIOS_malloc(cfg->write_size);
+	if (!streamfs->block[0] || !streamfs->block[1]) {
+		PIOS_free(streamfs->block[0]);
+		PIOS_free(streamfs->block[1]);
 		PIOS_free(streamfs);
 		return -1;
 	}
@@ -628,6 +749,11 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	streamfs->active_file_arena        = 0;
 	streamfs->active_file_arena_offset = 0;
 
+	streamfs->tx_out_cb = NULL;
+	streamfs->fill_block = 0;
+	streamfs->buffer_high_water = 0;
+	streamfs_reset_blocks(streamfs);
+
 	streamfs->mutex = PIOS_Mutex_Create();
 
 	if (!streamfs->mutex) {
@@ -635,6 +761,13 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		goto out_exit;
 	}
 
+	streamfs->buf_mutex = PIOS_Mutex_Create();
+
+	if (!streamfs->buf_mutex) {
+		rc = -1;
+		goto out_exit;
+	}
+
 	streamfs->sem = PIOS_Semaphore_Create();
 
 	if (!streamfs->sem) {
@@ -762,8 +895,16 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_segment = 0;
 	streamfs->active_file_arena = streamfs_find_new_sector(streamfs);
 	streamfs->active_file_arena_offset = 0;
+
+	bool tmp = PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	streamfs_reset_blocks(streamfs);
+	streamfs->buffer_high_water = 0;
 	streamfs->file_open_writing = true;
 
+	PIOS_Mutex_Unlock(streamfs->buf_mutex);
+
 	// Erase this sector to prepare for streaming
 	if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
 		rc = -5;
@@ -868,6 +1009,24 @@ int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id)
 	return streamfs->max_file_id;
 }
 
+/**
+ * @brief Report the most data that has been waiting to be written
+ * @param[in] fs_id the streaming device handle
+ * @return the high water mark in bytes of the COM fifo plus the blocks
+ * not yet written, since the file was opened, or < 0 on error
+ */
+int32_t PIOS_STREAMFS_BufferHighWater(uintptr_t fs_id)
+{
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	if (!streamfs_validate(streamfs)) {
+		return -1;
+	}
+
+	return streamfs->buffer_high_water;
+}
+
 int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 {
 	int32_t rc;
@@ -905,6 +1064,38 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+	// Flush what has been buffered, including what is still in the fifo
+	// behind full blocks, then whatever is in the block being filled.
+	// A failed write still lets the file be closed, but is reported.
+	bool write_failed = false;
+
+	bool tmp = PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	streamfs_fill_blocks(streamfs);
+
+	while (streamfs->flush_block >= 0) {
+		if (streamfs_append_to_file(streamfs, streamfs->block[streamfs->flush_block],
+				streamfs->flush_len) < 0) {
+			write_failed = true;
+		}
+
+		streamfs->flush_block = -1;
+		streamfs_fill_blocks(streamfs);
+	}
+
+	if (streamfs->fill_len > 0) {
+		if (streamfs_append_to_file(streamfs, streamfs->block[streamfs->fill_block],
+				streamfs->fill_len) < 0) {
+			write_failed = true;
+		}
+	}
+
+	streamfs_reset_blocks(streamfs);
+	streamfs->file_open_writing = false;
+
+	PIOS_Mutex_Unlock(streamfs->buf_mutex);
+
 	if (streamfs->active_file_arena_offset != 0) {
 		// Close segment when something has been written. This avoids creating
 		// null files with an open/close operation
@@ -914,16 +1105,12 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		}
 	}
 
-
-	// TODO: make sure to flush remaining data
-	streamfs->file_open_writing = false;
-
 	if (streamfs_scan_filesystem(streamfs) != 0) {
 		rc = -4;
 		goto out_end_trans;
 	}
 
-	rc = 0;
+	rc = write_failed ? -5 : 0;
 
 out_end_trans:
 	PIOS_FLASH_end_transaction(streamfs->partition_id);
@@ -1015,7 +1202,23 @@ static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail)
 	bool valid = streamfs_validate(streamfs);
 	PIOS_Assert(valid);
 
-	PIOS_Semaphore_Give(streamfs->sem);
+	/* Coalesce into the current block here; the task is only woken
+	 * when there is a whole block to write */
+	if (PIOS_Mutex_Lock(streamfs->buf_mutex, PIOS_MUTEX_TIMEOUT_MAX)) {
+		if (streamfs->file_open_writing) {
+			uint32_t backlog = tx_bytes_avail + streamfs->fill_len;
+			if (streamfs->flush_block >= 0) {
+				backlog += streamfs->flush_len;
+			}
+
+			if (backlog > streamfs->buffer_high_water) {
+				streamfs->buffer_high_water = backlog;
+			}
+		}
+
+		streamfs_fill_blocks(streamfs);
+		PIOS_Mutex_Unlock(streamfs->buf_mutex);
+	}
 }
 
 static void PIOS_STREAMFS_RegisterTxCallback(uintptr_t fs_id, pios_com_callback tx_out_cb, uintptr_t context)
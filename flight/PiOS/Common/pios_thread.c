@@ -259,6 +259,26 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return result;
 }
 
+/**
+ *
+ * @brief   Returns the scheduling statistics of a thread.
+ *
+ * ChibiOS only accounts ticks per thread, which Get_Runtime already reports.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[out] timing      statistics of the thread
+ *
+ * @return false; not measured on this platform
+ *
+ */
+bool PIOS_Thread_Get_Timing(struct pios_thread *threadp, struct pios_thread_timing *timing)
+{
+	(void) threadp;
+	(void) timing;
+
+	return false;
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -27,6 +27,7 @@
 #include "openpilot.h"
 #include "taskmonitor.h"
 #include "pios_mutex.h"
+#include "tasktiming.h"
 
 // Private constants
 
@@ -36,13 +37,24 @@
 static struct pios_mutex *lock;
 static struct pios_thread *handles[TASKINFO_RUNNING_NUMELEM];
 static uint32_t lastMonitorTime;
+#if defined(DIAG_TASKS)
+static uint16_t timingInstance[TASKINFO_RUNNING_NUMELEM];	/* instance + 1 */
+static uint16_t timingInstances;
+#endif
 
 DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM != TASKINFO_STACKREMAINING_NUMELEM,
 		taskelems1);
 DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM != TASKINFO_RUNNINGTIME_NUMELEM,
 		taskelems2);
+DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM != TASKTIMING_TASK_MAXOPTVAL + 1,
+		taskelems3);
+DONT_BUILD_IF(TASKTIMING_LATENCYHISTOGRAM_NUMELEM != PIOS_THREAD_LATENCY_BUCKETS,
+		latencybuckets);
 
 // Private functions
+#if defined(DIAG_TASKS)
+static void updateTiming(int task);
+#endif
 
 /**
  * Initialize library
@@ -56,7 +68,11 @@ int32_t TaskMonitorInitialize(void)
 #if defined(DIAG_TASKS)
 #if defined(PIOS_INCLUDE_CHIBIOS)
 	lastMonitorTime = halGetCounterValue();
+#else
+	lastMonitorTime = PIOS_DELAY_GetRaw();
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	memset(timingInstance, 0, sizeof(timingInstance));
+	timingInstances = 0;
 #endif
 	return 0;
 }
@@ -128,10 +144,13 @@ void TaskMonitorUpdateAll(void)
 	/*
 	 * Calculate the amount of elapsed run time between the last time we
 	 * measured and now. Scale so that we can convert task run times
-	 * directly to percentages.
+	 * directly to percentages. Posix threads report their run time in
+	 * microseconds, so use the microsecond clock there.
 	 */
 #if defined(PIOS_INCLUDE_CHIBIOS)
 	currentTime = hal_lld_get_counter_value();
+#else
+	currentTime = PIOS_DELAY_GetRaw();
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
 	deltaTime = ((currentTime - lastMonitorTime) / 100) ? : 1; /* avoid divide-by-zero if the interval is too small */
 	lastMonitorTime = currentTime;
@@ -145,6 +164,8 @@ void TaskMonitorUpdateAll(void)
 			data.StackRemaining[n] = PIOS_Thread_Get_Stack_Usage(handles[n]);
 			/* Generate run time stats */
 			data.RunningTime[n] = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+
+			updateTiming(n);
 		}
 		else
 		{
@@ -162,6 +183,44 @@ void TaskMonitorUpdateAll(void)
 #endif
 }
 
+#if defined(DIAG_TASKS)
+/**
+ * Publish the scheduling statistics of a task, where the platform measures
+ * them. Each task gets its own TaskTiming instance the first time.
+ */
+static void updateTiming(int task)
+{
+	struct pios_thread_timing timing;
+
+	if (!PIOS_Thread_Get_Timing(handles[task], &timing))
+		return;
+
+	if (!timingInstance[task]) {
+		if (!timingInstances) {
+			if (TaskTimingInitialize() == -1)
+				return;
+		} else if (TaskTimingCreateInstance() != timingInstances) {
+			return;
+		}
+
+		timingInstance[task] = ++timingInstances;
+	}
+
+	TaskTimingData data;
+
+	data.Task = task;
+	data.CPUTime = timing.cpu_time_us / 1000;
+	data.VoluntarySwitches = timing.voluntary_switches;
+	data.InvoluntarySwitches = timing.involuntary_switches;
+	data.MaxLatency = timing.max_latency_us;
+
+	for (int i = 0; i < TASKTIMING_LATENCYHISTOGRAM_NUMELEM; i++)
+		data.LatencyHistogram[i] = timing.latency_hist[i];
+
+	TaskTimingInstSet(timingInstance[task] - 1, &data);
+}
+#endif /* DIAG_TASKS */
+
 /**
  * @}
  */
@@ -34,15 +34,21 @@
  *
  * Note: a filesystem requires room for at least 2 arenas within its partition.
  * Note: a filesystem requires room for at least 2 slots per arena.  The first slot is reserved.
+ * Note: the RAM slot index costs 8 bytes per entry.  Leaving index_entries at 0 sizes it to
+ *       hold every slot of an arena; a smaller bound trades lookups of objects that did not fit
+ *       (or are not in the filesystem at all) for a scan of the log.
  */
 struct flashfs_logfs_cfg {
 	uint32_t fs_magic;
 	uint32_t arena_size;	/* Max size of one generation of the filesystem */
 	uint32_t slot_size;	/* Max size of a "file" within the filesystem */
+	uint16_t index_entries;	/* Max objects tracked in the RAM slot index, 0 for one per slot */
 };
 
 int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t * fs_id, const struct flashfs_logfs_cfg * cfg, enum pios_flash_partition_labels partition_label);
 
 int32_t PIOS_FLASHFS_Logfs_Destroy(uintptr_t fs_id);
 
+int32_t PIOS_FLASHFS_Logfs_GetEraseCount(uintptr_t fs_id, uint8_t arena_id, uint32_t *erase_count);
+
 #endif	/* PIOS_FLASHFS_LOGFS_PRIV_H_ */
@@ -35,6 +35,7 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id);
 int32_t PIOS_STREAMFS_MinFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id);
+int32_t PIOS_STREAMFS_BufferHighWater(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Close(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len);
 
@@ -35,7 +35,8 @@
 struct streamfs_cfg {
 	uint32_t fs_magic;
 	uint32_t arena_size; /* The size chunk that is erased (must equal sector size) */
-	uint32_t write_size;  /* The size to buffer between writes */
+	uint32_t write_size;  /* The size to buffer between writes; a multiple of the flash page size,
+	                       * so that buffered blocks are programmed a page at a time */
 };
 
 int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enum pios_flash_partition_labels partition_label);
@@ -63,6 +63,20 @@ enum pios_thread_prio_e
 };
 #endif
 
+/* Wakeup latency buckets: under 50, 100, 200, 500, 1000, 2000, 5000us, and over */
+#define PIOS_THREAD_LATENCY_BUCKETS 8
+
+/**
+ * Scheduling statistics of a thread, on platforms that can measure them.
+ */
+struct pios_thread_timing {
+	uint64_t cpu_time_us;		/**< Total CPU time used */
+	uint32_t voluntary_switches;	/**< Times the thread blocked */
+	uint32_t involuntary_switches;	/**< Times the thread was preempted */
+	uint32_t max_latency_us;	/**< Worst wakeup lateness since the last call */
+	uint32_t latency_hist[PIOS_THREAD_LATENCY_BUCKETS];	/**< Wakeups by lateness */
+};
+
 /*
  * The following functions implement the concept of a thread usable
  * with either FreeRTOS or ChibiOS
@@ -75,6 +89,7 @@ void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
+bool PIOS_Thread_Get_Timing(struct pios_thread *threadp, struct pios_thread_timing *timing);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
 
@@ -24,8 +24,14 @@
  */
 
 
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE		/* RUSAGE_THREAD */
+#endif /* !defined(_GNU_SOURCE) */
+
 #include <pthread.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/resource.h>
 
 #include <pios.h>
 #include <pios_thread.h>
@@ -35,11 +41,119 @@ struct pios_thread
 	pthread_t thread;
 
 	char *name;
+
+	void (*fp)(void *);
+	void *argp;
+
+#ifdef _POSIX_THREAD_CPUTIME
+	clockid_t cpu_clock;
+#endif
+	bool has_cpu_clock;
+	uint64_t last_cpu_us;
+
+	/* Updated by the thread itself each time it wakes */
+	uint32_t voluntary_switches;
+	uint32_t involuntary_switches;
+	uint32_t max_latency_us;
+	uint32_t latency_hist[PIOS_THREAD_LATENCY_BUCKETS];
+};
+
+/* Upper bounds of all but the last latency bucket */
+static const uint32_t latency_bounds_us[PIOS_THREAD_LATENCY_BUCKETS - 1] = {
+	50, 100, 200, 500, 1000, 2000, 5000
 };
 
+/* The thread structure of the calling thread, if PIOS_Thread created it */
+static __thread struct pios_thread *self;
+
+static uint64_t monotonic_us(void)
+{
+	struct timespec monotime;
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime);
+
+	return monotime.tv_sec * 1000000ULL + monotime.tv_nsec / 1000;
+}
+
+static uint64_t thread_cpu_us(struct pios_thread *threadp)
+{
+#ifdef _POSIX_THREAD_CPUTIME
+	struct timespec cputime;
+
+	if (threadp->has_cpu_clock &&
+			!clock_gettime(threadp->cpu_clock, &cputime)) {
+		return cputime.tv_sec * 1000000ULL + cputime.tv_nsec / 1000;
+	}
+#endif
+
+	return 0;
+}
+
+/**
+ * @brief Account a wakeup of the calling thread.
+ *
+ * Context switch counts can only be read by the thread itself, so they are
+ * sampled here too.
+ *
+ * @param[in] late_us how long after it was due the thread got to run
+ */
+static void account_wakeup(uint32_t late_us)
+{
+	struct pios_thread *thread = self;
+
+	if (!thread) {
+		return;
+	}
+
+#ifdef RUSAGE_THREAD
+	struct rusage usage;
+
+	if (!getrusage(RUSAGE_THREAD, &usage)) {
+		thread->voluntary_switches = usage.ru_nvcsw;
+		thread->involuntary_switches = usage.ru_nivcsw;
+	}
+#endif
+
+	if (late_us > thread->max_latency_us) {
+		thread->max_latency_us = late_us;
+	}
+
+	int i;
+
+	for (i = 0; i < PIOS_THREAD_LATENCY_BUCKETS - 1; i++) {
+		if (late_us < latency_bounds_us[i]) {
+			break;
+		}
+	}
+
+	thread->latency_hist[i]++;
+}
+
+static void sleep_accounted(uint32_t time_ms)
+{
+	uint64_t due = monotonic_us() + time_ms * 1000ULL;
+
+	usleep(1000 * time_ms);
+
+	uint64_t now = monotonic_us();
+
+	account_wakeup(now > due ? now - due : 0);
+}
+
+static void *thread_start(void *arg)
+{
+	struct pios_thread *thread = arg;
+
+	self = thread;
+
+	thread->fp(thread->argp);
+
+	return NULL;
+}
+
 struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
 {
-	struct pios_thread *thread = malloc(sizeof(*thread));
+	struct pios_thread *thread = calloc(1, sizeof(*thread));
 
 	pthread_attr_t attr;
 
@@ -61,10 +175,10 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	}
 
 	thread->name = strdup(namep);
+	thread->fp = fp;
+	thread->argp = argp;
 
-	void *(*thr_func)(void *) = (void *) fp;
-
-	int ret = pthread_create(&thread->thread, &attr, thr_func, argp);
+	int ret = pthread_create(&thread->thread, &attr, thread_start, thread);
 
 	if (ret) {
 		printf("Couldn't start thr (%s) ret=%d\n", namep, ret);
@@ -78,6 +192,11 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	pthread_setname_np(thread->thread, thread->name);
 #endif
 
+#ifdef _POSIX_THREAD_CPUTIME
+	thread->has_cpu_clock =
+		!pthread_getcpuclockid(thread->thread, &thread->cpu_clock);
+#endif
+
 	printf("Started thread (%s) p=%p\n", namep, &thread->thread);
 
 	return thread;
@@ -100,11 +219,7 @@ void PIOS_Thread_Delete(struct pios_thread *threadp)
 
 uint32_t PIOS_Thread_Systime(void)
 {
-	struct timespec monotime;
-
-	clock_gettime(CLOCK_MONOTONIC, &monotime);
-
-	uint32_t t = monotime.tv_sec * 1000 + monotime.tv_nsec / 1000000;
+	uint32_t t = monotonic_us() / 1000;
 
 	static uint32_t base = 0;
 
@@ -123,7 +238,7 @@ void PIOS_Thread_Sleep(uint32_t time_ms)
 		}
 	}
 
-	usleep(1000 * time_ms);
+	sleep_accounted(time_ms);
 }
 
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
@@ -136,9 +251,12 @@ void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
 
 	if (ms > increment_ms) {
 		// Very late or wrapped.
+		account_wakeup((now - *previous_ms) * 1000);
 		*previous_ms = now;
 	} else if (ms > 0) {
-		PIOS_Thread_Sleep(ms);
+		sleep_accounted(ms);
+	} else {
+		account_wakeup(0);
 	}
 }
 
@@ -147,9 +265,44 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return 0;	/* XXX */
 }
 
+/**
+ * @brief Returns the CPU time a thread used since the last call.
+ *
+ * @param[in] threadp the thread
+ * @return CPU time in microseconds, or 0 where thread CPU clocks are missing
+ */
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 {
-	return 0;	/* XXX */
+	uint64_t cpu_us = thread_cpu_us(threadp);
+
+	uint32_t result = cpu_us - threadp->last_cpu_us;
+	threadp->last_cpu_us = cpu_us;
+
+	return result;
+}
+
+/**
+ * @brief Returns the scheduling statistics of a thread.
+ *
+ * The worst wakeup latency is reset by each call.
+ *
+ * @param[in] threadp the thread
+ * @param[out] timing its statistics
+ * @return true if thread CPU time is measured on this host
+ */
+bool PIOS_Thread_Get_Timing(struct pios_thread *threadp, struct pios_thread_timing *timing)
+{
+	timing->cpu_time_us = thread_cpu_us(threadp);
+	timing->voluntary_switches = threadp->voluntary_switches;
+	timing->involuntary_switches = threadp->involuntary_switches;
+	timing->max_latency_us = __atomic_exchange_n(&threadp->max_latency_us,
+			0, __ATOMIC_RELAXED);
+
+	for (int i = 0; i < PIOS_THREAD_LATENCY_BUCKETS; i++) {
+		timing->latency_hist[i] = threadp->latency_hist[i];
+	}
+
+	return threadp->has_cpu_clock;
 }
 
 bool PIOS_Thread_Period_Elapsed(const uint32_t prev_systime,
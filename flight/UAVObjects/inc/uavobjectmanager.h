@@ -142,8 +142,24 @@ typedef struct {
 	uint32_t eventCallbackErrors;
 	uint32_t lastCallbackErrorID;
 	uint32_t lastQueueErrorID;
+	uint32_t lockContentions;	/** Times the object mutex was held by another task */
+	uint32_t lockFreeReadRetries;	/** Lockless reads that raced a writer */
+	uint32_t eventSelfUpdates;	/** Events a callback raised on its own object while others were pending (not delivered) */
+	uint8_t eventBacklogHighWater;	/** Most nested events waiting to be pumped at once */
 } UAVObjStats;
 
+/**
+ * In-place read of a data object instance, see UAVObjReadBegin().
+ * Must be zeroed before first use; callers should otherwise treat the
+ * contents as opaque.
+ */
+typedef struct {
+	UAVObjHandle obj;
+	uint32_t seq;
+	uint8_t attempts;
+	bool locked;
+} UAVObjReadView;
+
 typedef void (*new_uavo_instance_cb_t)(uint32_t,uint32_t);
 void UAVObjRegisterNewInstanceCB(new_uavo_instance_cb_t callback);
 
@@ -184,6 +200,8 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const vo
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId, void* dataOut);
 int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, void* dataOut, uint32_t offset, uint32_t size);
+const void *UAVObjReadBegin(UAVObjHandle obj_handle, uint16_t instId, UAVObjReadView *view);
+bool UAVObjReadEnd(UAVObjReadView *view);
 int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata* dataIn);
 int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata* dataOut);
 uint8_t UAVObjGetMetadataAccess(const UAVObjMetadata* dataOut);
@@ -74,6 +74,17 @@ static inline int32_t $(NAME)InstGet(uint16_t instId, $(NAME)Data *dataOut) { re
 
 static inline int32_t $(NAME)InstSet(uint16_t instId, const $(NAME)Data *dataIn) { return UAVObjSetInstanceData($(NAME)Handle(), instId, dataIn); }
 
+/**
+ * @function $(NAME)ReadBegin(view)
+ * @brief Read a $(NAME)Data object in place, see UAVObjReadBegin()
+ * @param[in,out] view zeroed read state, to be passed to $(NAME)ReadEnd()
+ */
+static inline const $(NAME)Data *$(NAME)ReadBegin(UAVObjReadView *view) { return UAVObjReadBegin($(NAME)Handle(), 0, view); }
+
+static inline const $(NAME)Data *$(NAME)InstReadBegin(uint16_t instId, UAVObjReadView *view) { return UAVObjReadBegin($(NAME)Handle(), instId, view); }
+
+static inline bool $(NAME)ReadEnd(UAVObjReadView *view) { return UAVObjReadEnd(view); }
+
 static inline int32_t $(NAME)ConnectQueue(struct pios_queue *queue) { return UAVObjConnectQueue($(NAME)Handle(), queue, EV_MASK_ALL_UPDATES); }
 
 static inline int32_t $(NAME)ConnectCallback(UAVObjEventCallback cb) { return UAVObjConnectCallback($(NAME)Handle(), cb, NULL, EV_MASK_ALL_UPDATES); }
@@ -34,6 +34,7 @@
  */
 
 #include "openpilot.h"
+#include "uavobjectsinit.h"
 #include <utlist.h>
 
 #include "pios_struct_helper.h"
@@ -81,11 +82,12 @@ struct ObjectEventEntryThrottled {
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-                                                  \-->[InstanceData1 [next]]
-                                                  _________...________/
-                                                  \-->[InstanceDataN [next]]
+  MultiInstance  == [UAVOBase [UAVOData [NumInstances [Chunks[] [InstanceData0]]]]]
+                                                 |
+                                                 +-->[InstanceData1 .. 4]
+                                                 +-->[InstanceData5 .. 12]
+                                                 +-->[InstanceData13 .. 28]
+                                                 ...
  */
 
 /*
@@ -116,6 +118,11 @@ struct UAVOMeta {
 struct UAVOData {
 	struct UAVOBase   base;
 	uint32_t          id;
+	/*
+	 * Write sequence count for lockless readers; odd while the
+	 * instance data is being modified.
+	 */
+	volatile uint32_t seq;
 	/*
 	 * Embed the Meta object as another complete UAVO
 	 * inside the payload for this UAVO.
@@ -125,33 +132,44 @@ struct UAVOData {
 	uint16_t          instance_size;
 } __attribute__((packed));
 
+/*
+ * Padding that brings a header of the given size up to a word boundary.
+ * Objects come from the heap, so this keeps instance data word aligned
+ * for readers that use it in place.
+ */
+#define UAVO_PAD_WORD(len) ((4 - ((len) % 4)) % 4)
+
 /* Augmented type for Single Instance Data UAVO */
 struct UAVOSingle {
 	struct UAVOData   uavo;
 
+	uint8_t           pad[UAVO_PAD_WORD(sizeof(struct UAVOData))];
 	uint8_t           instance0[];
-	/* 
+	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for this instance.
 	 */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-	struct UAVOMultiInst * next;
-	uint8_t                instance[];
-	/* 
-	 * Additional space will be malloc'd here to hold the
-	 * the data for this instance.
-	 */
-} __attribute__((packed));
+/*
+ * Instances after the first of a multi instance UAVO are kept in chunks
+ * that double in size, the first holding UAVO_CHUNK_BASE instances.  Any
+ * instance is then found with a couple of shifts instead of a list walk,
+ * and an object with N instances takes about log2(N) allocations.
+ */
+#define UAVO_CHUNK_BASE 4
+#define UAVO_NUM_CHUNKS 8
 
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
-	struct UAVOMultiInst   instance0;
+	uint8_t * volatile     chunks[UAVO_NUM_CHUNKS];
+	uint8_t                pad[UAVO_PAD_WORD(sizeof(struct UAVOData) +
+					sizeof(uint16_t) +
+					sizeof(uint8_t *) * UAVO_NUM_CHUNKS)];
+	uint8_t                instance0[];
 	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for instance 0.
@@ -171,14 +189,47 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
-#define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
+#define InstanceStride(obj) (((obj)->instance_size + 3) & ~3)
 #define InstanceData(instance) (void*)instance
 
+/*
+ * Hash index of the registered data objects, keyed by object ID.  The IDs
+ * are already hashes, so the slot is simply the ID modulo the table size,
+ * with linear probing on collision.  Metaobjects are not stored; they are
+ * found through their parent at MetaObjectId(id) - 1.
+ *
+ * Entries are only ever added, with the mutex held, and each one is
+ * published with a single pointer store once the object is completely set
+ * up.  This lets UAVObjGetByID() run without taking the mutex.  The table
+ * is sized for the generated object count at a load factor of at most 2/3;
+ * if more objects than that get registered (e.g. by a loadable extension)
+ * lookups fall back to walking the object list.
+ */
+#define UAVO_INDEX_SLOTS (UAVOBJECTS_COUNT + UAVOBJECTS_COUNT / 2 + 1)
+
+/*
+ * Number of times a lockless read is attempted before waiting on the
+ * mutex instead.  On a single core the writer we are racing against may
+ * be a lower priority task that we preempted, so spinning forever is not
+ * an option; taking the mutex lets priority inheritance finish the write.
+ */
+#define UAVO_READ_ATTEMPTS 3
+
+/*
+ * Depth of the ring of events raised from within event callbacks that are
+ * waiting to be pumped.  Targets may override this in pios_config.h.
+ */
+#ifndef UAVOBJ_EVENT_BACKLOG
+#define UAVOBJ_EVENT_BACKLOG 8
+#endif
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType event, void *obj_data, int len);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static int32_t readInstanceData(struct UAVOData *obj, uint16_t instId,
+			void *dataOut, uint32_t offset, uint32_t size);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
 			uint16_t interval);
@@ -187,6 +238,9 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 
 // Private variables
 static struct UAVOData * uavo_list;
+static struct UAVOData * volatile uavo_index[UAVO_INDEX_SLOTS];
+static uint16_t uavo_index_used;
+static bool uavo_index_overflow;
 static struct ObjectEventEntry * events_unused;
 static struct ObjectEventEntry * events_unused_throttled;
 static struct pios_recursive_mutex *mutex;
@@ -209,6 +263,54 @@ static new_uavo_instance_cb_t newUavObjInstanceCB;
 
 static void *cb_stack;
 
+/**
+ * Take the object manager mutex, counting the times that another task
+ * already held it.
+ */
+static void lockObjects(void)
+{
+	if (!PIOS_Recursive_Mutex_Lock(mutex, 0)) {
+		PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+		stats.lockContentions++;
+	}
+}
+
+/**
+ * Mark the start of a change to a data object's instance data.  Must be
+ * called with the mutex held.
+ */
+static inline void beginDataWrite(struct UAVOData *obj)
+{
+	obj->seq++;
+	__sync_synchronize();
+}
+
+/**
+ * Mark the end of a change started with beginDataWrite().
+ */
+static inline void endDataWrite(struct UAVOData *obj)
+{
+	__sync_synchronize();
+	obj->seq++;
+}
+
+/**
+ * Locate an instance (other than 0) of a multi instance object.
+ * \param[in] instId The object instance ID
+ * \param[out] chunk Which chunk holds the instance
+ * \param[out] slot Index of the instance within the chunk
+ */
+static inline void chunkOfInstance(uint16_t instId, uint16_t *chunk,
+		uint16_t *slot)
+{
+	/* Chunk k starts at instance UAVO_CHUNK_BASE * (2^k - 1) + 1 */
+	uint32_t n = (instId - 1) / UAVO_CHUNK_BASE + 1;
+
+	*chunk = 31 - __builtin_clz(n);
+	*slot = instId - 1 - UAVO_CHUNK_BASE * ((1 << *chunk) - 1);
+}
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -218,6 +320,9 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	memset((void *) uavo_index, 0, sizeof(uavo_index));
+	uavo_index_used = 0;
+	uavo_index_overflow = false;
 	events_unused = NULL;
 	events_unused_throttled = NULL;
 
@@ -249,7 +354,7 @@ int32_t UAVObjInitialize()
  */
 void UAVObjGetStats(UAVObjStats * statsOut)
 {
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	memcpy(statsOut, &stats, sizeof(UAVObjStats));
 	PIOS_Recursive_Mutex_Unlock(mutex);
 }
@@ -259,7 +364,7 @@ void UAVObjGetStats(UAVObjStats * statsOut)
  */
 void UAVObjClearStats()
 {
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	memset(&stats, 0, sizeof(UAVObjStats));
 	PIOS_Recursive_Mutex_Unlock(mutex);
 }
@@ -324,13 +429,59 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 	uavo_multi->num_instances = 1;
 
 	/* Clear the instance data carried in the UAVO */
-	uavo_multi->instance0.next = NULL;
-	memset (&(uavo_multi->instance0.instance), 0, num_bytes);
+	memset((void *) uavo_multi->chunks, 0, sizeof(uavo_multi->chunks));
+	memset(uavo_multi->instance0, 0, num_bytes);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_multi->uavo));
 }
 
+/**
+ * Add a data object to the ID index.  Must be called with the mutex held.
+ */
+static void UAVObjIndexInsert(struct UAVOData * uavo_data)
+{
+	/* Always keep one slot free so that probing terminates */
+	if (uavo_index_used >= UAVO_INDEX_SLOTS - 1) {
+		uavo_index_overflow = true;
+		return;
+	}
+
+	uint32_t slot = uavo_data->id % UAVO_INDEX_SLOTS;
+
+	while (uavo_index[slot]) {
+		if (++slot >= UAVO_INDEX_SLOTS)
+			slot = 0;
+	}
+
+	uavo_index_used++;
+
+	/* Make sure the object is visible before lockless readers find it */
+	__sync_synchronize();
+
+	uavo_index[slot] = uavo_data;
+}
+
+/**
+ * Find a data object in the ID index.  Safe to call without the mutex.
+ * \return The object or NULL if it is not indexed.
+ */
+static struct UAVOData * UAVObjIndexLookup(uint32_t id)
+{
+	uint32_t slot = id % UAVO_INDEX_SLOTS;
+	struct UAVOData * uavo_data;
+
+	while ((uavo_data = uavo_index[slot]) != NULL) {
+		if (uavo_data->id == id)
+			return uavo_data;
+
+		if (++slot >= UAVO_INDEX_SLOTS)
+			slot = 0;
+	}
+
+	return NULL;
+}
+
 /**************************
  * UAVObject Database APIs
  *************************/
@@ -352,7 +503,7 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 {
 	struct UAVOData * uavo_data = NULL;
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	/* Don't allow duplicate registrations */
 	if (UAVObjGetByID(id))
@@ -396,6 +547,9 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	UAVObjInstanceUpdated((UAVObjHandle) uavo_data, 0);
 	UAVObjInstanceUpdated((UAVObjHandle) &(uavo_data->metaObj), 0);
 
+	/* Only make the object visible to ID lookups once it is fully set up */
+	UAVObjIndexInsert(uavo_data);
+
 unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return (UAVObjHandle) uavo_data;
@@ -408,13 +562,26 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
+	struct UAVOData * tmp_obj;
+
+	tmp_obj = UAVObjIndexLookup(id);
+	if (tmp_obj)
+		return &tmp_obj->base;
+
+	/* A metaobject ID is one more than that of its parent */
+	tmp_obj = UAVObjIndexLookup(id - 1);
+	if (tmp_obj)
+		return &(tmp_obj->metaObj.base);
+
+	if (!uavo_index_overflow)
+		return NULL;
+
 	UAVObjHandle found_obj = NULL;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
-	// Look for object
-	struct UAVOData * tmp_obj;
+	// Index is full; look for object
 	LL_FOREACH(uavo_list, tmp_obj) {
 		if (tmp_obj->id == id) {
 			found_obj = &tmp_obj->base;
@@ -542,7 +709,7 @@ uint16_t UAVObjCreateInstance(UAVObjHandle obj_handle, UAVObjInitializeCallback
 	}
 
 	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	InstanceHandle instEntry;
 	uint16_t instId = 0;
@@ -620,7 +787,7 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 	PIOS_Assert(obj_handle);
 
 	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -653,12 +820,13 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 			}
 		}
 		// Set the data
-
 		target = InstanceData(instEntry);
 		len = obj->instance_size;
-	}
 
-	memcpy(target, dataIn, len);
+		beginDataWrite(obj);
+		memcpy(target, dataIn, len);
+		endDataWrite(obj);
+	}
 
 	// Fire event
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
@@ -682,31 +850,21 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	if (!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
 
-	int32_t rc = -1;
+		return readInstanceData(obj, instId, dataOut, 0, obj->instance_size);
+	}
 
-	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
+	// Lock
+	lockObjects();
 
-		// Cast handle to object
-		obj = (struct UAVOData *) obj_handle;
+	int32_t rc = -1;
 
-		// Get the instance
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Pack data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
+	if (instId != 0) {
+		goto unlock_exit;
 	}
+	memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
 
 	rc = 0;
 
@@ -825,33 +983,52 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 
 	void *target;
 	int len;
+	struct UAVOData *obj = NULL;
+
+	lockObjects();
+
+	int32_t rc = -1;
 
 	if (UAVObjIsMetaobject(obj_handle)) {
 		if (instId != 0)
-			return -1;
+			goto unlock_exit;
 
 		target = MetaDataPtr((struct UAVOMeta *)obj_handle);
 		len = UAVObjGetNumBytes(obj_handle);
 	} else {
+		obj = (struct UAVOData *) obj_handle;
 
-		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+		InstanceHandle instEntry = getInstance(obj, instId);
 
 		if (instEntry == NULL)
-			return -1;
+			goto unlock_exit;
 
 		target = InstanceData(instEntry);
 		len = UAVObjGetNumBytes(obj_handle);
 	}
 
 	// Load the object from the filesystem
-	int32_t rc;
 #if defined(PIOS_INCLUDE_FASTHEAP)
 	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
 			UAVObjGetID(obj_handle),
 			instId,
 			uavobj_load_trampoline,
 			len);
+
+	if (rc != 0) {
+		rc = -1;
+		goto unlock_exit;
+	}
+
+	if (obj)
+		beginDataWrite(obj);
+
+	memcpy(target, uavobj_load_trampoline, len);
 #else  /* PIOS_INCLUDE_FASTHEAP */
+	/* The filesystem writes straight into the instance data */
+	if (obj)
+		beginDataWrite(obj);
+
 	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
 			UAVObjGetID(obj_handle),
 			instId,
@@ -859,15 +1036,19 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 			len);
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
-	if (rc != 0)
-		return -1;
+	if (obj)
+		endDataWrite(obj);
 
-#if defined(PIOS_INCLUDE_FASTHEAP)
-	memcpy(target, uavobj_load_trampoline, len);
-#endif  /* PIOS_INCLUDE_FASTHEAP */
+	if (rc != 0) {
+		rc = -1;
+		goto unlock_exit;
+	}
 
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED, target, len);
-	return 0;
+
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
 }
 
 /**
@@ -892,7 +1073,7 @@ int32_t UAVObjSaveSettings()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -924,7 +1105,7 @@ int32_t UAVObjLoadSettings()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -956,7 +1137,7 @@ int32_t UAVObjDeleteSettings()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -988,7 +1169,7 @@ int32_t UAVObjSaveMetaobjects()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -1017,7 +1198,7 @@ int32_t UAVObjLoadMetaobjects()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -1046,7 +1227,7 @@ int32_t UAVObjDeleteMetaobjects()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -1138,7 +1319,7 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 	PIOS_Assert(obj_handle);
 
 	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
@@ -1188,7 +1369,13 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 	}
 
 	// Set data
-	memcpy(target + offset, dataIn, size);
+	if (UAVObjIsMetaobject(obj_handle)) {
+		memcpy(target + offset, dataIn, size);
+	} else {
+		beginDataWrite((struct UAVOData *)obj_handle);
+		memcpy(target + offset, dataIn, size);
+		endDataWrite((struct UAVOData *)obj_handle);
+	}
 
 	// Fire event
 	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED,
@@ -1200,6 +1387,64 @@ unlock_exit:
 	return rc;
 }
 
+/**
+ * Copy (part of) the data of a data object instance.  Readers do not take
+ * the mutex; instead the copy is retried if a writer touched the object
+ * while it was in progress.  If that keeps happening we wait on the mutex.
+ * \param[in] obj The data object
+ * \param[in] instId The object instance ID
+ * \param[out] dataOut Where to copy the data
+ * \param[in] offset Offset of the first byte to copy
+ * \param[in] size Number of bytes to copy
+ * \return 0 if success or -1 if failure
+ */
+static int32_t readInstanceData(struct UAVOData *obj, uint16_t instId,
+		void *dataOut, uint32_t offset, uint32_t size)
+{
+	InstanceHandle instEntry;
+
+	// Check for overrun
+	if ((size + offset) > obj->instance_size) {
+		return -1;
+	}
+
+	for (int i = 0; i < UAVO_READ_ATTEMPTS; i++) {
+		uint32_t seq = obj->seq;
+
+		if (!(seq & 1)) {
+			__sync_synchronize();
+
+			instEntry = getInstance(obj, instId);
+			if (instEntry == NULL) {
+				return -1;
+			}
+
+			memcpy(dataOut, InstanceData(instEntry) + offset, size);
+
+			__sync_synchronize();
+
+			if (obj->seq == seq) {
+				return 0;
+			}
+		}
+
+		stats.lockFreeReadRetries++;
+	}
+
+	lockObjects();
+
+	int32_t rc = -1;
+
+	instEntry = getInstance(obj, instId);
+	if (instEntry != NULL) {
+		memcpy(dataOut, InstanceData(instEntry) + offset, size);
+		rc = 0;
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
+}
+
 /**
  * Get the data of a specific object instance
  * \param[in] obj The object handle
@@ -1212,33 +1457,23 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	if (!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
 
-	int32_t rc = -1;
+		return readInstanceData(obj, instId, dataOut, 0, obj->instance_size);
+	}
 
-	if (UAVObjIsMetaobject(obj_handle)) {
-		// Get instance information
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
+	// Lock
+	lockObjects();
 
-		// Cast to object info
-		obj = (struct UAVOData *) obj_handle;
+	int32_t rc = -1;
 
-		// Get instance information
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
+	// Get instance information
+	if (instId != 0) {
+		goto unlock_exit;
 	}
+	// Set data
+	memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
 
 	rc = 0;
 
@@ -1258,51 +1493,123 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
+	if (!UAVObjIsMetaobject(obj_handle)) {
+		return readInstanceData((struct UAVOData *)obj_handle, instId,
+			dataOut, offset, size);
+	}
+
 	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	int32_t rc = -1;
 
-	if (UAVObjIsMetaobject(obj_handle)) {
-		// Get instance information
-		if (instId != 0) {
-			goto unlock_exit;
-		}
+	// Get instance information
+	if (instId != 0) {
+		goto unlock_exit;
+	}
 
-		// Check for overrun
-		if ((size + offset) > MetaNumBytes) {
-			goto unlock_exit;
-		}
+	// Check for overrun
+	if ((size + offset) > MetaNumBytes) {
+		goto unlock_exit;
+	}
 
-		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
-	} else {
-		struct UAVOData * obj;
-		InstanceHandle instEntry;
+	// Set data
+	memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
 
-		// Cast to object info
-		obj = (struct UAVOData *)obj_handle;
+	rc = 0;
 
-		// Get instance information
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
+}
 
-		// Check for overrun
-		if ((size + offset) > obj->instance_size) {
-			goto unlock_exit;
+/**
+ * Start reading a data object instance in place, without copying it.
+ * The returned pointer may only be dereferenced until UAVObjReadEnd(),
+ * which reports whether a writer changed the data in the meantime; if it
+ * did the values read must be discarded and the read started again:
+ *
+ *   UAVObjReadView view = { 0 };
+ *   do {
+ *     const GyrosData *g = GyrosReadBegin(&view);
+ *     rate = g->z;
+ *   } while (!GyrosReadEnd(&view));
+ *
+ * After repeated races the view falls back to holding the mutex until
+ * UAVObjReadEnd(), so the loop always terminates.
+ * \param[in] obj_handle The data object handle
+ * \param[in] instId The object instance ID
+ * \param[in,out] view Read state, zeroed before the first attempt
+ * \return Pointer to the instance data or NULL if it does not exist
+ */
+const void *UAVObjReadBegin(UAVObjHandle obj_handle, uint16_t instId,
+		UAVObjReadView *view)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(!UAVObjIsMetaobject(obj_handle));
+
+	struct UAVOData *obj = (struct UAVOData *) obj_handle;
+	InstanceHandle instEntry;
+
+	view->obj = obj_handle;
+
+	while (view->attempts < UAVO_READ_ATTEMPTS) {
+		view->seq = obj->seq;
+
+		if (!(view->seq & 1)) {
+			__sync_synchronize();
+
+			instEntry = getInstance(obj, instId);
+			if (instEntry == NULL) {
+				return NULL;
+			}
+
+			return InstanceData(instEntry);
 		}
-		
-		// Set data
-		memcpy(dataOut, InstanceData(instEntry) + offset, size);
+
+		view->attempts++;
+		stats.lockFreeReadRetries++;
 	}
 
-	rc = 0;
+	lockObjects();
+	view->locked = true;
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	instEntry = getInstance(obj, instId);
+	if (instEntry == NULL) {
+		view->locked = false;
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return NULL;
+	}
+
+	return InstanceData(instEntry);
+}
+
+/**
+ * Finish a read started with UAVObjReadBegin().
+ * \param[in,out] view Read state passed to UAVObjReadBegin()
+ * \return true if the data read was consistent, false if the read must be
+ * repeated
+ */
+bool UAVObjReadEnd(UAVObjReadView *view)
+{
+	if (view->locked) {
+		view->locked = false;
+		view->attempts = 0;
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return true;
+	}
+
+	__sync_synchronize();
+
+	if (((struct UAVOData *) view->obj)->seq == view->seq) {
+		view->attempts = 0;
+		return true;
+	}
+
+	view->attempts++;
+	stats.lockFreeReadRetries++;
+
+	return false;
 }
 
 /**
@@ -1320,7 +1627,7 @@ int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata * dataIn
 		return -1;
 	}
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	UAVObjSetData((UAVObjHandle) MetaObjectPtr((struct UAVOData *)obj_handle), dataIn);
 
@@ -1339,7 +1646,7 @@ int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata * dataOut)
 	PIOS_Assert(obj_handle);
 
 	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	// Get metadata
 	if (UAVObjIsMetaobject(obj_handle)) {
@@ -1514,7 +1821,7 @@ int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle,
 	PIOS_Assert(obj_handle);
 	PIOS_Assert(queue);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	res = connectObj(obj_handle, queue, NULL, NULL, eventMask, interval);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
@@ -1537,7 +1844,7 @@ int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue)
 	PIOS_Assert(obj_handle);
 	PIOS_Assert(queue);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	res = disconnectObj(obj_handle, queue, NULL, NULL);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
@@ -1592,7 +1899,7 @@ int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallb
 {
 	PIOS_Assert(obj_handle);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	res = connectObj(obj_handle, 0, cb, cbCtx, eventMask, interval);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
@@ -1615,7 +1922,7 @@ int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb
 {
 	PIOS_Assert(obj_handle);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	res = disconnectObj(obj_handle, 0, cb, cbCtx);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
@@ -1638,7 +1945,7 @@ void UAVObjUpdated(UAVObjHandle obj_handle)
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	sendEvent((struct UAVOBase *) obj_handle, instId, EV_UPDATED_MANUAL,
 		NULL, 0);
 	PIOS_Recursive_Mutex_Unlock(mutex);
@@ -1654,7 +1961,7 @@ void UAVObjIterate(void (*iterator) (UAVObjHandle obj))
 	PIOS_Assert(iterator);
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	// Iterate through the list and invoke iterator for each object
 	struct UAVOData *obj;
@@ -1765,14 +2072,6 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType triggered_event,
 			void *obj_data, int len)
 {
-	static uint8_t num_pending = 0;
-
-	static struct PendEvent {
-		UAVObjEvent msg;
-		void *obj_data;
-		int len;
-	} pending_events[3];
-
 	/* The logic to spool up callbacks here may be a little confusing.
 	 * basically, this relies on the fact that we are in a re-entrant
 	 * locked section.  If we get in here and the static variable
@@ -1782,20 +2081,44 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	 * In other words, while executing a callback it did a uav object
 	 * update that will trigger in turn more callbacks.
 	 *
-	 * To handle this, we have a small buffer to store the pending
-	 * callbacks.
+	 * To handle this, the nested events are put in a ring and pumped
+	 * in order by the outermost sendEvent once the running callback
+	 * returns.  Callbacks run on a single dedicated stack, so they can
+	 * never be invoked recursively.  Because the whole thing happens
+	 * with the mutex held, only one task at a time can be using the
+	 * ring, so it is effectively per task.
 	 *
 	 * We also make the point of disallowing a callback from generating
-	 * the exact same callback.  This is relevant to things like
-	 * the session managing object in telemetry.  While it is possible
-	 * to do this safely (by "stopping" the quasi-recursion) it seems
-	 * better to disallow it.
+	 * the exact same callback while other events are pending.  When
+	 * nothing else is pending, the update is queued and delivered after
+	 * the callback returns, never recursively; the session managing
+	 * object in telemetry answers the GCS this way.  A callback that
+	 * updates its own object unconditionally will keep getting called.
 	 *
 	 * However, infinite loops are still possible; callback A can
 	 * trigger callback B which triggers callback A.  Don't do that.
 	 */
+	static struct PendEvent {
+		UAVObjEvent msg;
+		void *obj_data;
+		int len;
+	} pending_events[UAVOBJ_EVENT_BACKLOG];
+
+	static uint8_t pending_head = 0;
+	static uint8_t num_pending = 0;
+	static struct UAVOBase *in_progress = NULL;
 
-	if (num_pending >= 3) {
+	if (num_pending && in_progress == obj) {
+		/* We don't fire events of the same type generated by
+		 * an event callback while others are still waiting.
+		 * With nothing else pending, the update is delivered
+		 * once the callback returns. */
+		stats.eventSelfUpdates++;
+
+		return -1;
+	}
+
+	if (num_pending >= UAVOBJ_EVENT_BACKLOG) {
 		/* Unable to pump event; backlog too long */
 		stats.eventCallbackErrors++;
 		stats.lastCallbackErrorID = UAVObjGetID(obj);
@@ -1803,43 +2126,43 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 		return -1;
 	}
 
-	static struct UAVOBase *in_progress = NULL;
+	struct PendEvent *pend =
+		&pending_events[(pending_head + num_pending) % UAVOBJ_EVENT_BACKLOG];
 
-	if (num_pending) {
-		if (in_progress == obj) {
-			return -1;	/* We don't fire events
-					 * of the same type generated by
-					 * an event callback. */
-		}
-	}
-
-	pending_events[num_pending].msg = (UAVObjEvent) {
+	pend->msg = (UAVObjEvent) {
 		.obj    = obj,
 		.event  = triggered_event,
 		.instId = instId
 	};
 
-	pending_events[num_pending].obj_data = obj_data;
-	pending_events[num_pending].len = len;
+	pend->obj_data = obj_data;
+	pend->len = len;
 
 	num_pending++;
 
-	/* Only enter the section of pumping events if we are the "first event" */
-	if (!in_progress) {
-		/* While there are events to pump.. */
-		while (num_pending) {
-			/* Deallocate the top one.. */
-			num_pending--;
-
-			/* Mask off events of the same type resulting from
-			 * the callback... */
-			in_progress = pending_events[num_pending].msg.obj;
-
-			/* And pump the event. */
-			pumpOneEvent(pending_events[num_pending].msg,
-				pending_events[num_pending].obj_data,
-				pending_events[num_pending].len);
-		}
+	if (num_pending > stats.eventBacklogHighWater) {
+		stats.eventBacklogHighWater = num_pending;
+	}
+
+	/* Only the "first event" pumps; nested events wait their turn */
+	if (in_progress) {
+		return 0;
+	}
+
+	/* While there are events to pump.. */
+	while (num_pending) {
+		/* Take the oldest one off the ring.. */
+		struct PendEvent ev = pending_events[pending_head];
+
+		pending_head = (pending_head + 1) % UAVOBJ_EVENT_BACKLOG;
+		num_pending--;
+
+		/* Mask off events of the same type resulting from
+		 * the callback... */
+		in_progress = ev.msg.obj;
+
+		/* And pump the event. */
+		pumpOneEvent(ev.msg, ev.obj_data, ev.len);
 	}
 
 	in_progress = NULL;
@@ -1852,7 +2175,8 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
-	struct UAVOMultiInst *instEntry;
+	struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj;
+	uint8_t *instEntry;
 
 	/* Don't allow more than one instance for single instance objects */
 	if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1877,14 +2201,30 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		}
 	}
 
-	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
-	if (!instEntry)
+	/* Find the chunk for the new instance, allocating it if need be */
+	uint16_t chunk, slot;
+	chunkOfInstance(instId, &chunk, &slot);
+
+	if (chunk >= UAVO_NUM_CHUNKS) {
 		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
-	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
+	}
+
+	if (uavo_multi->chunks[chunk] == NULL) {
+		uint8_t *data = PIOS_malloc_no_dma(
+			(UAVO_CHUNK_BASE << chunk) * InstanceStride(obj));
+		if (!data)
+			return NULL;
+
+		uavo_multi->chunks[chunk] = data;
+	}
 
-	( (struct UAVOMulti*)obj )->num_instances++;
+	instEntry = uavo_multi->chunks[chunk] + slot * InstanceStride(obj);
+	memset(instEntry, 0, obj->instance_size);
+
+	/* Lockless readers check the count first; publish a complete entry */
+	__sync_synchronize();
+
+	uavo_multi->num_instances++;
 
 	// Fire event
 	UAVObjInstanceUpdated((UAVObjHandle) obj, instId);
@@ -1893,7 +2233,7 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	if (newUavObjInstanceCB) {
 		newUavObjInstanceCB(obj->id, UAVObjGetNumInstances(&obj->base));
 	}
-	return InstanceDataOffset(instEntry);
+	return instEntry;
 }
 
 /**
@@ -1927,17 +2267,17 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
-		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
-			}
-		}
-		/* Instance was not found */
-		return NULL;
+		if (instId == 0)
+			return uavo_multi->instance0;
+
+		uint16_t chunk, slot;
+		chunkOfInstance(instId, &chunk, &slot);
+
+		uint8_t *data = uavo_multi->chunks[chunk];
+		if (data == NULL)
+			return NULL;
+
+		return data + slot * InstanceStride(obj);
 	}
 }
 
@@ -2002,7 +2342,7 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 		unused = &events_unused_throttled;
 	}
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 	if (*unused != NULL) {
 		// We can re-use the memory of a previously disconnected event
 		event = *unused;
@@ -2063,7 +2403,7 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 				((!event->cb) && event->cbInfo.queue == queue)) {
 			LL_DELETE(obj->next_event, event);
 			// store the unused memory for future reuse
-			PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+			lockObjects();
 			if (event->hasThrottle) {
 				LL_APPEND(events_unused_throttled, event);
 			}
@@ -2114,7 +2454,7 @@ uint8_t UAVObjCount()
 {
 	uint8_t count = 0;
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	// Look for object
 	struct UAVOData * tmp_obj;
@@ -2135,7 +2475,7 @@ uint32_t UAVObjIDByIndex(uint8_t index)
 {
 	uint8_t count = 0;
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockObjects();
 
 	// Look for object
 	struct UAVOData * tmp_obj;
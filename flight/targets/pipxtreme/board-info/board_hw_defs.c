@@ -635,6 +635,7 @@ static const struct flashfs_logfs_cfg flashfs_internal_settings_cfg = {
 	.fs_magic      = 0x9ae1ee11,
 	.arena_size    = 0x00002000,       /* 32 * slot size = 8K bytes = 4 sectors */
 	.slot_size     = 0x00000100,       /* 256 bytes */
+	.index_entries = 8,                /* enough for the few settings a PipX keeps */
 };
 
 #include "pios_flash_internal_priv.h"
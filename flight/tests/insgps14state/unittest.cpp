@@ -0,0 +1,331 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memcpy */
+#include <math.h>		/* fabsf */
+#include <time.h>		/* clock_gettime */
+
+#define NUMX 14
+#define NUMW 10
+#define NUMV 10
+
+extern "C" {
+
+#include "insgps.h"
+
+/* The filter's working state, to compare against a reference */
+extern float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];
+extern float Be[3];
+extern float P[NUMX][NUMX], X[NUMX];
+extern float Q[NUMW], R[NUMV];
+
+void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+			  float Q[NUMW], float dT, float P[NUMX][NUMX]);
+void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+		  uint16_t SensorsUsed);
+void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
+
+}
+
+static double now_s()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Straight from the equations, with dense matrices: the general method
+ * the filter used to have.
+ */
+static void __attribute__((noinline)) dense_prediction(float F[NUMX][NUMX],
+		float G[NUMX][NUMW], float Q[NUMW], float dT, float P[NUMX][NUMX])
+{
+	float Dummy[NUMX][NUMX];
+	float dTsq = dT * dT;
+
+	for (int i = 0; i < NUMX; i++)
+		for (int j = 0; j < NUMX; j++) {
+			Dummy[i][j] = P[i][j] / dT;
+			for (int k = 0; k < NUMX; k++)
+				Dummy[i][j] += F[i][k] * P[k][j];
+		}
+
+	for (int i = 0; i < NUMX; i++)
+		for (int j = i; j < NUMX; j++) {
+			P[i][j] = Dummy[i][j] / dT;
+			for (int k = 0; k < NUMX; k++)
+				P[i][j] += Dummy[i][k] * F[j][k];
+			for (int k = 0; k < NUMW; k++)
+				P[i][j] += Q[k] * G[i][k] * G[j][k];
+			P[j][i] = P[i][j] = P[i][j] * dTsq;
+		}
+}
+
+static void __attribute__((noinline)) dense_update(float H[NUMV][NUMX],
+		float R[NUMV], float Z[NUMV], float Y[NUMV], float P[NUMX][NUMX],
+		float X[NUMX], uint16_t SensorsUsed)
+{
+	float HP[NUMX], K[NUMX], HPHR, Error;
+
+	for (int m = 0; m < NUMV; m++) {
+		if (!(SensorsUsed & (0x01 << m)))
+			continue;
+
+		for (int j = 0; j < NUMX; j++) {
+			HP[j] = 0.0f;
+			for (int k = 0; k < NUMX; k++)
+				HP[j] += H[m][k] * P[k][j];
+		}
+
+		HPHR = R[m];
+		for (int k = 0; k < NUMX; k++)
+			HPHR += HP[k] * H[m][k];
+
+		for (int k = 0; k < NUMX; k++)
+			K[k] = HP[k] / HPHR;
+
+		for (int i = 0; i < NUMX; i++)
+			for (int j = i; j < NUMX; j++)
+				P[i][j] = P[j][i] = P[i][j] - K[i] * HP[j];
+
+		Error = Z[m] - Y[m];
+		for (int i = 0; i < NUMX; i++)
+			X[i] = X[i] + K[i] * Error;
+	}
+}
+
+/*
+ * Puts the filter in a moving, tilted state with a covariance that has
+ * had time to develop correlations between all the states.
+ */
+static void settle_filter()
+{
+	const float pos[3] = { 1, 2, -3 };
+	const float vel[3] = { 0.5f, -0.3f, 0.1f };
+	const float gyro_bias[3] = { 0.01f, -0.02f, 0.005f };
+	const float accel_bias[3] = { 0, 0, 0.05f };
+	float q[4] = { 0.9f, 0.1f, -0.2f, 0.3f };
+
+	float qmag = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (int i = 0; i < 4; i++)
+		q[i] /= qmag;
+
+	INSGPSInit();
+	INSSetState(pos, vel, q, gyro_bias, accel_bias);
+
+	for (int i = 0; i < 500; i++) {
+		const float gyro[3] = { 0.1f * sinf(i * 0.01f), 0.2f, -0.05f };
+		const float accel[3] = { 0.3f, -0.2f, -9.6f };
+
+		INSStatePrediction(gyro, accel, 0.002f);
+		INSCovariancePrediction(0.002f);
+
+		if (i % 10 == 0) {
+			const float mag[3] = { 0.5f, 0.1f, 0.8f };
+
+			INSCorrection(mag, pos, vel, 3, FULL_SENSORS);
+		}
+	}
+}
+
+/* Largest difference, relative to the standard deviations involved */
+static float covariance_error(float A[NUMX][NUMX], float B[NUMX][NUMX])
+{
+	float worst = 0;
+
+	for (int i = 0; i < NUMX; i++)
+		for (int j = 0; j < NUMX; j++) {
+			float err = fabsf(A[i][j] - B[i][j]) /
+				sqrtf(B[i][i] * B[j][j]);
+
+			if (err > worst)
+				worst = err;
+		}
+
+	return worst;
+}
+
+class INSGPS14 : public testing::Test {
+protected:
+	virtual void SetUp() {
+		settle_filter();
+	}
+};
+
+TEST_F(INSGPS14, PredictionMatchesDense) {
+	float Pref[NUMX][NUMX];
+
+	for (int i = 0; i < 100; i++) {
+		memcpy(Pref, P, sizeof(P));
+
+		CovariancePrediction(F, G, Q, 0.002f, P);
+		dense_prediction(F, G, Q, 0.002f, Pref);
+
+		ASSERT_LT(covariance_error(P, Pref), 1e-5f) << "step " << i;
+	}
+
+	// The bias random walk reaches the biases
+	memset(P, 0, sizeof(P));
+	CovariancePrediction(F, G, Q, 0.01f, P);
+
+	for (int i = 0; i < 4; i++)
+		EXPECT_FLOAT_EQ(Q[6 + i] * 1e-4f, P[10 + i][10 + i]);
+};
+
+TEST_F(INSGPS14, UpdateMatchesDense) {
+	float Pref[NUMX][NUMX], Xref[NUMX];
+	float Z[NUMV], Y[NUMV];
+
+	LinearizeH(X, Be, H);
+	MeasurementEq(X, Be, Y);
+
+	for (int i = 0; i < NUMV; i++)
+		Z[i] = Y[i] + 0.1f * ((i % 3) - 1);
+
+	const uint16_t sensors[] = { FULL_SENSORS, POS_SENSORS, HORIZ_VEL_SENSORS,
+		MAG_SENSORS, BARO_SENSOR, POS_SENSORS | BARO_SENSOR };
+
+	for (unsigned s = 0; s < sizeof(sensors) / sizeof(sensors[0]); s++) {
+		memcpy(Pref, P, sizeof(P));
+		memcpy(Xref, X, sizeof(X));
+
+		SerialUpdate(H, R, Z, Y, P, X, sensors[s]);
+		dense_update(H, R, Z, Y, Pref, Xref, sensors[s]);
+
+		ASSERT_LT(covariance_error(P, Pref), 1e-5f) << "sensors " << sensors[s];
+
+		for (int i = 0; i < NUMX; i++)
+			ASSERT_NEAR(Xref[i], X[i], 1e-5f) << "sensors " << sensors[s];
+	}
+};
+
+TEST_F(INSGPS14, BatchedPredictionMatchesSteps) {
+	float Pref[NUMX][NUMX];
+
+	memcpy(Pref, P, sizeof(P));
+
+	for (int i = 0; i < 10; i++)
+		CovariancePrediction(F, G, Q, 0.001f, Pref);
+
+	INSCovariancePredictionBatch(0.01f, 10);
+
+	// Only first order in the number of steps, so not exact
+	EXPECT_LT(covariance_error(P, Pref), 1e-3f);
+
+	// but the process noise adds up as it does step by step; the biases
+	// have no dynamics, so they show just that
+	memset(Pref, 0, sizeof(Pref));
+	memset(P, 0, sizeof(P));
+
+	for (int i = 0; i < 10; i++)
+		CovariancePrediction(F, G, Q, 0.001f, Pref);
+
+	INSCovariancePredictionBatch(0.01f, 10);
+
+	for (int i = 10; i < NUMX; i++)
+		EXPECT_NEAR(Pref[i][i], P[i][i], 1e-5f * Pref[i][i]);
+};
+
+TEST_F(INSGPS14, StaysSymmetric) {
+	for (int i = 0; i < NUMX; i++)
+		for (int j = 0; j < NUMX; j++)
+			ASSERT_EQ(P[i][j], P[j][i]);
+};
+
+/*
+ * Microseconds per covariance prediction and per full update, against
+ * the dense implementation (on this machine, so only the proportions
+ * carry over to flight).
+ */
+TEST_F(INSGPS14, Benchmark) {
+	const int runs = 20000;
+	float Pinit[NUMX][NUMX], Xinit[NUMX];
+	float Z[NUMV], Y[NUMV];
+
+	memcpy(Pinit, P, sizeof(P));
+	memcpy(Xinit, X, sizeof(X));
+
+	LinearizeH(X, Be, H);
+	MeasurementEq(X, Be, Y);
+	memcpy(Z, Y, sizeof(Z));
+
+	double start = now_s();
+	for (int i = 0; i < runs; i++) {
+		memcpy(P, Pinit, sizeof(P));
+		dense_prediction(F, G, Q, 0.002f, P);
+	}
+	double dense_predict = (now_s() - start) * 1e6 / runs;
+
+	start = now_s();
+	for (int i = 0; i < runs; i++) {
+		memcpy(P, Pinit, sizeof(P));
+		CovariancePrediction(F, G, Q, 0.002f, P);
+	}
+	double sparse_predict = (now_s() - start) * 1e6 / runs;
+
+	start = now_s();
+	for (int i = 0; i < runs; i++) {
+		memcpy(P, Pinit, sizeof(P));
+		memcpy(X, Xinit, sizeof(X));
+		dense_update(H, R, Z, Y, P, X, FULL_SENSORS);
+	}
+	double dense_correct = (now_s() - start) * 1e6 / runs;
+
+	start = now_s();
+	for (int i = 0; i < runs; i++) {
+		memcpy(P, Pinit, sizeof(P));
+		memcpy(X, Xinit, sizeof(X));
+		SerialUpdate(H, R, Z, Y, P, X, FULL_SENSORS);
+	}
+	double sparse_correct = (now_s() - start) * 1e6 / runs;
+
+	printf("predict: dense %.2f us, sparse %.2f us; "
+			"full update: dense %.2f us, sparse %.2f us\n",
+			dense_predict, sparse_predict, dense_correct, sparse_correct);
+
+	EXPECT_LT(sparse_predict, dense_predict);
+	EXPECT_LT(sparse_correct, dense_correct);
+};
+
+/**
+ * @}
+ * @}
+ */
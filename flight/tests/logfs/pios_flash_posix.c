@@ -2,6 +2,7 @@
 #include <stdio.h>		/* fopen/fread/fwrite/fseek */
 #include <assert.h>		/* assert */
 #include <string.h>		/* memset */
+#include <unistd.h>		/* usleep */
 
 #include <stdbool.h>
 #include "pios_heap.h"
@@ -17,8 +18,38 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+
+	/* Writes and erases still allowed before the power goes, or < 0 */
+	int32_t power_cut_after;
+	uint32_t num_writes;
+	uint32_t num_erases;
+	uint32_t num_reads;
+
+	/* Time each write takes, to model page programming */
+	uint32_t program_time_us;
 };
 
+/*
+ * Simulate a power cut: the operation that uses up the budget is only half
+ * done, and every write or erase after it fails without touching the flash.
+ */
+static bool PIOS_Flash_Posix_PowerLeft(struct flash_posix_dev * flash_dev, bool * torn)
+{
+	*torn = false;
+
+	if (flash_dev->power_cut_after < 0) {
+		return true;
+	}
+
+	if (flash_dev->power_cut_after == 0) {
+		return false;
+	}
+
+	*torn = (--flash_dev->power_cut_after == 0);
+
+	return true;
+}
+
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
 {
 	struct flash_posix_dev * flash_dev = PIOS_malloc(sizeof(struct flash_posix_dev));
@@ -42,6 +73,11 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 
 	flash_dev->cfg = cfg;
 	flash_dev->transaction_in_progress = false;
+	flash_dev->power_cut_after = -1;
+	flash_dev->num_writes = 0;
+	flash_dev->num_erases = 0;
+	flash_dev->num_reads = 0;
+	flash_dev->program_time_us = 0;
 
 	flash_dev->flash_file = fopen ("theflash.bin", "r+");
 	if (flash_dev->flash_file == NULL) {
@@ -68,6 +104,35 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 	PIOS_free(flash_dev);
 }
 
+void PIOS_Flash_Posix_SetPowerCut(uintptr_t chip_id, int32_t ops_left)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	flash_dev->power_cut_after = ops_left;
+}
+
+void PIOS_Flash_Posix_SetProgramTime(uintptr_t chip_id, uint32_t program_time_us)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	flash_dev->program_time_us = program_time_us;
+}
+
+void PIOS_Flash_Posix_GetOps(uintptr_t chip_id, uint32_t * num_writes, uint32_t * num_erases)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	*num_writes = flash_dev->num_writes;
+	*num_erases = flash_dev->num_erases;
+}
+
+uint32_t PIOS_Flash_Posix_GetReads(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	return flash_dev->num_reads;
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -113,6 +178,13 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	/* assert(flash_dev->transaction_in_progress); */
 
+	bool torn;
+	if (!PIOS_Flash_Posix_PowerLeft(flash_dev, &torn)) {
+		return -1;
+	}
+
+	flash_dev->num_erases++;
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -121,10 +193,13 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	memset((void *)buf, 0xFF, flash_dev->cfg->size_of_sector);
 
+	/* A torn erase leaves the end of the sector as it was */
+	uint32_t len = torn ? flash_dev->cfg->size_of_sector / 2 : flash_dev->cfg->size_of_sector;
+
 	size_t s;
-	s = fwrite (buf, 1, flash_dev->cfg->size_of_sector, flash_dev->flash_file);
+	s = fwrite (buf, 1, len, flash_dev->flash_file);
 
-	assert (s == flash_dev->cfg->size_of_sector);
+	assert (s == len);
 
 	fflush(flash_dev->flash_file);
 
@@ -140,10 +215,22 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	/* assert(flash_dev->transaction_in_progress); */
 
+	bool torn;
+	if (!PIOS_Flash_Posix_PowerLeft(flash_dev, &torn)) {
+		return -1;
+	}
+
+	flash_dev->num_writes++;
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
 
+	/* A torn write only gets the first half of the data out */
+	if (torn) {
+		len /= 2;
+	}
+
 	size_t s;
 	s = fwrite (data, 1, len, flash_dev->flash_file);
 
@@ -151,6 +238,10 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	fflush(flash_dev->flash_file);
 
+	if (flash_dev->program_time_us) {
+		usleep(flash_dev->program_time_us);
+	}
+
 	return 0;
 }
 
@@ -172,6 +263,8 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert (s == len);
 
+	flash_dev->num_reads++;
+
 	return 0;
 }
 
@@ -7,5 +7,9 @@ struct pios_flash_posix_cfg {
 
 int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix_cfg * cfg);
 void PIOS_Flash_Posix_Destroy(uintptr_t chip_id);
+void PIOS_Flash_Posix_SetPowerCut(uintptr_t chip_id, int32_t ops_left);
+void PIOS_Flash_Posix_SetProgramTime(uintptr_t chip_id, uint32_t program_time_us);
+void PIOS_Flash_Posix_GetOps(uintptr_t chip_id, uint32_t * num_writes, uint32_t * num_erases);
+uint32_t PIOS_Flash_Posix_GetReads(uintptr_t chip_id);
 
 extern const struct pios_flash_driver pios_posix_flash_driver;
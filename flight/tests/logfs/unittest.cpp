@@ -36,6 +36,8 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <vector>
 
 extern "C" {
 
@@ -54,6 +56,7 @@ extern struct pios_flash_posix_cfg flash_config;
 #include "pios_flashfs_logfs_priv.h"
 
 extern struct flashfs_logfs_cfg flashfs_config_settings;
+extern struct flashfs_logfs_cfg flashfs_config_settings_small_index;
 extern struct flashfs_logfs_cfg flashfs_config_waypoints;
 
 #include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
@@ -424,3 +427,407 @@ TEST_F(LogfsTestCookedMultiPart, WriteLarge) {
   memset(obj4_check, 0, sizeof(obj4_check));
   EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id_b, OBJ4_ID, 0, obj4_check, sizeof(obj4_check)));
 }
+
+static double now_s()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Number of distinct object instances, more than the small index can hold */
+#define INDEX_TEST_INSTANCES 150
+
+class LogfsTestIndex : public LogfsTestRaw {
+protected:
+  virtual void SetUp() {
+    LogfsTestRaw::SetUp();
+
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+  }
+
+  virtual void TearDown() {
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  }
+
+  /* Give every instance of obj1 its own contents */
+  void make_instance(unsigned char *obj, uint16_t inst_id, uint8_t generation) {
+    for (uint32_t i = 0; i < OBJ1_SIZE; i++) {
+      obj[i] = inst_id + generation * 7 + i;
+    }
+  }
+
+  void verify_instances(uintptr_t fs_id, uint8_t generation) {
+    unsigned char expected[OBJ1_SIZE];
+    unsigned char obj1_check[OBJ1_SIZE];
+
+    for (uint16_t inst = 0; inst < INDEX_TEST_INSTANCES; inst++) {
+      make_instance(expected, inst, generation);
+      memset(obj1_check, 0, sizeof(obj1_check));
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, inst, obj1_check, sizeof(obj1_check))) << "instance " << inst;
+      ASSERT_EQ(0, memcmp(expected, obj1_check, sizeof(expected))) << "instance " << inst;
+    }
+  }
+
+  void save_instances(uintptr_t fs_id, uint8_t generation) {
+    unsigned char obj[OBJ1_SIZE];
+
+    for (uint16_t inst = 0; inst < INDEX_TEST_INSTANCES; inst++) {
+      make_instance(obj, inst, generation);
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, inst, obj, sizeof(obj)));
+    }
+  }
+};
+
+TEST_F(LogfsTestIndex, RemountRebuildsIndex) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  /* Two generations leave obsolete slots behind and force a gc */
+  save_instances(fs_id, 0);
+  save_instances(fs_id, 1);
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 3));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 3, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, INDEX_TEST_INSTANCES, obj1_check, sizeof(obj1_check)));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+  /* Put back the deleted instance so the whole generation can be checked */
+  unsigned char obj[OBJ1_SIZE];
+  make_instance(obj, 3, 1);
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 3, obj, sizeof(obj)));
+  verify_instances(fs_id, 1);
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndex, BoundedIndexFallsBackToScan) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings_small_index, FLASH_PARTITION_LABEL_SETTINGS));
+
+  for (uint8_t generation = 0; generation < 4; generation++) {
+    save_instances(fs_id, generation);
+    verify_instances(fs_id, generation);
+  }
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 0));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, INDEX_TEST_INSTANCES - 1));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, INDEX_TEST_INSTANCES - 1, obj1_check, sizeof(obj1_check)));
+
+  /* The full index sees the same filesystem */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+
+  unsigned char expected[OBJ1_SIZE];
+  make_instance(expected, 1, 3);
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 1, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(expected, obj1_check, sizeof(expected)));
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+/*
+ * Boot loads every settings object, most of which were never saved, so
+ * time a mount followed by a load of each stored instance and of as many
+ * missing ones; then the latency of saving over existing instances.  The
+ * small index stands in for the scanning lookups.  Only the flash reads
+ * are checked, the timings are just reported.
+ */
+TEST_F(LogfsTestIndex, BootAndSaveLatency) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  save_instances(fs_id, 0);
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+
+  const struct flashfs_logfs_cfg *cfgs[] = {
+    &flashfs_config_settings,
+    &flashfs_config_settings_small_index,
+  };
+  double boot[2], save[2];
+  uint32_t boot_reads[2];
+
+  for (int c = 0; c < 2; c++) {
+    unsigned char obj[OBJ1_SIZE];
+    const int rounds = 20;
+
+    uint32_t reads_before = PIOS_Flash_Posix_GetReads(pios_posix_flash_id);
+    double start = now_s();
+    for (int r = 0; r < rounds; r++) {
+      ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+
+      for (uint16_t inst = 0; inst < INDEX_TEST_INSTANCES; inst++) {
+        ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, inst, obj, sizeof(obj)));
+        ASSERT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, inst, obj, sizeof(obj)));
+      }
+
+      PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    }
+    boot[c] = (now_s() - start) / rounds;
+    boot_reads[c] = (PIOS_Flash_Posix_GetReads(pios_posix_flash_id) - reads_before) / rounds;
+
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+
+    const int saves = 2000;
+    start = now_s();
+    for (int i = 0; i < saves; i++) {
+      uint16_t inst = (i * 37) % INDEX_TEST_INSTANCES;
+      make_instance(obj, inst, 0);
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, inst, obj, sizeof(obj)));
+    }
+    save[c] = (now_s() - start) / saves;
+
+    verify_instances(fs_id, 0);
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  }
+
+  printf("%d instances: boot %.2f ms (%u reads) indexed, %.2f ms (%u reads) scanning; "
+    "save %.1f us indexed, %.1f us scanning\n", INDEX_TEST_INSTANCES,
+    boot[0] * 1e3, boot_reads[0], boot[1] * 1e3, boot_reads[1],
+    save[0] * 1e6, save[1] * 1e6);
+
+  EXPECT_LT(boot_reads[0], boot_reads[1]);
+}
+
+/* Number of settings-like objects for the garbage collection tests */
+#define GC_TEST_INSTANCES 20
+
+class LogfsTestGC : public LogfsTestRaw {
+protected:
+  virtual void SetUp() {
+    LogfsTestRaw::SetUp();
+
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+    gen.assign(GC_TEST_INSTANCES, 0);
+    for (uint16_t inst = 0; inst < GC_TEST_INSTANCES; inst++) {
+      save(inst, 0);
+    }
+  }
+
+  virtual void TearDown() {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  }
+
+  void make_instance(unsigned char *obj, uint16_t inst_id, uint32_t generation) {
+    for (uint32_t i = 0; i < OBJ1_SIZE; i++) {
+      obj[i] = inst_id * 3 + generation * 11 + i;
+    }
+  }
+
+  int32_t save(uint16_t inst, uint32_t generation) {
+    unsigned char obj[OBJ1_SIZE];
+
+    make_instance(obj, inst, generation);
+    return PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, inst, obj, sizeof(obj));
+  }
+
+  /* Some settings get saved far more often than others */
+  uint16_t pick(uint32_t i) {
+    return (i % 3) ? (i % 4) : (i * 7) % GC_TEST_INSTANCES;
+  }
+
+  /* Unmount and remount, as after a reset */
+  void reboot() {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+    ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  std::vector<uint8_t> read_flash() {
+    std::vector<uint8_t> image(flash_config.size_of_flash);
+    FILE *f = fopen("theflash.bin", "r");
+    EXPECT_EQ(image.size(), fread(image.data(), 1, image.size(), f));
+    fclose(f);
+    return image;
+  }
+
+  void write_flash(const std::vector<uint8_t> &image) {
+    FILE *f = fopen("theflash.bin", "r+");
+    EXPECT_EQ(image.size(), fwrite(image.data(), 1, image.size(), f));
+    fclose(f);
+  }
+
+  uintptr_t fs_id;
+  std::vector<uint32_t> gen;
+};
+
+TEST_F(LogfsTestGC, SavesStayBoundedAndWearIsLevelled) {
+  uint16_t num_arenas = pios_flash_partition_table[0].size / flashfs_config_settings.arena_size;
+  uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+  uint32_t saves = 3 * num_arenas * num_slots;
+
+  uint32_t max_writes = 0;
+  uint32_t erases_in_saves = 0;
+  double max_latency = 0;
+
+  for (uint32_t i = 0; i < saves; i++) {
+    uint16_t inst = pick(i);
+    uint32_t writes_before, erases_before, writes_after, erases_after;
+
+    PIOS_Flash_Posix_GetOps(pios_posix_flash_id, &writes_before, &erases_before);
+    double start = now_s();
+    ASSERT_EQ(0, save(inst, ++gen[inst]));
+    double latency = now_s() - start;
+    PIOS_Flash_Posix_GetOps(pios_posix_flash_id, &writes_after, &erases_after);
+
+    if (writes_after - writes_before > max_writes) {
+      max_writes = writes_after - writes_before;
+    }
+    if (latency > max_latency) {
+      max_latency = latency;
+    }
+    erases_in_saves += erases_after - erases_before;
+
+    /* Let the arena erases happen between saves, as the system task does */
+    ASSERT_EQ(0, PIOS_FLASHFS_Maintenance(fs_id));
+  }
+
+  unsigned char obj[OBJ1_SIZE];
+  unsigned char obj_check[OBJ1_SIZE];
+  for (uint16_t inst = 0; inst < GC_TEST_INSTANCES; inst++) {
+    make_instance(obj, inst, gen[inst]);
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, inst, obj_check, sizeof(obj_check)));
+    ASSERT_EQ(0, memcmp(obj, obj_check, sizeof(obj)));
+  }
+
+  uint32_t min_count = UINT32_MAX, max_count = 0;
+  for (uint8_t arena = 0; arena < num_arenas; arena++) {
+    uint32_t count;
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_GetEraseCount(fs_id, arena, &count));
+    min_count = count < min_count ? count : min_count;
+    max_count = count > max_count ? count : max_count;
+  }
+
+  printf("%u saves: at most %u flash writes and %.0f us per save, %u erases within saves, "
+    "arena erase counts %u..%u\n", saves, max_writes, max_latency * 1e6,
+    erases_in_saves, min_count, max_count);
+
+  /* No save copies the whole log or waits for an erase */
+  EXPECT_LT(max_writes, GC_TEST_INSTANCES * 2u);
+  EXPECT_EQ(0u, erases_in_saves);
+  EXPECT_LE(max_count - min_count, 1u);
+  EXPECT_GE(min_count, 3u);
+
+  /* Erase counts survive a remount and count a format */
+  reboot();
+  EXPECT_EQ(0, PIOS_FLASHFS_Format(fs_id));
+  uint32_t count;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_GetEraseCount(fs_id, 0, &count));
+  EXPECT_GE(count, min_count + 1);
+}
+
+/*
+ * Cut the power at every flash write or erase across a stretch of saves
+ * that takes the log through a garbage collection and the background
+ * erase that follows it.  After a reboot every object must be intact,
+ * except that the one being saved may be either version, or missing (its
+ * old version is obsoleted before the new one is written).
+ */
+TEST_F(LogfsTestGC, PowerCutDuringGarbageCollection) {
+  uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+
+  /* Bring the log to just short of needing a collection */
+  uint32_t i;
+  for (i = 0; i < num_slots - GC_TEST_INSTANCES - 16u; i++) {
+    uint16_t inst = pick(i);
+    ASSERT_EQ(0, save(inst, ++gen[inst]));
+    ASSERT_EQ(0, PIOS_FLASHFS_Maintenance(fs_id));
+  }
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  std::vector<uint8_t> image = read_flash();
+  const std::vector<uint32_t> image_gen = gen;
+  const uint32_t first_save = i;
+  const uint32_t window = 40;
+
+  bool cut = true;
+  uint32_t cuts = 0;
+  for (int32_t ops = 0; cut; ops++) {
+    write_flash(image);
+    gen = image_gen;
+    ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+    PIOS_Flash_Posix_SetPowerCut(pios_posix_flash_id, ops);
+
+    int32_t in_flight = -1;
+    cut = false;
+    for (i = first_save; i < first_save + window; i++) {
+      uint16_t inst = pick(i);
+      if (save(inst, gen[inst] + 1) != 0) {
+        in_flight = inst;
+        cut = true;
+        break;
+      }
+      gen[inst]++;
+
+      if (PIOS_FLASHFS_Maintenance(fs_id) != 0) {
+        cut = true;
+        break;
+      }
+    }
+
+    PIOS_Flash_Posix_SetPowerCut(pios_posix_flash_id, -1);
+    reboot();
+
+    unsigned char obj[OBJ1_SIZE];
+    unsigned char obj_check[OBJ1_SIZE];
+    for (uint16_t inst = 0; inst < GC_TEST_INSTANCES; inst++) {
+      int32_t rc = PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, inst, obj_check, sizeof(obj_check));
+
+      if (inst == in_flight) {
+        if (rc == -3) {
+          continue;
+        }
+        make_instance(obj, inst, gen[inst] + 1);
+        if (rc == 0 && memcmp(obj, obj_check, sizeof(obj)) == 0) {
+          continue;
+        }
+      }
+
+      make_instance(obj, inst, gen[inst]);
+      ASSERT_EQ(0, rc) << "cut after " << ops << " ops, instance " << inst;
+      ASSERT_EQ(0, memcmp(obj, obj_check, sizeof(obj))) << "cut after " << ops << " ops, instance " << inst;
+    }
+
+    /* The filesystem carries on, through another collection */
+    for (uint32_t j = 0; j < num_slots; j++) {
+      uint16_t inst = pick(i + j);
+      ASSERT_EQ(0, save(inst, ++gen[inst])) << "cut after " << ops << " ops";
+    }
+    for (uint16_t inst = 0; inst < GC_TEST_INSTANCES; inst++) {
+      make_instance(obj, inst, gen[inst]);
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, inst, obj_check, sizeof(obj_check)));
+      ASSERT_EQ(0, memcmp(obj, obj_check, sizeof(obj))) << "cut after " << ops << " ops, instance " << inst;
+    }
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+    cuts++;
+  }
+
+  printf("%u power cuts checked\n", cuts - 1);
+
+  /* Leave things as TearDown expects */
+  ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+  ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+}
@@ -13,6 +13,14 @@ const struct flashfs_logfs_cfg flashfs_config_settings = {
 	.slot_size     = 0x00000100, /* 256 bytes */
 };
 
+/* Same layout as the settings, but with room to index only a few objects */
+const struct flashfs_logfs_cfg flashfs_config_settings_small_index = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 256 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+	.index_entries = 4,
+};
+
 const struct flashfs_logfs_cfg flashfs_config_waypoints = {
 	.fs_magic      = 0x89abceef,
 	.arena_size    = 0x00010000, /* 64 * slot size */
@@ -0,0 +1,8 @@
+/* Just what lpfilter.c needs of PiOS */
+#include <assert.h>
+#include <stdlib.h>
+
+#define PIOS_malloc_no_dma(size) malloc(size)
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) assert(x)
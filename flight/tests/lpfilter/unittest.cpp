@@ -0,0 +1,400 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand, free */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <math.h>		/* sinf */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "lpfilter.h"
+
+}
+
+static double now_s()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * The filter as it was before being laid out as a structure of arrays:
+ * direct form I biquads, with the state of each axis kept together.
+ */
+struct legacy_biquad_state {
+	float x1, x2, y1, y2;
+};
+
+struct legacy_filter {
+	int order;
+	int width;
+	float alpha;
+	float prev[16];
+	float b0[4], a1[4], a2[4];
+	struct legacy_biquad_state s[4][16];
+};
+
+static void legacy_create(struct legacy_filter *filt, float cutoff, float dT,
+		int order, int width)
+{
+	static const float factors[16] = {
+		1.4142f, 1.0f, 0.7654f, 1.8478f, 0.6180f, 1.6180f,
+		0.5176f, 1.4142f, 1.9319f, 0.4450f, 1.2470f, 1.8019f,
+		0.3902f, 1.1111f, 1.6629f, 1.9616f
+	};
+
+	memset(filt, 0, sizeof(*filt));
+
+	filt->order = order;
+	filt->width = width;
+	filt->alpha = expf(-2.0f * (float)(M_PI) * cutoff * dT);
+
+	int addr = 0;
+	for (int i = 2; i < order; i++)
+		addr += i >> 1;
+
+	float f = 1.0f / tanf((float)M_PI * cutoff * dT);
+
+	for (int i = 0; i < order >> 1; i++) {
+		float q = factors[addr + i];
+
+		filt->b0[i] = 1.0f / (1.0f + q*f + f*f);
+		filt->a1[i] = 2.0f * (f*f - 1.0f) * filt->b0[i];
+		filt->a2[i] = -(1.0f - q*f + f*f) * filt->b0[i];
+	}
+}
+
+/* Kept out of line, as the library function is */
+static void __attribute__((noinline)) legacy_run(struct legacy_filter *filt, float *sample)
+{
+	if (filt->order & 1) {
+		for (int i = 0; i < filt->width; i++) {
+			filt->prev[i] *= filt->alpha;
+			filt->prev[i] += (1 - filt->alpha) * sample[i];
+			sample[i] = filt->prev[i];
+		}
+	}
+
+	for (int i = 0; i < filt->order >> 1; i++) {
+		for (int j = 0; j < filt->width; j++) {
+			struct legacy_biquad_state *s = &filt->s[i][j];
+
+			float y = filt->b0[i] * (sample[j] + 2.0f * s->x1 + s->x2) +
+				filt->a1[i] * s->y1 + filt->a2[i] * s->y2;
+
+			s->y2 = s->y1;
+			s->y1 = y;
+
+			s->x2 = s->x1;
+			s->x1 = sample[j];
+
+			sample[j] = y;
+		}
+	}
+}
+
+/* Peak output amplitude of a filter, once settled, for a sine input */
+static float sine_gain(lpfilter_state_t filter, float freq, float dT)
+{
+	float peak = 0;
+
+	for (int i = 0; i < 20000; i++) {
+		float x[3];
+
+		x[0] = x[1] = x[2] = sinf(2 * (float)M_PI * freq * i * dT);
+
+		lpfilter_run(filter, x);
+
+		if (i >= 10000 && fabsf(x[0]) > peak)
+			peak = fabsf(x[0]);
+	}
+
+	return peak;
+}
+
+class LPFilter : public testing::Test {
+};
+
+TEST_F(LPFilter, MatchesLegacy) {
+	for (int order = 1; order <= 8; order++) {
+		for (int width = 1; width <= 16; width += 5) {
+			lpfilter_state_t filter = NULL;
+			struct legacy_filter legacy;
+
+			lpfilter_create(&filter, 90, 1.0f / 1000, order, width);
+			legacy_create(&legacy, 90, 1.0f / 1000, order, width);
+
+			srand(order * 100 + width);
+
+			for (int i = 0; i < 2000; i++) {
+				float x[16], ref[16];
+
+				for (int j = 0; j < width; j++)
+					x[j] = ref[j] = (rand() % 2001 - 1000) / 10.0f;
+
+				lpfilter_run(filter, x);
+				legacy_run(&legacy, ref);
+
+				for (int j = 0; j < width; j++)
+					ASSERT_NEAR(ref[j], x[j], 1e-3f) << "order "
+						<< order << " width " << width
+						<< " sample " << i;
+			}
+
+			free(filter);
+		}
+	}
+};
+
+TEST_F(LPFilter, RunSingleMatchesRun) {
+	lpfilter_state_t a = NULL, b = NULL;
+
+	lpfilter_create(&a, 60, 1.0f / 2000, 5, 3);
+	lpfilter_create(&b, 60, 1.0f / 2000, 5, 3);
+
+	for (int i = 0; i < 1000; i++) {
+		float x[3] = { (float) (i % 17), (float) (i % 5), -1.0f * (i % 11) };
+		float y[3];
+
+		for (int j = 0; j < 3; j++)
+			y[j] = lpfilter_run_single(b, j, x[j]);
+
+		lpfilter_run(a, x);
+
+		for (int j = 0; j < 3; j++)
+			ASSERT_FLOAT_EQ(x[j], y[j]);
+	}
+
+	free(a);
+	free(b);
+};
+
+TEST_F(LPFilter, Response) {
+	const float dT = 1.0f / 1000;
+
+	for (int order = 1; order <= 8; order++) {
+		lpfilter_state_t filter = NULL;
+
+		lpfilter_create(&filter, 50, dT, order, 3);
+
+		// Unity gain at DC
+		float x[3];
+		for (int i = 0; i < 2000; i++) {
+			x[0] = x[1] = x[2] = 10.0f;
+			lpfilter_run(filter, x);
+		}
+		EXPECT_NEAR(10.0f, x[0], 1e-3f) << "order " << order;
+
+		// Butterworth, so down 3dB at the cutoff (the first order
+		// stage is only an approximation)
+		lpfilter_create(&filter, 50, dT, order, 3);
+		EXPECT_NEAR(M_SQRT1_2, sine_gain(filter, 50, dT),
+				(order & 1) ? 0.1f : 0.02f) << "order " << order;
+
+		// And well down a decade on
+		lpfilter_create(&filter, 50, dT, order, 3);
+		EXPECT_LT(sine_gain(filter, 500, dT), 0.15f) << "order " << order;
+
+		free(filter);
+	}
+};
+
+TEST_F(LPFilter, Bypass) {
+	lpfilter_state_t filter = NULL;
+
+	lpfilter_create(&filter, 50, 1.0f / 1000, 0, 3);
+
+	float x[3] = { 1, 2, 3 };
+	lpfilter_run(filter, x);
+
+	EXPECT_EQ(1, x[0]);
+	EXPECT_EQ(3, x[2]);
+	EXPECT_EQ(5, lpfilter_run_single(filter, 1, 5));
+
+	free(filter);
+};
+
+TEST_F(LPFilter, Notch) {
+	const float dT = 1.0f / 1000;
+	lpfilter_state_t filter = NULL;
+
+	lpfilter_notch_create(&filter, 150, 3, dT, 3);
+
+	EXPECT_LT(sine_gain(filter, 150, dT), 0.01f);
+
+	lpfilter_notch_create(&filter, 150, 3, dT, 3);
+	EXPECT_GT(sine_gain(filter, 40, dT), 0.95f);
+
+	lpfilter_notch_create(&filter, 150, 3, dT, 3);
+	EXPECT_GT(sine_gain(filter, 400, dT), 0.95f);
+
+	// Moving one axis leaves the others alone
+	lpfilter_notch_create(&filter, 150, 3, dT, 3);
+	lpfilter_notch_set(filter, 1, 300);
+
+	float peak[3] = { 0, 0, 0 };
+	for (int i = 0; i < 20000; i++) {
+		float x[3];
+
+		x[0] = x[1] = x[2] = sinf(2 * (float)M_PI * 150 * i * dT);
+
+		lpfilter_run(filter, x);
+
+		for (int j = 0; i >= 10000 && j < 3; j++)
+			if (fabsf(x[j]) > peak[j])
+				peak[j] = fabsf(x[j]);
+	}
+
+	EXPECT_LT(peak[0], 0.01f);
+	EXPECT_GT(peak[1], 0.5f);
+	EXPECT_LT(peak[2], 0.01f);
+
+	free(filter);
+};
+
+TEST_F(LPFilter, NotchTracking) {
+	const float dT = 1.0f / 1000;
+	const int bins = 64;
+	const float bin_hz = 500.0f / bins;
+	lpfilter_state_t filter = NULL;
+
+	// Bypassed until there's something to follow
+	lpfilter_notch_create(&filter, 0, 3, dT, 3);
+
+	float x[3] = { 1, 2, 3 };
+	lpfilter_run(filter, x);
+	EXPECT_EQ(2, x[1]);
+
+	float spectrum[bins];
+
+	// Flat noise isn't followed
+	for (int i = 0; i < bins; i++)
+		spectrum[i] = 1 + (i % 3) * 0.1f;
+
+	EXPECT_EQ(0, lpfilter_notch_track(filter, 0, spectrum, bins, bin_hz, 60, 450));
+
+	// A peak between bins 20 and 21 is found between them
+	spectrum[20] = 40;
+	spectrum[21] = 30;
+
+	float center = lpfilter_notch_track(filter, 0, spectrum, bins, bin_hz, 60, 450);
+	EXPECT_GT(center, 20 * bin_hz);
+	EXPECT_LT(center, 21 * bin_hz);
+
+	// Only axis 0 was placed
+	x[1] = 2;
+	lpfilter_run(filter, x);
+	EXPECT_FLOAT_EQ(2, x[1]);
+
+	// The notch moves gradually towards a peak that moves
+	spectrum[20] = spectrum[21] = 1;
+	spectrum[40] = 40;
+
+	float prev = center;
+	for (int i = 0; i < 30; i++) {
+		center = lpfilter_notch_track(filter, 0, spectrum, bins, bin_hz, 60, 450);
+		EXPECT_GT(center, prev - 1e-3f);
+		prev = center;
+	}
+	EXPECT_NEAR(40 * bin_hz, center, 0.5f);
+
+	// A peak outside the range is ignored
+	spectrum[40] = 1;
+	spectrum[2] = 100;
+	EXPECT_FLOAT_EQ(center, lpfilter_notch_track(filter, 0, spectrum, bins, bin_hz, 60, 450));
+
+	free(filter);
+};
+
+/*
+ * Filters a 3 axis gyro stream, as sensors.c does, and a 16 wide one.
+ * Reports the time per sample against the previous implementation, and
+ * what that would be as a share of the sensor loop at common rates (on
+ * this machine, so only the proportions carry over to flight).
+ */
+TEST_F(LPFilter, Benchmark) {
+	const int samples = 2000000;
+	const int widths[] = { 3, 16 };
+
+	for (unsigned w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+		int width = widths[w];
+		lpfilter_state_t filter = NULL;
+		struct legacy_filter legacy;
+
+		lpfilter_create(&filter, 90, 1.0f / 1000, 4, width);
+		legacy_create(&legacy, 90, 1.0f / 1000, 4, width);
+
+		float x[16];
+
+		double start = now_s();
+		for (int i = 0; i < samples; i++) {
+			for (int j = 0; j < width; j++)
+				x[j] = (i * 7 + j) % 13;
+
+			legacy_run(&legacy, x);
+		}
+		double old_ns = (now_s() - start) * 1e9 / samples;
+
+		start = now_s();
+		for (int i = 0; i < samples; i++) {
+			for (int j = 0; j < width; j++)
+				x[j] = (i * 7 + j) % 13;
+
+			lpfilter_run(filter, x);
+		}
+		double new_ns = (now_s() - start) * 1e9 / samples;
+
+		printf("4th order, %2d wide: legacy %.1f ns, now %.1f ns per sample;"
+				" load at 1/2/4/8 kHz %.3f/%.3f/%.3f/%.3f%%\n",
+				width, old_ns, new_ns,
+				new_ns * 1e-4, new_ns * 2e-4, new_ns * 4e-4,
+				new_ns * 8e-4);
+
+		volatile float sink = x[0];
+		(void) sink;
+
+		free(filter);
+	}
+};
+
+/**
+ * @}
+ * @}
+ */
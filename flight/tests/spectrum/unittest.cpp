@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <math.h>		/* sin, cos, sqrt */
+#include <stdlib.h>		/* rand */
+#include <vector>
+
+extern "C" {
+
+#include "spectrum.h"
+
+}
+
+/* Reference DFT of real samples, in double precision */
+static void reference_dft(const std::vector<float> &x, std::vector<double> &re,
+		std::vector<double> &im)
+{
+	size_t n = x.size();
+
+	re.assign(n / 2 + 1, 0);
+	im.assign(n / 2 + 1, 0);
+
+	for (size_t k = 0; k <= n / 2; k++) {
+		for (size_t i = 0; i < n; i++) {
+			double a = -2 * M_PI * k * i / n;
+
+			re[k] += x[i] * cos(a);
+			im[k] += x[i] * sin(a);
+		}
+	}
+}
+
+static std::vector<float> sine(uint16_t n, double hz, double amplitude,
+		double sample_hz)
+{
+	std::vector<float> x(n);
+
+	for (uint16_t i = 0; i < n; i++)
+		x[i] = amplitude * sin(2 * M_PI * hz * i / sample_hz);
+
+	return x;
+}
+
+class Spectrum : public testing::Test {
+};
+
+TEST_F(Spectrum, MatchesReferenceDFT) {
+	srand(7);
+
+	for (uint16_t n = 4; n <= 1024; n *= 2) {
+		std::vector<float> x(n);
+
+		for (uint16_t i = 0; i < n; i++)
+			x[i] = (rand() % 2001 - 1000) / 100.0f;
+
+		std::vector<double> re, im;
+		reference_dft(x, re, im);
+
+		std::vector<float> fft(x);
+		spectrum_rfft(fft.data(), n);
+
+		/* Rounding grows with the log of the length */
+		double tol = 1e-5 * n * 10;
+
+		EXPECT_NEAR(re[0], fft[0], tol) << "n " << n;
+		EXPECT_NEAR(re[n / 2], fft[1], tol) << "n " << n;
+
+		for (uint16_t k = 1; k < n / 2; k++) {
+			ASSERT_NEAR(re[k], fft[2 * k], tol) << "n " << n << " bin " << k;
+			ASSERT_NEAR(im[k], fft[2 * k + 1], tol) << "n " << n << " bin " << k;
+		}
+	}
+};
+
+TEST_F(Spectrum, SineAmplitudeAndFrequency) {
+	const double sample_hz = 1000;
+	const uint16_t n = 256;
+	const double bin_hz = sample_hz / n;
+
+	for (double hz = 50; hz < 450; hz += 37.3) {
+		std::vector<float> x = sine(n, hz, 2.0, sample_hz);
+		std::vector<float> magnitude(n / 2, 0);
+
+		spectrum_window_hann(x.data(), n);
+		spectrum_rfft(x.data(), n);
+		spectrum_accumulate(x.data(), n, magnitude.data());
+
+		float peak_mag;
+		float peak = spectrum_peak(magnitude.data(), n / 2, bin_hz,
+				10, 490, &peak_mag);
+
+		EXPECT_NEAR(hz, peak, 0.25 * bin_hz);
+
+		/* A Hann window loses up to 15% between bins */
+		EXPECT_GT(peak_mag, 2.0 * 0.84);
+		EXPECT_LT(peak_mag, 2.0 * 1.01);
+	}
+};
+
+TEST_F(Spectrum, AveragingFindsPeakInNoise) {
+	const double sample_hz = 500;
+	const uint16_t n = 64;
+	const double bin_hz = sample_hz / n;
+	const int windows = 16;
+
+	std::vector<float> magnitude(n / 2, 0);
+
+	srand(3);
+
+	for (int w = 0; w < windows; w++) {
+		std::vector<float> x(n);
+
+		for (uint16_t i = 0; i < n; i++) {
+			double t = (w * n + i) / sample_hz;
+
+			/* A 0.5 amplitude tone under noise 5x as large */
+			x[i] = 0.5 * sin(2 * M_PI * 150 * t) +
+				2.5 * (rand() / (double) RAND_MAX - 0.5) * 2;
+		}
+
+		spectrum_window_hann(x.data(), n);
+		spectrum_rfft(x.data(), n);
+		spectrum_accumulate(x.data(), n, magnitude.data());
+	}
+
+	for (uint16_t k = 0; k < n / 2; k++)
+		magnitude[k] /= windows;
+
+	float peak = spectrum_peak(magnitude.data(), n / 2, bin_hz, 20, 240,
+			NULL);
+
+	EXPECT_NEAR(150, peak, bin_hz);
+};
+
+TEST_F(Spectrum, PeakOutsideRangeIsIgnored) {
+	std::vector<float> magnitude(32, 0.1f);
+
+	magnitude[4] = 10;
+	magnitude[20] = 1;
+
+	EXPECT_NEAR(20 * 10, spectrum_peak(magnitude.data(), 32, 10, 100, 300,
+				NULL), 1);
+	EXPECT_EQ(0, spectrum_peak(magnitude.data(), 32, 10, 400, 300, NULL));
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,23 @@
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(PIOS_INCLUDE_FLASH)
+#include <pios_flash.h>
+#endif
+
+#if defined(PIOS_INCLUDE_COM)
+#include <pios_com.h>
+#endif
+
+#include <pios_heap.h>
+#include <pios_irq.h>
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ * @file       pios_thread.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Thread API subset used by streamfs, run on pthreads
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_THREAD_H_
+#define PIOS_THREAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+enum pios_thread_prio_e
+{
+	PIOS_THREAD_PRIO_LOW = 0,
+	PIOS_THREAD_PRIO_NORMAL,
+	PIOS_THREAD_PRIO_HIGH,
+	PIOS_THREAD_PRIO_HIGHEST
+};
+
+struct pios_thread;
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio);
+uint32_t PIOS_Thread_Systime(void);
+void PIOS_Thread_Sleep(uint32_t time_ms);
+
+#endif /* PIOS_THREAD_H_ */
+
+/**
+ * @}
+ * @}
+ */
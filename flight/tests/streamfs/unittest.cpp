@@ -0,0 +1,307 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <unistd.h>		/* unlink, usleep */
+#include <vector>
+
+extern "C" {
+
+#include "pios_flash.h"		/* PIOS_FLASH_* API */
+
+#include "pios_flash_priv.h"	/* struct pios_flash_partition */
+
+extern const struct pios_flash_partition pios_flash_partition_table[];
+extern uint32_t pios_flash_partition_table_size;
+
+#include "../logfs/pios_flash_posix_priv.h"
+
+extern uintptr_t pios_posix_flash_id;
+extern struct pios_flash_posix_cfg flash_config;
+
+#include "pios_com.h"
+#include "pios_com_priv.h"
+#include "pios_streamfs.h"
+#include "pios_streamfs_priv.h"
+
+extern struct streamfs_cfg streamfs_config_log;
+
+int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len);
+
+}
+
+/* Same as the logging module */
+#define LOG_BUF_LEN 768
+
+static double now_s()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Frames shaped like a telemetry log: UAVTalk objects with a timestamped
+ * header and payloads of typical object sizes.
+ */
+static void make_frames(std::vector<std::vector<uint8_t> > &frames, size_t bytes)
+{
+	size_t total = 0;
+
+	srand(1234);
+
+	while (total < bytes) {
+		std::vector<uint8_t> frame(14 + 4 * (rand() % 48));
+
+		for (size_t i = 0; i < frame.size(); i++)
+			frame[i] = rand();
+
+		total += frame.size();
+		frames.push_back(frame);
+	}
+}
+
+class StreamfsTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		/* create an empty, appropriately sized flash filesystem */
+		FILE *theflash = fopen("theflash.bin", "w");
+		uint8_t sector[flash_config.size_of_sector];
+		memset(sector, 0xFF, sizeof(sector));
+		for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++) {
+			fwrite(sector, sizeof(sector), 1, theflash);
+		}
+		fclose(theflash);
+
+		ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+
+		PIOS_FLASH_register_partition_table(pios_flash_partition_table, pios_flash_partition_table_size);
+
+		ASSERT_EQ(0, PIOS_STREAMFS_Init(&streamfs_id, &streamfs_config_log, FLASH_PARTITION_LABEL_LOG));
+		ASSERT_EQ(0, PIOS_COM_Init(&com_id, &pios_streamfs_com_driver, streamfs_id, 0, LOG_BUF_LEN));
+	}
+
+	virtual void TearDown() {
+		PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+		unlink("theflash.bin");
+	}
+
+	uint32_t flash_writes() {
+		uint32_t writes, erases;
+
+		PIOS_Flash_Posix_GetOps(pios_posix_flash_id, &writes, &erases);
+
+		return writes;
+	}
+
+	/* Log frames through the COM fifo, as the logging module does */
+	std::vector<uint8_t> log_frames(const std::vector<std::vector<uint8_t> > &frames,
+			bool retry, uint32_t *dropped) {
+		std::vector<uint8_t> logged;
+
+		*dropped = 0;
+
+		for (size_t i = 0; i < frames.size(); i++) {
+			int32_t rc;
+
+			while ((rc = PIOS_COM_SendBufferNonBlocking(com_id,
+						frames[i].data(), frames[i].size())) < 0 && retry) {
+				usleep(50);
+			}
+
+			if (rc < 0) {
+				*dropped += frames[i].size();
+			} else {
+				logged.insert(logged.end(), frames[i].begin(), frames[i].end());
+			}
+		}
+
+		return logged;
+	}
+
+	std::vector<uint8_t> read_file(int32_t file_id) {
+		std::vector<uint8_t> contents;
+		uint8_t buf[1000];
+		int32_t got;
+
+		EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(com_id, file_id));
+
+		while ((got = PIOS_STREAMFS_Read(com_id, buf, sizeof(buf))) > 0) {
+			contents.insert(contents.end(), buf, buf + got);
+		}
+
+		EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+		return contents;
+	}
+
+	uintptr_t streamfs_id;
+	uintptr_t com_id;
+};
+
+TEST_F(StreamfsTest, CoalescedLogReadsBack) {
+	std::vector<std::vector<uint8_t> > frames;
+	make_frames(frames, 300 * 1024);
+
+	ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+	uint32_t dropped;
+	std::vector<uint8_t> logged = log_frames(frames, true, &dropped);
+
+	ASSERT_EQ(0, PIOS_STREAMFS_Close(com_id));
+	EXPECT_EQ(0U, dropped);
+
+	uint32_t writes = flash_writes();
+
+	int32_t file_id = PIOS_STREAMFS_MaxFileId(com_id);
+	EXPECT_EQ(0, file_id);
+
+	std::vector<uint8_t> contents = read_file(file_id);
+	ASSERT_EQ(logged.size(), contents.size());
+	EXPECT_TRUE(logged == contents);
+
+	/* One program per page, plus a short page and a footer per arena */
+	uint32_t arenas = logged.size() / streamfs_config_log.arena_size + 1;
+	EXPECT_LE(writes, logged.size() / 256 + 2 * arenas + 2);
+}
+
+TEST_F(StreamfsTest, PartialBlockFlushedOnClose) {
+	uint8_t frame[100];
+
+	for (uint32_t i = 0; i < sizeof(frame); i++) {
+		frame[i] = i;
+	}
+
+	ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+	ASSERT_EQ((int32_t) sizeof(frame), PIOS_COM_SendBufferNonBlocking(com_id, frame, sizeof(frame)));
+	ASSERT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+	std::vector<uint8_t> contents = read_file(PIOS_STREAMFS_MaxFileId(com_id));
+	ASSERT_EQ(sizeof(frame), contents.size());
+	EXPECT_EQ(0, memcmp(frame, contents.data(), sizeof(frame)));
+}
+
+/*
+ * With flash slower than the producer the fifo and both blocks fill up;
+ * whole frames are then refused, and what did get in is logged intact.
+ */
+TEST_F(StreamfsTest, BackPressureIsBoundedAndCounted) {
+	std::vector<std::vector<uint8_t> > frames;
+	make_frames(frames, 64 * 1024);
+
+	PIOS_Flash_Posix_SetProgramTime(pios_posix_flash_id, 2000);
+
+	ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+	uint32_t dropped;
+	std::vector<uint8_t> logged = log_frames(frames, false, &dropped);
+
+	int32_t high_water = PIOS_STREAMFS_BufferHighWater(com_id);
+
+	ASSERT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+	PIOS_Flash_Posix_SetProgramTime(pios_posix_flash_id, 0);
+
+	EXPECT_GT(dropped, 0U);
+	EXPECT_GT(high_water, LOG_BUF_LEN / 2);
+	EXPECT_LE(high_water, LOG_BUF_LEN + 2 * (int32_t) streamfs_config_log.write_size);
+
+	std::vector<uint8_t> contents = read_file(PIOS_STREAMFS_MaxFileId(com_id));
+	ASSERT_EQ(logged.size(), contents.size());
+	EXPECT_TRUE(logged == contents);
+
+	printf("%zu of %zu bytes logged, %u dropped, buffer high water %d bytes\n",
+			logged.size(), logged.size() + dropped, dropped, high_water);
+}
+
+/*
+ * Compare writing each frame as it comes, which is what the flush task
+ * used to end up doing when it kept up with the logger, against the
+ * block buffered path.  Each page program takes a fixed time, as on NOR.
+ */
+TEST_F(StreamfsTest, Benchmark) {
+	std::vector<std::vector<uint8_t> > frames;
+	make_frames(frames, 256 * 1024);
+
+	PIOS_Flash_Posix_SetProgramTime(pios_posix_flash_id, 50);
+
+	ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+	uint32_t writes_before = flash_writes();
+	size_t bytes = 0;
+
+	double start = now_s();
+	for (size_t i = 0; i < frames.size(); i++) {
+		ASSERT_EQ(0, PIOS_STREAMFS_Testing_Write(streamfs_id,
+					frames[i].data(), frames[i].size()));
+		bytes += frames[i].size();
+	}
+	ASSERT_EQ(0, PIOS_STREAMFS_Close(com_id));
+	double direct = now_s() - start;
+	uint32_t direct_writes = flash_writes() - writes_before;
+
+	ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+	writes_before = flash_writes();
+	uint32_t dropped;
+
+	start = now_s();
+	log_frames(frames, true, &dropped);
+	ASSERT_EQ(0, PIOS_STREAMFS_Close(com_id));
+	double coalesced = now_s() - start;
+	uint32_t coalesced_writes = flash_writes() - writes_before;
+
+	PIOS_Flash_Posix_SetProgramTime(pios_posix_flash_id, 0);
+
+	double kb = bytes / 1024.0;
+
+	printf("%.0f kB in %zu frames: per frame %u programs, %.0f kB/s; "
+			"coalesced %u programs, %.0f kB/s\n",
+			kb, frames.size(), direct_writes, kb / direct,
+			coalesced_writes, kb / coalesced);
+
+	EXPECT_EQ(0U, dropped);
+	EXPECT_LT(2 * coalesced_writes, direct_writes);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,54 @@
+/* 
+ * These need to be defined in a .c file so that we can use
+ * designated initializer syntax which c++ doesn't support (yet).
+ */
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include "pios_streamfs_priv.h"
+
+/* Same layout as the onboard flight log */
+const struct streamfs_cfg streamfs_config_log = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 64kb */
+	.write_size    = 0x00000100, /* 256 bytes */
+};
+
+#include "../logfs/pios_flash_posix_priv.h"
+
+#include "pios_flash_priv.h"
+
+const struct pios_flash_posix_cfg flash_config = {
+	.size_of_flash  = 1 * 1024 * 1024,
+	.size_of_sector = FLASH_SECTOR_64KB,
+};
+
+static const struct pios_flash_sector_range posix_flash_sectors[] = {
+	{
+		.base_sector = 0,
+		.last_sector = 15,
+		.sector_size = FLASH_SECTOR_64KB,
+	},
+};
+
+uintptr_t pios_posix_flash_id;
+static const struct pios_flash_chip pios_flash_chip_posix = {
+	.driver        = &pios_posix_flash_driver,
+	.chip_id       = &pios_posix_flash_id,
+	.page_size     = 256,
+	.sector_blocks = posix_flash_sectors,
+	.num_blocks    = NELEMENTS(posix_flash_sectors),
+};
+
+const struct pios_flash_partition pios_flash_partition_table[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_LOG,
+		.chip_desc    = &pios_flash_chip_posix,
+		.first_sector = 0,
+		.last_sector  = 15,
+		.chip_offset  = 0,
+		.size         = (15 - 0 + 1) * FLASH_SECTOR_64KB,
+	},
+};
+
+uint32_t pios_flash_partition_table_size = NELEMENTS(pios_flash_partition_table);
@@ -0,0 +1,233 @@
+/**
+ ******************************************************************************
+ * @file       unittest_mocks.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Host implementations of the PiOS services used by streamfs and COM
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pios.h"
+#include "pios_delay.h"
+#include "pios_mutex.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+static void deadline_after(struct timespec *ts, uint32_t timeout_ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+
+	ts->tv_sec += timeout_ms / 1000;
+	ts->tv_nsec += (timeout_ms % 1000) * 1000000;
+
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+struct pios_mutex {
+	pthread_mutex_t mtx;
+};
+
+struct pios_mutex *PIOS_Mutex_Create(void)
+{
+	struct pios_mutex *m = malloc(sizeof(*m));
+
+	if (!m)
+		return NULL;
+
+	pthread_mutex_init(&m->mtx, NULL);
+
+	return m;
+}
+
+bool PIOS_Mutex_Lock(struct pios_mutex *m, uint32_t timeout_ms)
+{
+	if (timeout_ms == 0)
+		return pthread_mutex_trylock(&m->mtx) == 0;
+
+	if (timeout_ms == PIOS_MUTEX_TIMEOUT_MAX)
+		return pthread_mutex_lock(&m->mtx) == 0;
+
+	struct timespec ts;
+	deadline_after(&ts, timeout_ms);
+
+	return pthread_mutex_timedlock(&m->mtx, &ts) == 0;
+}
+
+bool PIOS_Mutex_Unlock(struct pios_mutex *m)
+{
+	return pthread_mutex_unlock(&m->mtx) == 0;
+}
+
+/* Binary semaphore, as on the flight side */
+struct pios_semaphore {
+	pthread_mutex_t mtx;
+	pthread_cond_t cond;
+	bool given;
+};
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	struct pios_semaphore *s = malloc(sizeof(*s));
+
+	if (!s)
+		return NULL;
+
+	pthread_mutex_init(&s->mtx, NULL);
+	pthread_cond_init(&s->cond, NULL);
+	s->given = true;
+
+	return s;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *s, uint32_t timeout_ms)
+{
+	struct timespec ts;
+	int rc = 0;
+
+	if (timeout_ms != PIOS_SEMAPHORE_TIMEOUT_MAX)
+		deadline_after(&ts, timeout_ms);
+
+	pthread_mutex_lock(&s->mtx);
+
+	while (!s->given && rc != ETIMEDOUT) {
+		if (timeout_ms == PIOS_SEMAPHORE_TIMEOUT_MAX)
+			rc = pthread_cond_wait(&s->cond, &s->mtx);
+		else
+			rc = pthread_cond_timedwait(&s->cond, &s->mtx, &ts);
+	}
+
+	bool taken = s->given;
+	s->given = false;
+
+	pthread_mutex_unlock(&s->mtx);
+
+	return taken;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *s)
+{
+	pthread_mutex_lock(&s->mtx);
+
+	s->given = true;
+	pthread_cond_signal(&s->cond);
+
+	pthread_mutex_unlock(&s->mtx);
+
+	return true;
+}
+
+bool PIOS_Semaphore_Take_FromISR(struct pios_semaphore *s, bool *woken)
+{
+	return PIOS_Semaphore_Take(s, 0);
+}
+
+bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *s, bool *woken)
+{
+	return PIOS_Semaphore_Give(s);
+}
+
+struct pios_thread {
+	pthread_t thread;
+	void (*fp)(void *);
+	void *argp;
+};
+
+static void *thread_start(void *arg)
+{
+	struct pios_thread *t = arg;
+
+	t->fp(t->argp);
+
+	return NULL;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	struct pios_thread *t = malloc(sizeof(*t));
+
+	if (!t)
+		return NULL;
+
+	t->fp = fp;
+	t->argp = argp;
+
+	if (pthread_create(&t->thread, NULL, thread_start, t) != 0) {
+		free(t);
+		return NULL;
+	}
+
+	pthread_detach(t->thread);
+
+	return t;
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+	usleep(time_ms * 1000);
+}
+
+int32_t PIOS_DELAY_WaitmS(uint32_t mS)
+{
+	usleep(mS * 1000);
+
+	return 0;
+}
+
+bool PIOS_IRQ_InISR(void)
+{
+	return false;
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void *buf)
+{
+	free(buf);
+}
+
+/**
+ * @}
+ * @}
+ */
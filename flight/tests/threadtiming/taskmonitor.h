@@ -0,0 +1 @@
+/* The real one pulls in the generated TaskInfo object */
@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_thread.h"
+
+}
+
+static uint64_t now_us()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void wait_for(volatile bool *flag)
+{
+	while (!*flag)
+		PIOS_Thread_Sleep(1);
+}
+
+static uint32_t total_wakeups(const struct pios_thread_timing &timing)
+{
+	uint32_t total = 0;
+
+	for (int i = 0; i < PIOS_THREAD_LATENCY_BUCKETS; i++)
+		total += timing.latency_hist[i];
+
+	return total;
+}
+
+struct loop_args {
+	uint32_t period_ms;	/* Sleep_Until period */
+	uint32_t busy_us;	/* CPU burnt each iteration */
+	int iterations;
+	volatile bool done;
+};
+
+static void periodic_task(void *arg)
+{
+	struct loop_args *args = (struct loop_args *) arg;
+	uint32_t prev = PIOS_Thread_Systime();
+
+	for (int i = 0; i < args->iterations; i++) {
+		uint64_t start = now_us();
+
+		while (now_us() - start < args->busy_us)
+			;
+
+		PIOS_Thread_Sleep_Until(&prev, args->period_ms);
+	}
+
+	args->done = true;
+
+	while (true)
+		PIOS_Thread_Sleep(1000);
+}
+
+class ThreadTiming : public testing::Test {
+};
+
+TEST_F(ThreadTiming, CPUTimeFollowsWork) {
+	struct loop_args busy = { 10, 8000, 20, false };
+	struct loop_args idle = { 10, 0, 20, false };
+
+	struct pios_thread *busy_thread = PIOS_Thread_Create(periodic_task,
+			"busy", PIOS_THREAD_STACK_SIZE_MIN, &busy, PIOS_THREAD_PRIO_NORMAL);
+	struct pios_thread *idle_thread = PIOS_Thread_Create(periodic_task,
+			"idle", PIOS_THREAD_STACK_SIZE_MIN, &idle, PIOS_THREAD_PRIO_NORMAL);
+
+	ASSERT_TRUE(busy_thread != NULL);
+	ASSERT_TRUE(idle_thread != NULL);
+
+	wait_for(&busy.done);
+	wait_for(&idle.done);
+
+	struct pios_thread_timing timing;
+
+	if (!PIOS_Thread_Get_Timing(busy_thread, &timing))
+		return;		/* No thread CPU clocks on this host */
+
+	/* 20 iterations of 8ms busy */
+	uint32_t busy_runtime = PIOS_Thread_Get_Runtime(busy_thread);
+	EXPECT_GE(busy_runtime, 150000U);
+	EXPECT_EQ(busy_runtime / 1000, timing.cpu_time_us / 1000);
+
+	EXPECT_LT(PIOS_Thread_Get_Runtime(idle_thread), 20000U);
+
+	/* Accounted from the previous call */
+	EXPECT_LT(PIOS_Thread_Get_Runtime(busy_thread), 5000U);
+};
+
+TEST_F(ThreadTiming, EveryWakeupIsCounted) {
+	struct loop_args args = { 2, 0, 50, false };
+
+	struct pios_thread *thread = PIOS_Thread_Create(periodic_task,
+			"wakeups", PIOS_THREAD_STACK_SIZE_MIN, &args, PIOS_THREAD_PRIO_NORMAL);
+
+	ASSERT_TRUE(thread != NULL);
+
+	wait_for(&args.done);
+
+	struct pios_thread_timing timing;
+	PIOS_Thread_Get_Timing(thread, &timing);
+
+	/* The loop's wakeups, plus maybe the first idle sleep */
+	EXPECT_GE(total_wakeups(timing), 50U);
+	EXPECT_LE(total_wakeups(timing), 51U);
+
+#ifdef __linux__
+	EXPECT_GE(timing.voluntary_switches, 40U);
+#endif
+};
+
+TEST_F(ThreadTiming, OverrunsShowAsLatency) {
+	/* Each iteration takes 8ms of a 2ms period */
+	struct loop_args args = { 2, 8000, 10, false };
+
+	struct pios_thread *thread = PIOS_Thread_Create(periodic_task,
+			"overrun", PIOS_THREAD_STACK_SIZE_MIN, &args, PIOS_THREAD_PRIO_NORMAL);
+
+	ASSERT_TRUE(thread != NULL);
+
+	wait_for(&args.done);
+
+	struct pios_thread_timing timing;
+	PIOS_Thread_Get_Timing(thread, &timing);
+
+	EXPECT_GE(timing.max_latency_us, 5000U);
+	EXPECT_GE(timing.latency_hist[PIOS_THREAD_LATENCY_BUCKETS - 1], 9U);
+
+	/* The worst case is reset once read; the histogram is not */
+	PIOS_Thread_Get_Timing(thread, &timing);
+
+	EXPECT_LT(timing.max_latency_us, 5000U);
+	EXPECT_GE(timing.latency_hist[PIOS_THREAD_LATENCY_BUCKETS - 1], 9U);
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,5 @@
+/* Normally set by the flightd command line */
+
+#include <stdbool.h>
+
+bool are_realtime = false;
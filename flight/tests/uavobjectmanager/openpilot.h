@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @file       openpilot.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Minimal environment for building the object manager on the host
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <pios_flashfs.h>
+#include <uavobjectmanager.h>
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+/* Every queue is the same mock queue, which keeps what is sent to it */
+#define MOCK_QUEUE_LEN 16
+extern UAVObjEvent mock_queue_events[MOCK_QUEUE_LEN];
+extern int mock_queue_count;
+
+#endif /* OPENPILOT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,41 @@
+/**
+ ******************************************************************************
+ * @file       pios_thread.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Thread API subset used by the object manager
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_THREAD_H_
+#define PIOS_THREAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct pios_thread;
+
+uint32_t PIOS_Thread_Systime(void);
+
+#endif /* PIOS_THREAD_H_ */
+
+/**
+ * @}
+ * @}
+ */
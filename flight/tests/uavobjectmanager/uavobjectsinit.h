@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ * @file       uavobjectsinit.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Stand-in for the header normally produced by uavobjgenerator
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef UAVOBJECTSINIT_H
+#define UAVOBJECTSINIT_H
+
+void UAVObjectsInitializeAll();
+
+#define UAVOBJECTS_LARGEST 256
+#define UAVOBJECTS_COUNT 128
+
+#endif /* UAVOBJECTSINIT_H */
+
+/**
+ * @}
+ * @}
+ */
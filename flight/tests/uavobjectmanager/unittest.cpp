@@ -0,0 +1,626 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <pthread.h>		/* pthread_create */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavobjectsinit.h"
+
+}
+
+/* Roughly the number of objects registered by a full flight build */
+#define NUM_OBJECTS 120
+
+#define LOOKUP_ROUNDS 20000
+
+static uint32_t object_id(int n)
+{
+	/* Object IDs are hashes, and metaobjects take id + 1 */
+	return (0x9E3779B1u * (n + 1)) & ~1u;
+}
+
+static double now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjManager : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+  }
+
+  virtual void TearDown() {
+  }
+
+  void RegisterObjects(int count) {
+    for (int i = 0; i < count; i++) {
+      handles[i] = UAVObjRegister(object_id(i), i % 2, 0, 16 + i, NULL);
+      ASSERT_TRUE(handles[i] != NULL);
+    }
+  }
+
+  UAVObjHandle handles[UAVOBJECTS_COUNT * 2];
+};
+
+class UAVObjLookup : public UAVObjManager {
+};
+
+TEST_F(UAVObjLookup, FindsDataAndMetaObjects) {
+  RegisterObjects(NUM_OBJECTS);
+
+  for (int i = 0; i < NUM_OBJECTS; i++) {
+    EXPECT_EQ(handles[i], UAVObjGetByID(object_id(i)));
+    EXPECT_EQ(UAVObjGetLinkedObj(handles[i]), UAVObjGetByID(object_id(i) + 1));
+    EXPECT_TRUE(UAVObjIsMetaobject(UAVObjGetByID(object_id(i) + 1)));
+  }
+
+  EXPECT_TRUE(UAVObjGetByID(0x12345678) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(object_id(NUM_OBJECTS)) == NULL);
+};
+
+TEST_F(UAVObjLookup, RejectsDuplicates) {
+  RegisterObjects(NUM_OBJECTS);
+
+  EXPECT_TRUE(UAVObjRegister(object_id(7), 1, 0, 16, NULL) == NULL);
+  EXPECT_EQ(NUM_OBJECTS, UAVObjCount());
+};
+
+TEST_F(UAVObjLookup, FallsBackWhenIndexIsFull) {
+  /* More objects than the generated count, e.g. from a loadable module */
+  RegisterObjects(UAVOBJECTS_COUNT * 2);
+
+  for (int i = 0; i < UAVOBJECTS_COUNT * 2; i++) {
+    EXPECT_EQ(handles[i], UAVObjGetByID(object_id(i)));
+    EXPECT_EQ(UAVObjGetLinkedObj(handles[i]), UAVObjGetByID(object_id(i) + 1));
+  }
+
+  EXPECT_TRUE(UAVObjGetByID(0x12345678) == NULL);
+};
+
+static UAVObjHandle linear_list[UAVOBJECTS_COUNT * 4];
+static int linear_count;
+
+static void linear_collect(UAVObjHandle obj)
+{
+  linear_list[linear_count++] = obj;
+}
+
+/* The lookup as it was done before the index: a walk over every object */
+static UAVObjHandle linear_lookup(uint32_t id)
+{
+  for (int i = 0; i < linear_count; i++) {
+    if (UAVObjGetID(linear_list[i]) == id)
+      return linear_list[i];
+  }
+
+  return NULL;
+}
+
+TEST_F(UAVObjLookup, Benchmark) {
+  RegisterObjects(NUM_OBJECTS);
+
+  linear_count = 0;
+  UAVObjIterate(linear_collect);
+
+  volatile uintptr_t sink = 0;
+
+  double start = now_ns();
+  for (int r = 0; r < LOOKUP_ROUNDS; r++)
+    for (int i = 0; i < NUM_OBJECTS; i++)
+      sink += (uintptr_t) linear_lookup(object_id(i) + (r & 1));
+  double linear_ns = (now_ns() - start) / (LOOKUP_ROUNDS * NUM_OBJECTS);
+
+  start = now_ns();
+  for (int r = 0; r < LOOKUP_ROUNDS; r++)
+    for (int i = 0; i < NUM_OBJECTS; i++)
+      sink += (uintptr_t) UAVObjGetByID(object_id(i) + (r & 1));
+  double indexed_ns = (now_ns() - start) / (LOOKUP_ROUNDS * NUM_OBJECTS);
+
+  printf("UAVObjGetByID over %d objects: list walk %.1f ns, indexed %.1f ns\n",
+      NUM_OBJECTS, linear_ns, indexed_ns);
+
+  EXPECT_LT(indexed_ns, linear_ns);
+};
+
+class UAVObjConcurrency : public UAVObjManager {
+};
+
+#define PATTERN_WORDS 32
+
+struct pattern {
+  uint32_t words[PATTERN_WORDS];
+};
+
+static volatile bool stop_threads;
+
+static void *pattern_writer(void *ctx)
+{
+  UAVObjHandle obj = (UAVObjHandle) ctx;
+  struct pattern p;
+
+  for (uint32_t n = 0; !stop_threads; n++) {
+    for (int i = 0; i < PATTERN_WORDS; i++)
+      p.words[i] = n;
+
+    UAVObjSetInstanceData(obj, 0, &p);
+  }
+
+  return NULL;
+}
+
+TEST_F(UAVObjConcurrency, ReadsAreNeverTorn) {
+  UAVObjHandle obj = UAVObjRegister(0x1000, 1, 0, sizeof(struct pattern), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  UAVObjClearStats();
+
+  stop_threads = false;
+
+  pthread_t writer;
+  ASSERT_EQ(0, pthread_create(&writer, NULL, pattern_writer, obj));
+
+  int torn = 0;
+  for (int r = 0; r < 200000; r++) {
+    struct pattern p;
+
+    ASSERT_EQ(0, UAVObjGetInstanceData(obj, 0, &p));
+
+    for (int i = 1; i < PATTERN_WORDS; i++) {
+      if (p.words[i] != p.words[0]) {
+        torn++;
+        break;
+      }
+    }
+
+    uint32_t words[2];
+    ASSERT_EQ(0, UAVObjGetInstanceDataField(obj, 0, words,
+          sizeof(uint32_t) * (PATTERN_WORDS - 2), sizeof(words)));
+    if (words[0] != words[1])
+      torn++;
+  }
+
+  stop_threads = true;
+  pthread_join(writer, NULL);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+
+  printf("Lockless read retries: %u, lock contentions: %u\n",
+      stats.lockFreeReadRetries, stats.lockContentions);
+
+  EXPECT_EQ(0, torn);
+};
+
+TEST_F(UAVObjConcurrency, RejectsOverruns) {
+  UAVObjHandle obj = UAVObjRegister(0x1000, 1, 0, sizeof(struct pattern), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  uint32_t word;
+  EXPECT_EQ(-1, UAVObjGetInstanceDataField(obj, 0, &word,
+        sizeof(struct pattern), sizeof(word)));
+  EXPECT_EQ(-1, UAVObjGetInstanceData(obj, 1, &word));
+  EXPECT_EQ(0, UAVObjGetInstanceDataField(obj, 0, &word,
+        sizeof(struct pattern) - sizeof(word), sizeof(word)));
+};
+
+TEST_F(UAVObjConcurrency, ReadViewsDetectTornReads) {
+  UAVObjHandle obj = UAVObjRegister(0x1000, 1, 0, sizeof(struct pattern), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  UAVObjClearStats();
+
+  stop_threads = false;
+
+  pthread_t writer;
+  ASSERT_EQ(0, pthread_create(&writer, NULL, pattern_writer, obj));
+
+  int torn = 0;
+  for (int r = 0; r < 200000; r++) {
+    UAVObjReadView view = { };
+    uint32_t first, last;
+
+    do {
+      const struct pattern *p =
+        (const struct pattern *) UAVObjReadBegin(obj, 0, &view);
+      ASSERT_TRUE(p != NULL);
+
+      first = p->words[0];
+      last = p->words[PATTERN_WORDS - 1];
+    } while (!UAVObjReadEnd(&view));
+
+    if (first != last)
+      torn++;
+  }
+
+  stop_threads = true;
+  pthread_join(writer, NULL);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+
+  printf("Read view retries: %u, lock contentions: %u\n",
+      stats.lockFreeReadRetries, stats.lockContentions);
+
+  EXPECT_EQ(0, torn);
+};
+
+TEST_F(UAVObjConcurrency, ReadViewsFallBackToTheLock) {
+  UAVObjHandle obj = UAVObjRegister(0x1000, 1, 0, sizeof(struct pattern), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  struct pattern p;
+  memset(&p, 0x5a, sizeof(p));
+  ASSERT_EQ(0, UAVObjSetInstanceData(obj, 0, &p));
+
+  /* A view that has already lost every race waits on the mutex */
+  UAVObjReadView view = { };
+  view.attempts = 0xff;
+
+  const struct pattern *in_place =
+    (const struct pattern *) UAVObjReadBegin(obj, 0, &view);
+  ASSERT_TRUE(in_place != NULL);
+  EXPECT_TRUE(view.locked);
+  EXPECT_EQ(0, memcmp(in_place, &p, sizeof(p)));
+  EXPECT_TRUE(UAVObjReadEnd(&view));
+  EXPECT_FALSE(view.locked);
+
+  /* Missing instances give no pointer and leave the mutex free */
+  UAVObjReadView missing = { };
+  EXPECT_TRUE(UAVObjReadBegin(obj, 1, &missing) == NULL);
+  missing.attempts = 0xff;
+  EXPECT_TRUE(UAVObjReadBegin(obj, 1, &missing) == NULL);
+  EXPECT_FALSE(missing.locked);
+};
+
+class UAVObjInstances : public UAVObjManager {
+};
+
+/* An odd size, to check that instances stay word aligned */
+struct waypoint {
+  float position[3];
+  uint8_t action;
+};
+
+#define NUM_INSTANCES 300
+
+TEST_F(UAVObjInstances, AreIndependentAndAligned) {
+  UAVObjHandle obj = UAVObjRegister(0x3000, 0, 0, sizeof(struct waypoint), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  for (uint16_t i = 1; i < NUM_INSTANCES; i++)
+    ASSERT_EQ(i, UAVObjCreateInstance(obj, NULL));
+
+  EXPECT_EQ(NUM_INSTANCES, UAVObjGetNumInstances(obj));
+
+  for (uint16_t i = 0; i < NUM_INSTANCES; i++) {
+    struct waypoint wp = { { (float) i, 0, 0 }, (uint8_t) i };
+    ASSERT_EQ(0, UAVObjSetInstanceData(obj, i, &wp));
+  }
+
+  for (uint16_t i = 0; i < NUM_INSTANCES; i++) {
+    struct waypoint wp;
+    ASSERT_EQ(0, UAVObjGetInstanceData(obj, i, &wp));
+    EXPECT_EQ((float) i, wp.position[0]);
+    EXPECT_EQ((uint8_t) i, wp.action);
+
+    UAVObjReadView view = { };
+    const void *in_place = UAVObjReadBegin(obj, i, &view);
+    EXPECT_EQ(0u, (uintptr_t) in_place % 4);
+    EXPECT_TRUE(UAVObjReadEnd(&view));
+  }
+
+  struct waypoint wp;
+  EXPECT_EQ(-1, UAVObjGetInstanceData(obj, NUM_INSTANCES, &wp));
+};
+
+TEST_F(UAVObjInstances, GapsAreFilled) {
+  UAVObjHandle obj = UAVObjRegister(0x3000, 0, 0, sizeof(struct waypoint), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  struct waypoint wp = { { 1, 2, 3 }, 4 };
+  ASSERT_EQ(0, UAVObjSetInstanceData(obj, 0, &wp));
+
+  /* Unpacking a far instance creates everything up to it, zeroed */
+  EXPECT_EQ(0, UAVObjUnpack(obj, 40, (const uint8_t *) &wp));
+  EXPECT_EQ(41, UAVObjGetNumInstances(obj));
+
+  ASSERT_EQ(0, UAVObjGetInstanceData(obj, 20, &wp));
+  EXPECT_EQ(0, wp.position[2]);
+  ASSERT_EQ(0, UAVObjGetInstanceData(obj, 40, &wp));
+  EXPECT_EQ(3, wp.position[2]);
+
+  EXPECT_EQ(0, UAVObjCreateInstance(UAVObjGetLinkedObj(obj), NULL));
+};
+
+TEST_F(UAVObjInstances, Benchmark) {
+  UAVObjHandle obj = UAVObjRegister(0x3000, 0, 0, sizeof(struct waypoint), NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  for (uint16_t i = 1; i < NUM_INSTANCES; i++)
+    ASSERT_EQ(i, UAVObjCreateInstance(obj, NULL));
+
+  volatile float sink = 0;
+
+  double start = now_ns();
+  for (int r = 0; r < LOOKUP_ROUNDS / 10; r++) {
+    for (uint16_t i = 0; i < NUM_INSTANCES; i++) {
+      struct waypoint wp;
+      UAVObjGetInstanceData(obj, i, &wp);
+      sink += wp.position[0];
+    }
+  }
+  double ns = (now_ns() - start) / (LOOKUP_ROUNDS / 10 * NUM_INSTANCES);
+
+  printf("UAVObjGetInstanceData over %d instances: %.1f ns\n",
+      NUM_INSTANCES, ns);
+};
+
+class UAVObjEvents : public UAVObjManager {
+};
+
+#define CHAIN_LENGTH 12
+
+static UAVObjHandle chain[CHAIN_LENGTH];
+static int delivered[CHAIN_LENGTH];
+
+/* Each object's callback updates the next object in the chain */
+static void chain_cb(UAVObjEvent *, void *ctx, void *, int)
+{
+  intptr_t n = (intptr_t) ctx;
+  uint32_t val = 0;
+
+  delivered[n]++;
+
+  if (n + 1 < CHAIN_LENGTH)
+    UAVObjSetData(chain[n + 1], &val);
+}
+
+#define FANOUT 6
+
+/* The first object's callback updates several other objects at once */
+static void fanout_cb(UAVObjEvent *, void *, void *, int)
+{
+  uint32_t val = 0;
+
+  delivered[0]++;
+
+  for (int i = 1; i <= FANOUT; i++)
+    UAVObjSetData(chain[i], &val);
+}
+
+static void count_cb(UAVObjEvent *, void *ctx, void *, int)
+{
+  delivered[(intptr_t) ctx]++;
+}
+
+static int self_depth;
+static int self_max_depth;
+
+/* Answers the first update of its own object with another update, the way
+ * the telemetry session handshake does */
+static void self_cb(UAVObjEvent *ev, void *, void *, int)
+{
+  uint32_t val;
+
+  if (++self_depth > self_max_depth)
+    self_max_depth = self_depth;
+
+  delivered[0]++;
+
+  UAVObjGetData(ev->obj, &val);
+  if (val == 0) {
+    val = 1;
+    UAVObjSetData(ev->obj, &val);
+  }
+
+  self_depth--;
+}
+
+TEST_F(UAVObjEvents, DeepCallbackChainsAreDelivered) {
+  for (intptr_t i = 0; i < CHAIN_LENGTH; i++) {
+    chain[i] = UAVObjRegister(0x2000 + 2 * i, 1, 0, sizeof(uint32_t), NULL);
+    ASSERT_TRUE(chain[i] != NULL);
+    ASSERT_EQ(0, UAVObjConnectCallback(chain[i], chain_cb, (void *) i, EV_UPDATED));
+  }
+
+  memset(delivered, 0, sizeof(delivered));
+  UAVObjClearStats();
+
+  uint32_t val = 0;
+  UAVObjSetData(chain[0], &val);
+
+  for (int i = 0; i < CHAIN_LENGTH; i++)
+    EXPECT_EQ(1, delivered[i]);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(0u, stats.eventCallbackErrors);
+  EXPECT_EQ(1, stats.eventBacklogHighWater);
+};
+
+TEST_F(UAVObjEvents, NestedEventsFanOut) {
+  chain[0] = UAVObjRegister(0x2000, 1, 0, sizeof(uint32_t), NULL);
+  ASSERT_EQ(0, UAVObjConnectCallback(chain[0], fanout_cb, NULL, EV_UPDATED));
+
+  for (intptr_t i = 1; i <= FANOUT; i++) {
+    chain[i] = UAVObjRegister(0x2000 + 2 * i, 1, 0, sizeof(uint32_t), NULL);
+    ASSERT_TRUE(chain[i] != NULL);
+    ASSERT_EQ(0, UAVObjConnectCallback(chain[i], count_cb, (void *) i, EV_UPDATED));
+  }
+
+  memset(delivered, 0, sizeof(delivered));
+  UAVObjClearStats();
+
+  uint32_t val = 0;
+  UAVObjSetData(chain[0], &val);
+
+  for (int i = 0; i <= FANOUT; i++)
+    EXPECT_EQ(1, delivered[i]);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(0u, stats.eventCallbackErrors);
+  EXPECT_EQ(FANOUT, stats.eventBacklogHighWater);
+};
+
+TEST_F(UAVObjEvents, SelfUpdatesAreDeliveredOnce) {
+  chain[0] = UAVObjRegister(0x2000, 1, 0, sizeof(uint32_t), NULL);
+  ASSERT_EQ(0, UAVObjConnectCallback(chain[0], self_cb, NULL, EV_UPDATED));
+
+  memset(delivered, 0, sizeof(delivered));
+  self_depth = 0;
+  self_max_depth = 0;
+  UAVObjClearStats();
+
+  uint32_t val = 0;
+  UAVObjSetData(chain[0], &val);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+
+  /* The callback's own update comes back once, after it has returned */
+  EXPECT_EQ(2, delivered[0]);
+  EXPECT_EQ(1, self_max_depth);
+  EXPECT_EQ(0u, stats.eventSelfUpdates);
+  EXPECT_EQ(0u, stats.eventCallbackErrors);
+
+  UAVObjGetData(chain[0], &val);
+  EXPECT_EQ(1u, val);
+};
+
+/* Updates its own object after raising an event on another */
+static void self_pending_cb(UAVObjEvent *ev, void *, void *, int)
+{
+  uint32_t val = 1;
+
+  delivered[0]++;
+
+  UAVObjSetData(chain[1], &val);
+  UAVObjSetData(ev->obj, &val);
+}
+
+TEST_F(UAVObjEvents, SelfUpdatesBehindPendingEventsAreDropped) {
+  chain[0] = UAVObjRegister(0x2000, 1, 0, sizeof(uint32_t), NULL);
+  chain[1] = UAVObjRegister(0x2002, 1, 0, sizeof(uint32_t), NULL);
+  ASSERT_EQ(0, UAVObjConnectCallback(chain[0], self_pending_cb, NULL, EV_UPDATED));
+  ASSERT_EQ(0, UAVObjConnectCallback(chain[1], count_cb, (void *) 1, EV_UPDATED));
+
+  memset(delivered, 0, sizeof(delivered));
+  UAVObjClearStats();
+
+  uint32_t val = 0;
+  UAVObjSetData(chain[0], &val);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+
+  EXPECT_EQ(1, delivered[0]);
+  EXPECT_EQ(1, delivered[1]);
+  EXPECT_EQ(1u, stats.eventSelfUpdates);
+  EXPECT_EQ(0u, stats.eventCallbackErrors);
+
+  /* The data written by the callback still lands */
+  UAVObjGetData(chain[0], &val);
+  EXPECT_EQ(1u, val);
+};
+
+/* A request/answer exchange as telemetry does the session object table:
+ * the GCS's request is unpacked into chain[0], whose callback answers in the
+ * same object and then notes the session in chain[1] */
+static void table_cb(UAVObjEvent *ev, void *, void *, int)
+{
+  uint32_t val;
+
+  if (ev->event != EV_UNPACKED)
+    return;
+
+  delivered[0]++;
+
+  UAVObjGetData(ev->obj, &val);
+  val++;
+  UAVObjSetData(ev->obj, &val);
+
+  UAVObjSetData(chain[1], &val);
+}
+
+TEST_F(UAVObjEvents, AnswersFromCallbacksAreSent) {
+  chain[0] = UAVObjRegister(0x2000, 1, 0, sizeof(uint32_t), NULL);
+  chain[1] = UAVObjRegister(0x2002, 1, 0, sizeof(uint32_t), NULL);
+  ASSERT_EQ(0, UAVObjConnectCallback(chain[0], table_cb, NULL, EV_MASK_ALL_UPDATES));
+
+  /* Stands in for the telemetry tx queue */
+  struct pios_queue *queue = (struct pios_queue *) &mock_queue_count;
+  ASSERT_EQ(0, UAVObjConnectQueue(chain[0], queue, EV_MASK_ALL_UPDATES));
+
+  memset(delivered, 0, sizeof(delivered));
+  mock_queue_count = 0;
+  UAVObjClearStats();
+
+  uint32_t request = 41;
+  UAVObjUnpack(chain[0], 0, (const uint8_t *) &request);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+
+  EXPECT_EQ(1, delivered[0]);
+  EXPECT_EQ(0u, stats.eventSelfUpdates);
+
+  /* The request, then the answer on its way back to the GCS */
+  ASSERT_EQ(2, mock_queue_count);
+  EXPECT_EQ(EV_UNPACKED, mock_queue_events[0].event);
+  EXPECT_EQ(EV_UPDATED, mock_queue_events[1].event);
+  EXPECT_EQ(chain[0], mock_queue_events[1].obj);
+
+  uint32_t val;
+  UAVObjGetData(chain[0], &val);
+  EXPECT_EQ(42u, val);
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,131 @@
+/**
+ ******************************************************************************
+ * @file       unittest_mocks.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Host implementations of the PiOS services used by the object manager
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "openpilot.h"
+#include "pios_heap.h"
+#include "pios_mutex.h"
+#include "pios_queue.h"
+#include "pios_thread.h"
+#include "misc_math.h"
+
+uintptr_t pios_uavo_settings_fs_id;
+
+struct pios_recursive_mutex {
+	pthread_mutex_t mtx;
+};
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
+{
+	struct pios_recursive_mutex *m = malloc(sizeof(*m));
+	pthread_mutexattr_t attr;
+
+	if (!m)
+		return NULL;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&m->mtx, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	return m;
+}
+
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *m, uint32_t timeout_ms)
+{
+	return pthread_mutex_lock(&m->mtx) == 0;
+}
+
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *m)
+{
+	return pthread_mutex_unlock(&m->mtx) == 0;
+}
+
+/* Events sent to any queue, for the tests to look at */
+UAVObjEvent mock_queue_events[MOCK_QUEUE_LEN];
+int mock_queue_count;
+
+bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
+{
+	if (mock_queue_count >= MOCK_QUEUE_LEN)
+		return false;
+
+	mock_queue_events[mock_queue_count++] = *(const UAVObjEvent *) itemp;
+
+	return true;
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void *buf)
+{
+	free(buf);
+}
+
+uint16_t randomize_int(uint16_t interval)
+{
+	return rand() % (interval + 1);
+}
+
+/* No settings filesystem; loads fail so registration keeps the defaults */
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	return -1;
+}
+
+/**
+ * @}
+ * @}
+ */
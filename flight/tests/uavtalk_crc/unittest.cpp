@@ -0,0 +1,172 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv, rand */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <vector>
+
+extern "C" {
+
+#include "pios_crc.h"
+#include "uavtalk_crc.h"
+
+}
+
+static double now_s()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Build a stream shaped like a telemetry log: UAVTalk frames with a
+ * timestamped header and payloads of typical object sizes.
+ */
+static void make_stream(std::vector<uint8_t> &stream,
+		std::vector<size_t> &frame_lengths, size_t bytes)
+{
+	srand(1234);
+
+	while (stream.size() < bytes) {
+		size_t len = 10 + 4 * (rand() % 50);
+
+		for (size_t i = 0; i < len; i++)
+			stream.push_back(rand());
+
+		frame_lengths.push_back(len);
+	}
+}
+
+class UAVTalkCRC : public testing::Test {
+};
+
+TEST_F(UAVTalkCRC, KnownValues) {
+	const uint8_t check[] = "123456789";
+
+	/* CRC-8 check value for poly 0x07 */
+	EXPECT_EQ(0xf4, uavtalk_crc_update(0, check, 9));
+	EXPECT_EQ(0xf4, PIOS_CRC_updateCRC(0, check, 9));
+
+	EXPECT_EQ(0, uavtalk_crc_update(0, check, 0));
+	EXPECT_EQ(0x5a, uavtalk_crc_update(0x5a, check, 0));
+};
+
+TEST_F(UAVTalkCRC, MatchesBytewiseAtAllLengthsAndAlignments) {
+	uint8_t buf[512];
+
+	srand(42);
+	for (unsigned i = 0; i < sizeof(buf); i++)
+		buf[i] = rand();
+
+	for (int start = 0; start < 8; start++) {
+		for (int len = 0; len < 300; len++) {
+			uint8_t seed = start * 31 + len;
+			uint8_t expected = seed;
+
+			for (int i = 0; i < len; i++)
+				expected = PIOS_CRC_updateByte(expected, buf[start + i]);
+
+			ASSERT_EQ(expected, uavtalk_crc_update(seed, buf + start, len))
+				<< "start " << start << " len " << len;
+		}
+	}
+};
+
+/*
+ * Set UAVTALK_CRC_LOG to the path of a recorded telemetry log to measure
+ * over it (checksumming it in 256 byte frames); otherwise a synthetic
+ * stream of the same shape is used.
+ */
+TEST_F(UAVTalkCRC, Benchmark) {
+	std::vector<uint8_t> stream;
+	std::vector<size_t> frames;
+
+	const char *log = getenv("UAVTALK_CRC_LOG");
+	FILE *f = log ? fopen(log, "rb") : NULL;
+
+	if (f) {
+		uint8_t chunk[256];
+		size_t got;
+
+		while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+			stream.insert(stream.end(), chunk, chunk + got);
+			frames.push_back(got);
+		}
+
+		fclose(f);
+	} else {
+		make_stream(stream, frames, 32 * 1024 * 1024);
+	}
+
+	volatile uint8_t sink = 0;
+
+	double start = now_s();
+	const uint8_t *p = stream.data();
+	for (size_t i = 0; i < frames.size(); i++) {
+		uint8_t crc = 0;
+
+		for (size_t j = 0; j < frames[i]; j++)
+			crc = PIOS_CRC_updateByte(crc, p[j]);
+
+		sink ^= crc;
+		p += frames[i];
+	}
+	double bytewise = now_s() - start;
+
+	start = now_s();
+	p = stream.data();
+	for (size_t i = 0; i < frames.size(); i++) {
+		sink ^= uavtalk_crc_update(0, p, frames[i]);
+		p += frames[i];
+	}
+	double sliced = now_s() - start;
+
+	double mb = stream.size() / 1e6;
+
+	printf("%s, %.1f MB in %zu frames: bytewise %.0f MB/s, sliced %.0f MB/s\n",
+			f ? log : "synthetic log", mb, frames.size(),
+			mb / bytewise, mb / sliced);
+
+	EXPECT_LT(sliced, bytewise);
+};
+
+/**
+ * @}
+ * @}
+ */
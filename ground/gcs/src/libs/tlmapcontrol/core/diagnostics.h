@@ -37,9 +37,12 @@ struct diagnostics
     int tilesFromMem;
     int tilesFromNet;
     int tilesFromDB;
+    int pixmapHits;
+    int pixmapMisses;
+    double decodeTimeMs;
     QString toString()
     {
-        return QString("Network errors:%1\nEmpty Tiles:%2\nTimeOuts:%3\nRunningThreads:%4\nTilesFromMem:%5\nTilesFromNet:%6\nTilesFromDB:%7").arg(networkerrors).arg(emptytiles).arg(timeouts).arg(runningThreads).arg(tilesFromMem).arg(tilesFromNet).arg(tilesFromDB);
+        return QString("Network errors:%1\nEmpty Tiles:%2\nTimeOuts:%3\nRunningThreads:%4\nTilesFromMem:%5\nTilesFromNet:%6\nTilesFromDB:%7\nPixmapHits:%8\nPixmapMisses:%9\nDecodeTime:%10ms").arg(networkerrors).arg(emptytiles).arg(timeouts).arg(runningThreads).arg(tilesFromMem).arg(tilesFromNet).arg(tilesFromDB).arg(pixmapHits).arg(pixmapMisses).arg(decodeTimeMs,0,'f',1);
        ;
     }
 };
@@ -25,12 +25,15 @@
 * with this program; if not, see <http://www.gnu.org/licenses/>
 */
 #include "pureimagecache.h"
+#include "cacheitemqueue.h"
 #include <QDateTime>
 #include <QSettings>
 //#define DEBUG_PUREIMAGECACHE
 namespace core {
     qlonglong PureImageCache::ConnCounter=0;
 
+    static const char WRITER_CONNECTION[]="TileCacheWriter";
+
     PureImageCache::PureImageCache()
     {
 
@@ -171,48 +174,78 @@ namespace core {
         QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
         return true;
     }
-    bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
+    /**
+     * @brief PureImageCache::PutImagesToCache Store tiles in one transaction,
+     * through a connection that stays open between calls. Only one thread may
+     * call this, and it must call CloseWriter() when done.
+     * @param tiles The tiles to store
+     * @return true if the tiles were stored
+     */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue *> &tiles)
     {
-        if(gtilecache.isEmpty()|gtilecache.isNull())
-            return false;
         lock.lockForRead();
+        if(gtilecache.isEmpty())
+        {
+            lock.unlock();
+            return false;
+        }
+        QString db=gtilecache+"Data.qmdb";
+        if(writer.isOpen() && writer.databaseName()!=db)
+            CloseWriter();
+        if(!writer.isOpen())
+        {
+            writer=QSqlDatabase::addDatabase("QSQLITE",QLatin1String(WRITER_CONNECTION));
+            writer.setDatabaseName(db);
+            writer.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
+            if(!writer.open())
+            {
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+                qDebug()<<"PutImagesToCache: "<<writer.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+                CloseWriter();
+                lock.unlock();
+                return false;
+            }
+        }
+#ifdef DEBUG_PUREIMAGECACHE
+        qDebug()<<"PutImagesToCache:"<<tiles.count()<<"tiles";
+#endif //DEBUG_PUREIMAGECACHE
+        // A transaction per tile would sync the file for every one of them
+        writer.transaction();
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            QSqlQuery tileQuery(writer);
+            tileQuery.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+            QSqlQuery dataQuery(writer);
+            dataQuery.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+            QString date=QDateTime::currentDateTime().toString();
+            foreach(CacheItemQueue *tile,tiles)
             {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
+                tileQuery.addBindValue(tile->GetPosition().X());
+                tileQuery.addBindValue(tile->GetPosition().Y());
+                tileQuery.addBindValue(tile->GetZoom());
+                tileQuery.addBindValue((int)tile->GetMapType());
+                tileQuery.addBindValue(date);
+                if(!tileQuery.exec())
+                    continue;
+                dataQuery.addBindValue(tile->GetImg());
+                dataQuery.exec();
             }
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
+        bool ret=writer.commit();
         lock.unlock();
-        return true;
+        return ret;
+    }
+    /**
+     * @brief PureImageCache::CloseWriter Close the connection opened by
+     * PutImagesToCache, from the thread that opened it
+     */
+    void PureImageCache::CloseWriter()
+    {
+        if(!writer.isValid())
+            return;
+        writer.close();
+        writer=QSqlDatabase();
+        QSqlDatabase::removeDatabase(QLatin1String(WRITER_CONNECTION));
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
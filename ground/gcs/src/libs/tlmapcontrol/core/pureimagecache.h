@@ -43,13 +43,16 @@
 #include <QMutex>
 #include <QReadWriteLock>
 namespace core {
+    class CacheItemQueue;
+
     class PureImageCache
     {
 
     public:
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
-        bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue *> &tiles);
+        void CloseWriter();
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
@@ -61,6 +64,9 @@ namespace core {
         QReadWriteLock lock;
         static qlonglong ConnCounter;
 
+        // Connection kept open by the thread writing tiles, see PutImagesToCache
+        QSqlDatabase writer;
+
     };
 
 }
@@ -30,13 +30,15 @@
 //#define DEBUG_TILECACHEQUEUE
  
 namespace core {
-TileCacheQueue::TileCacheQueue()
+TileCacheQueue::TileCacheQueue():
+    stopping(false)
 {
 
 }
 TileCacheQueue::~TileCacheQueue()
 {
-   // QThread::wait(10000);
+    Stop();
+    wait();
 }
 
 void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
@@ -44,34 +46,48 @@ void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"DB Do I EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
+    QMutexLocker locker(&mutex);
     if(!tileCacheQueue.contains(task))
     {
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
-        mutex.lock();
         tileCacheQueue.enqueue(task);
-        mutex.unlock();
         if(this->isRunning())
         {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Wake Thread";
 #endif //DEBUG_TILECACHEQUEUE
-            //this->start(QThread::NormalPriority);
-            //waitmutex.lock();
             waitc.wakeAll();
-            //waitmutex.unlock();
         }
         else
         {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Start Thread";
 #endif //DEBUG_TILECACHEQUEUE
+            stopping=false;
             this->start(QThread::NormalPriority);
         }
     }
 
 }
+
+/**
+ * @brief TileCacheQueue::Stop Have the thread write out what is queued and
+ * finish
+ */
+void TileCacheQueue::Stop()
+{
+    QMutexLocker locker(&mutex);
+    stopping=true;
+    waitc.wakeAll();
+}
+
+/**
+ * @brief TileCacheQueue::run Write queued tiles to the database in batches,
+ * until stopped. The thread keeps a single connection to the database for as
+ * long as it runs.
+ */
 void TileCacheQueue::run()
 {
 #ifdef DEBUG_TILECACHEQUEUE
@@ -79,50 +95,38 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
+        QList<CacheItemQueue*> batch;
+
+        mutex.lock();
+        while(tileCacheQueue.isEmpty() && !stopping)
+        {
 #ifdef DEBUG_TILECACHEQUEUE
-        qDebug()<<"Cache";
+            qDebug()<<"Cache engine BEGIN WAIT";
 #endif //DEBUG_TILECACHEQUEUE
-        if(tileCacheQueue.count()>0)
+            waitc.wait(&mutex);
+        }
+        if(tileCacheQueue.isEmpty())
         {
-            mutex.lock();
-            task=tileCacheQueue.dequeue();
             mutex.unlock();
-#ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
-#endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
+            break;
         }
-
-        else
+        if(!stopping && tileCacheQueue.count()<MAX_BATCH)
         {
+            mutex.unlock();
+            msleep(BATCH_DELAY_MS);
+            mutex.lock();
+        }
+        while(!tileCacheQueue.isEmpty() && batch.count()<MAX_BATCH)
+            batch.append(tileCacheQueue.dequeue());
+        mutex.unlock();
+
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine BEGIN WAIT";
-#endif //DEBUG_TILECACHEQUEUE
-            waitmutex.lock();
-            int tout=4000;
-            if(!waitc.wait(&waitmutex,tout))
-            {
-                waitmutex.unlock();
-#ifdef DEBUG_TILECACHEQUEUE
-                qDebug()<<"Cache Engine TimeOut";
-#endif //DEBUG_TILECACHEQUEUE
-                mutex.lock();
-                if(tileCacheQueue.count()==0)
-                {
-                    mutex.unlock();
-                    break;
-                }
-                mutex.unlock();
-            }
-#ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache Engine DID NOT TimeOut";
+        qDebug()<<"Cache engine Put:"<<batch.count()<<"tiles";
 #endif //DEBUG_TILECACHEQUEUE
-            waitmutex.unlock();
-        }
+        Cache::Instance()->ImageCache.PutImagesToCache(batch);
+        qDeleteAll(batch);
     }
+    Cache::Instance()->ImageCache.CloseWriter();
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"Cache Engine Stopped";
 #endif //DEBUG_TILECACHEQUEUE
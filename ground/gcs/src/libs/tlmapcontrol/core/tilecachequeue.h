@@ -46,14 +46,20 @@ namespace core {
         TileCacheQueue();
         ~TileCacheQueue();
         void EnqueueCacheTask(CacheItemQueue *task);
+        void Stop();
 
     protected:
         QQueue<CacheItemQueue*> tileCacheQueue;
     private:
+        // Tiles arrive in bursts when the map moves; wait this long for the
+        // rest of a burst, and write up to this many in a transaction
+        static const int BATCH_DELAY_MS = 100;
+        static const int MAX_BATCH = 256;
+
         void run();
         QMutex mutex;
-        QMutex waitmutex;
         QWaitCondition waitc;
+        bool stopping;
     };
 }
 #endif // TILECACHEQUEUE_H
@@ -0,0 +1,93 @@
+/**
+******************************************************************************
+*
+* @file       tilepixmapcache.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2016
+* @brief      Decoded tile images, kept for repainting
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "tilepixmapcache.h"
+#include "pureimage.h"
+#include <QElapsedTimer>
+
+namespace core {
+    TilePixmapCache::TilePixmapCache():
+        pixmaps(DEFAULT_CAPACITY_MB * 1024),hits(0),misses(0),decodeNsecs(0)
+    {
+    }
+
+    /**
+     * @brief TilePixmapCache::GetPixmap Get a tile image ready to draw,
+     * decoding it only if it isn't cached already
+     * @param tile Type, position and zoom of the tile
+     * @param layer Which of the tile's overlays this is
+     * @param data The encoded image
+     * @return The decoded image
+     */
+    QPixmap TilePixmapCache::GetPixmap(const RawTile &tile, int layer, const QByteArray &data)
+    {
+        QPair<RawTile, int> key(tile, layer);
+        Entry *entry = pixmaps.object(key);
+
+        // The tile may have been loaded again since; only reuse the same image
+        if(entry && entry->data == data)
+        {
+            ++hits;
+            return entry->pixmap;
+        }
+
+        ++misses;
+
+        QElapsedTimer timer;
+        timer.start();
+        QPixmap pixmap = PureImageProxy::FromStream(data);
+        decodeNsecs += timer.nsecsElapsed();
+
+        int cost = qMax(pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024, 1);
+        pixmaps.insert(key, new Entry{data, pixmap}, cost);
+
+        return pixmap;
+    }
+
+    void TilePixmapCache::setCapacity(int megabytes)
+    {
+        pixmaps.setMaxCost(megabytes * 1024);
+    }
+
+    int TilePixmapCache::Capacity()
+    {
+        return pixmaps.maxCost() / 1024;
+    }
+
+    void TilePixmapCache::Clear()
+    {
+        pixmaps.clear();
+    }
+
+    /**
+     * @brief TilePixmapCache::AddDiagnostics Fill in how well the cache does
+     */
+    void TilePixmapCache::AddDiagnostics(diagnostics &diag)
+    {
+        diag.pixmapHits = hits;
+        diag.pixmapMisses = misses;
+        diag.decodeTimeMs = decodeNsecs / 1e6;
+    }
+}
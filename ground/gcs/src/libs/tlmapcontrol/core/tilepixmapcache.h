@@ -0,0 +1,73 @@
+/**
+******************************************************************************
+*
+* @file       tilepixmapcache.h
+* @author     dRonin, http://dronin.org Copyright (C) 2016
+* @brief      Decoded tile images, kept for repainting
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TILEPIXMAPCACHE_H
+#define TILEPIXMAPCACHE_H
+
+#include "rawtile.h"
+#include "diagnostics.h"
+#include <QByteArray>
+#include <QCache>
+#include <QPair>
+#include <QPixmap>
+
+namespace core {
+    /**
+     * @brief The TilePixmapCache class Tile images as decoded for drawing, so
+     * that repainting the map doesn't decode every tile on it again. Holds up
+     * to a set size of pixmaps, dropping the least recently drawn first.
+     * Pixmaps belong to the GUI thread, and so does this cache.
+     */
+    class TilePixmapCache
+    {
+    public:
+        TilePixmapCache();
+
+        QPixmap GetPixmap(const RawTile &tile, int layer, const QByteArray &data);
+        void setCapacity(int megabytes);
+        int Capacity();
+        void Clear();
+        void AddDiagnostics(diagnostics &diag);
+
+    private:
+        struct Entry
+        {
+            QByteArray data;
+            QPixmap pixmap;
+        };
+
+        // Enough for a few screens of 256 pixel tiles
+        static const int DEFAULT_CAPACITY_MB = 64;
+
+        // Costs are in kilobytes
+        QCache<QPair<RawTile, int>, Entry> pixmaps;
+
+        int hits;
+        int misses;
+        qint64 decodeNsecs;
+    };
+
+}
+#endif // TILEPIXMAPCACHE_H
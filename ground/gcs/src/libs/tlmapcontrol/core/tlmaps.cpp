@@ -56,6 +56,7 @@ namespace core {
 
     TLMaps::~TLMaps()
     {
+        TileDBcacheQueue.Stop();
         TileDBcacheQueue.wait();
     }
 
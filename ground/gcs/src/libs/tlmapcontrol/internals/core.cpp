@@ -229,6 +229,7 @@ namespace internals {
         diag=TLMaps::Instance()->GetDiagnostics();
         diag.runningThreads=runningThreads;
         MrunningThreads.unlock();
+        TilePixmaps.AddDiagnostics(diag);
         return diag;
     }
 
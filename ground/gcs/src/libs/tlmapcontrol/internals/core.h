@@ -50,6 +50,7 @@
 #include "../core/geodecoderstatus.h"
 #include "../core/tlmaps.h"
 #include "../core/diagnostics.h"
+#include "../core/tilepixmapcache.h"
 
 #include <QSemaphore>
 #include <QThread>
@@ -193,6 +194,9 @@ namespace internals {
 
         TileMatrix Matrix;
 
+        // Decoded images of the tiles in Matrix, for the GUI thread to draw
+        core::TilePixmapCache TilePixmaps;
+
         bool isStarted(){return started;}
 
         diagnostics GetDiagnostics();
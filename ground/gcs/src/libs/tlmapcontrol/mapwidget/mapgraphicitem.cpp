@@ -377,14 +377,16 @@ namespace mapcontrol
                             //lock(t.Overlays)
                             if(t!=nullptr)
                             {
-                                foreach(QByteArray img,t->Overlays)
+                                RawTile rawTile(core->GetMapType(),t->GetPos(),t->GetZoom());
+                                for(int layer = 0; layer < t->Overlays.count(); layer++)
                                 {
+                                    const QByteArray &img = t->Overlays.at(layer);
                                     if(img.count()!=0)
                                     {
                                         if(!found)
                                             found = true;
                                         {
-                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),PureImageProxy::FromStream(img));
+                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),core->TilePixmaps.GetPixmap(rawTile,layer,img));
                                         }
                                     }
                                 }
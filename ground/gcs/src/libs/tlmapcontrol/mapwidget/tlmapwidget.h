@@ -234,6 +234,11 @@ namespace mapcontrol
 
         void ReloadMap(){map->ReloadMap(); map->resize();}
 
+        /**
+        * @brief Tile loading and drawing statistics
+        */
+        diagnostics GetDiagnostics(){return core->GetDiagnostics();}
+
         GeoCoderStatusCode::Types SetCurrentPositionByKeywords(QString const& keys){return map->SetCurrentPositionByKeywords(keys);}
 
         MapType::Types GetMapType(){return map->core->GetMapType();}
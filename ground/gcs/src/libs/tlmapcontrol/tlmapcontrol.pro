@@ -32,6 +32,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     core/point.cpp \
     core/size.cpp \
     core/kibertilecache.cpp \
+    core/tilepixmapcache.cpp \
     core/diagnostics.cpp \
     core/tlmaps.cpp \
     internals/core.cpp \
@@ -87,6 +88,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     core/geodecoderstatus.h \
     core/point.h \
     core/kibertilecache.h \
+    core/tilepixmapcache.h \
     core/debugheader.h \
     core/diagnostics.h \
     core/tlmaps.h \
@@ -0,0 +1,43 @@
+include(../../gcs.pri)
+include(../../gcsversioninfo.pri)
+
+# Replays logs into the UAVObjects without the GCS user interface, for
+# checking many logs from the command line
+TEMPLATE = app
+TARGET = logreplay
+DESTDIR = $$GCS_APP_PATH
+macx {
+    DESTDIR = $$GCS_BIN_PATH
+}
+CONFIG -= app_bundle
+CONFIG += console
+QT += widgets
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+DEPENDPATH *= $$GCS_SOURCE_TREE/src/plugins
+
+# The log reader is built in, rather than loading the logging plugin
+HEADERS += ../plugins/logging/logfile.h \
+    ../plugins/logging/logformat.h
+
+SOURCES += main.cpp \
+    ../plugins/logging/logfile.cpp \
+    ../plugins/logging/logformat.cpp
+
+include(../plugins/uavobjects/uavobject_synthetics.pri)
+
+include(../rpath.pri)
+include(../libs/extensionsystem/extensionsystem.pri)
+include(../libs/utils/utils.pri)
+
+LIBS += -L$$GCS_PLUGIN_PATH/dRonin
+LIBS *= -l$$qtLibraryName(UAVObjects) -l$$qtLibraryName(UAVTalk) -l$$qtLibraryName(Core)
+
+linux-* {
+    QMAKE_LFLAGS += \'-Wl,-rpath,\$\$ORIGIN/../$$GCS_LIBRARY_BASENAME/$$GCS_PROJECT_BRANDING/plugins/dRonin\'
+}
+
+!macx {
+    target.path = /bin
+    INSTALLS += target
+}
@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ * @file       main.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup logreplay
+ * @{
+ * @brief Replays logs into the UAVObjects as fast as they can be read
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "logging/logfile.h"
+#include "uavobjects/uavobjectmanager.h"
+#include "uavobjects/uavobjectsinit.h"
+#include "uavtalk/uavtalk.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QTextStream>
+
+/**
+ * Replay one log, and print what was decoded from it.
+ * @return false if nothing could be replayed
+ */
+static bool replayLog(const QString &fileName, UAVObjectManager *objManager, QTextStream &out)
+{
+    LogFile log;
+    log.setInteractive(false);
+    log.setFileName(fileName);
+
+    if (!log.open(QIODevice::ReadOnly)) {
+        out << fileName << ": unable to open" << endl;
+        return false;
+    }
+
+    UAVTalk uavTalk(&log, objManager);
+    QMap<QString, quint32> updates;
+    QList<QMetaObject::Connection> counters;
+
+    for (const QVector<UAVObject *> &instances : objManager->getObjectsVector()) {
+        for (UAVObject *obj : instances)
+            counters << QObject::connect(obj, &UAVObject::objectUnpacked,
+                                         [&updates](UAVObject *o) { updates[o->getName()]++; });
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    quint32 records = log.replayAll();
+    qint64 ms = elapsed.elapsed();
+
+    for (const QMetaObject::Connection &counter : counters)
+        QObject::disconnect(counter);
+
+    UAVTalk::ComStats stats = uavTalk.getStats();
+    log.close();
+
+    out << fileName << ": " << records << " records, " << stats.rxObjects << " objects, "
+        << stats.rxErrors << " errors in " << ms << " ms" << endl;
+
+    for (auto it = updates.constBegin(); it != updates.constEnd(); ++it)
+        out << "    " << it.key() << " " << it.value() << endl;
+
+    return records > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("logreplay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay logs into the UAVObjects as fast as they can be "
+                                     "read, and print the objects decoded from each.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("logs", "Log files to replay.", "<log>...");
+    parser.process(app);
+
+    const QStringList logs = parser.positionalArguments();
+    if (logs.isEmpty())
+        parser.showHelp(1);
+
+    UAVObjectManager objManager;
+    UAVObjectsInitialize(&objManager);
+
+    QTextStream out(stdout);
+    int failures = 0;
+
+    for (const QString &fileName : logs) {
+        if (!replayLog(fileName, &objManager, out))
+            failures++;
+    }
+
+    // Non-zero if any log could not be replayed
+    return failures ? 1 : 0;
+}
+
+/**
+ * @}
+ */
@@ -82,6 +82,10 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
     if (obj3 != NULL)
         disconnect(obj3, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle3);
 
+    needle1Field = UAVObjectFieldHandle();
+    needle2Field = UAVObjectFieldHandle();
+    needle3Field = UAVObjectFieldHandle();
+
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
@@ -93,12 +97,9 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
             connect(obj1, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle1);
             if (nfield1.contains("-")) {
                 QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
-                field1 = fieldSubfield.at(0);
-                subfield1 = fieldSubfield.at(1);
-                haveSubField1 = true;
+                needle1Field = obj1->getFieldHandle(fieldSubfield.at(0), fieldSubfield.at(1));
             } else {
-                field1 = nfield1;
-                haveSubField1 = false;
+                needle1Field = obj1->getFieldHandle(nfield1);
             }
         } else {
             qDebug() << "Error: Object is unknown (" << object1 << ").";
@@ -113,12 +114,9 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
             connect(obj2, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle2);
             if (nfield2.contains("-")) {
                 QStringList fieldSubfield = nfield2.split("-", QString::SkipEmptyParts);
-                field2 = fieldSubfield.at(0);
-                subfield2 = fieldSubfield.at(1);
-                haveSubField2 = true;
+                needle2Field = obj2->getFieldHandle(fieldSubfield.at(0), fieldSubfield.at(1));
             } else {
-                field2 = nfield2;
-                haveSubField2 = false;
+                needle2Field = obj2->getFieldHandle(nfield2);
             }
         } else {
             qDebug() << "Error: Object is unknown (" << object2 << ").";
@@ -133,12 +131,9 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
             connect(obj3, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle3);
             if (nfield3.contains("-")) {
                 QStringList fieldSubfield = nfield3.split("-", QString::SkipEmptyParts);
-                field3 = fieldSubfield.at(0);
-                subfield3 = fieldSubfield.at(1);
-                haveSubField3 = true;
+                needle3Field = obj3->getFieldHandle(fieldSubfield.at(0), fieldSubfield.at(1));
             } else {
-                field3 = nfield3;
-                haveSubField3 = false;
+                needle3Field = obj3->getFieldHandle(nfield3);
             }
         } else {
             qDebug() << "Error: Object is unknown (" << object3 << ").";
@@ -151,16 +146,11 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
   */
 void DialGadgetWidget::updateNeedle1(UAVObject *object1)
 {
+    Q_UNUSED(object1);
+
     // Double check that the field exists:
-    double value;
-    UAVObjectField *field = object1->getField(field1);
-    if (field) {
-        if (haveSubField1) {
-            int indexOfSubField = field->getElementNames().indexOf(
-                QRegExp(subfield1, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else
-            value = field->getDouble();
+    if (needle1Field.isValid()) {
+        double value = needle1Field.getDouble();
         if (value != value) {
             qDebug() << "Dial widget: encountered NaN !!";
             return;
@@ -176,15 +166,10 @@ void DialGadgetWidget::updateNeedle1(UAVObject *object1)
   */
 void DialGadgetWidget::updateNeedle2(UAVObject *object2)
 {
-    double value;
-    UAVObjectField *field = object2->getField(field2);
-    if (field) {
-        if (haveSubField2) {
-            int indexOfSubField = field->getElementNames().indexOf(
-                QRegExp(subfield2, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else
-            value = field->getDouble();
+    Q_UNUSED(object2);
+
+    if (needle2Field.isValid()) {
+        double value = needle2Field.getDouble();
         if (value != value) {
             qDebug() << "Dial widget: encountered NaN !!";
             return;
@@ -200,15 +185,10 @@ void DialGadgetWidget::updateNeedle2(UAVObject *object2)
   */
 void DialGadgetWidget::updateNeedle3(UAVObject *object3)
 {
-    double value;
-    UAVObjectField *field = object3->getField(field3);
-    if (field) {
-        if (haveSubField3) {
-            int indexOfSubField = field->getElementNames().indexOf(
-                QRegExp(subfield3, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else
-            value = field->getDouble();
+    Q_UNUSED(object3);
+
+    if (needle3Field.isValid()) {
+        double value = needle3Field.getDouble();
         if (value != value) {
             qDebug() << "Dial widget: encountered NaN !!";
             return;
@@ -131,15 +131,9 @@ private:
     UAVDataObject *obj1;
     UAVDataObject *obj2;
     UAVDataObject *obj3;
-    QString field1;
-    QString subfield1;
-    bool haveSubField1;
-    QString field2;
-    QString subfield2;
-    bool haveSubField2;
-    QString field3;
-    QString subfield3;
-    bool haveSubField3;
+    UAVObjectFieldHandle needle1Field;
+    UAVObjectFieldHandle needle2Field;
+    UAVObjectFieldHandle needle3Field;
 
     // Rotation timer
     QTimer dialTimer;
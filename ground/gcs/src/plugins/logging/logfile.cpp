@@ -27,18 +27,134 @@
 #include "logfile.h"
 #include <QDebug>
 #include <QtGlobal>
-#include <QTextStream>
 #include <QMessageBox>
+#include <QDateTime>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
 
 #include <coreplugin/coreconstants.h>
+#include <extensionsystem/pluginmanager.h>
+
+// Sidecar index: magic and version, then (timestamp, offset) per record
+static const quint32 INDEX_MAGIC = 0x58495264; // "dRIX"
+static const quint32 INDEX_VERSION = 1;
+static const int INDEX_HEADER_SIZE = 2 * sizeof(quint32);
+static const int INDEX_ENTRY_SIZE = sizeof(quint32) + sizeof(qint64);
+
+/**
+ * Walk the records of the log, noting where each one starts. This runs
+ * when a log has no usable index, while playback from the start proceeds.
+ */
+void LogIndexBuilder::run()
+{
+    if (chunks.isEmpty()) {
+        scan(data, start, size, 0);
+        return;
+    }
+
+    QByteArray records;
+
+    for (const LogDataChunk &chunk : chunks) {
+        if (isInterruptionRequested() || !LogFormat::readPayload(data, chunk.chunk, &records))
+            return;
+
+        scan((const uchar *)records.constData(), 0, records.size(), chunk.recordOffset);
+    }
+}
+
+/**
+ * Note the records from pos to end, at offsets counted from base.
+ */
+void LogIndexBuilder::scan(const uchar *records, qint64 pos, qint64 end, qint64 base)
+{
+    quint32 timestamp;
+    qint64 dataSize;
+
+    while (!isInterruptionRequested()
+           && LogFile::parseRecord(records, end, &pos, &timestamp, &dataSize)) {
+        if (!entries.isEmpty() && timestamp < entries.last().timestamp) {
+            qDebug() << "Timestamp: " << entries.last().timestamp << " " << timestamp;
+            sequential = false;
+        }
+
+        entries.append({ timestamp, base + pos });
+        pos += LogFile::RECORD_HEADER_SIZE + dataSize;
+    }
+}
 
 LogFile::LogFile(QObject *parent)
     : QIODevice(parent)
-    , timestampBufferIdx(0)
+    , lastTimeStamp(0)
+    , lastPlayTime(0)
+    , lastPlayTimeOffset(0)
+    , playbackSpeed(1)
+    , fileData(nullptr)
+    , fileSize(0)
+    , logMapped(false)
+    , chunked(false)
+    , currentChunk(-1)
+    , logData(nullptr)
+    , logSize(0)
+    , blockOffset(0)
+    , blockStarted(0)
+    , recordCount(0)
+    , indexBuilder(nullptr)
+    , pendingSeek(-1)
+    , replayPos(0)
+    , firstTimestamp(0)
+    , replayTimestamp(0)
+    , interactive(true)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
 
+LogFile::~LogFile()
+{
+    stopIndexing();
+}
+
+/**
+ * Find the next record of a log.
+ * @param data the log contents
+ * @param size size of the log contents
+ * @param pos where to start looking; on success the start of the record
+ * @param timestamp the time the record was logged
+ * @param dataSize the size of the data in the record
+ * @return true if a whole record was found
+ */
+bool LogFile::parseRecord(const uchar *data, qint64 size, qint64 *pos, quint32 *timestamp,
+                          qint64 *dataSize)
+{
+    while (*pos + RECORD_HEADER_SIZE <= size) {
+        memcpy(timestamp, data + *pos, sizeof(*timestamp));
+        memcpy(dataSize, data + *pos + sizeof(*timestamp), sizeof(*dataSize));
+
+        // Check if dataSize sync bytes are correct.
+        // TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN
+        // THE STRING OF SIX 0x00
+        if ((*dataSize & 0xFFFFFFFFFFFF0000) != 0 || *dataSize < 1) {
+            qDebug() << "Wrong sync byte. At file location 0x" << QString("%1").arg(*pos, 0, 16)
+                     << "Got 0x" << QString("%1").arg(*dataSize & 0xFFFFFFFFFFFF0000, 0, 16)
+                     << ", but expected 0x"
+                        "00"
+                        ".";
+            (*pos)++;
+            continue;
+        }
+
+        return *pos + RECORD_HEADER_SIZE + *dataSize <= size;
+    }
+
+    return false;
+}
+
+QString LogFile::indexFileName(const QString &logName)
+{
+    return logName + ".idx";
+}
+
 /**
  * Opens the logfile QIODevice and the underlying logfile. In case
  * we want to save the logfile, we open in WriteOnly. In case we
@@ -85,18 +201,53 @@ bool LogFile::open(OpenMode mode)
                                .replace(" }\"", "")
                                .replace(",", "")
                                .replace("0x", "");
-        QTextStream out(&file);
-
-        out << "dRonin git hash:\n" << gitHash << "\n" << uavoHash << "\n##\n";
+        QMap<QString, QString> meta;
+        meta["githash"] = gitHash;
+        meta["uavohash"] = uavoHash;
+        meta["created"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+
+        LogFormat::writeFileHeader(&file);
+        LogFormat::writeChunk(&file, "META", LogFormat::encodeMeta(meta), false);
+
+        // Carry the object definitions, so the log can be decoded by any tool
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+        if (objManager)
+            LogFormat::writeChunk(&file, "UAVO", LogFormat::describeObjects(objManager), true);
+
+        chunked = true;
+        block.clear();
+        blockOffset = 0;
+        recordCount = 0;
+
+        // Index the records as they are written, so replay can seek at once
+        indexFile.setFileName(indexFileName(file.fileName()));
+        if (indexFile.open(QIODevice::WriteOnly)) {
+            indexFile.write((const char *)&INDEX_MAGIC, sizeof(INDEX_MAGIC));
+            indexFile.write((const char *)&INDEX_VERSION, sizeof(INDEX_VERSION));
+        } else {
+            qDebug() << "Unable to open " << indexFile.fileName() << " for the log index";
+        }
     } else if (mode == QIODevice::ReadOnly) {
-        file.readLine(); // Read first line of log file. This assumes that the logfile is of the new
-                         // format.
-        QString logGitHashString = file.readLine().trimmed(); // Read second line of log file. This
-                                                              // assumes that the logfile is of the
-                                                              // new format.
-        QString logUAVOHashString = file.readLine().trimmed(); // Read third line of log file. This
-                                                               // assumes that the logfile is of the
-                                                               // new format.
+        QString logGitHashString;
+        QString logUAVOHashString;
+
+        chunked = LogFormat::isChunked(&file);
+        if (chunked) {
+            if (!readChunkedLog(&logGitHashString, &logUAVOHashString)) {
+                file.close();
+                return false;
+            }
+        } else {
+            file.readLine(); // Read first line of log file. This assumes that the logfile is of
+                             // the new format.
+            logGitHashString = file.readLine().trimmed(); // Read second line of log file. This
+                                                          // assumes that the logfile is of the
+                                                          // new format.
+            logUAVOHashString = file.readLine().trimmed(); // Read third line of log file. This
+                                                           // assumes that the logfile is of the
+                                                           // new format.
+        }
         QString gitHash = QString::fromLatin1(Core::Constants::GCS_REVISION_STR);
         QString uavoHash =
             QString::fromLatin1(Core::Constants::UAVOSHA1_STR)
@@ -105,42 +256,44 @@ bool LogFile::open(OpenMode mode)
                 .replace(",", "")
                 .replace("0x", ""); // See comment above for necessity for string replacements
 
-        if (logUAVOHashString != uavoHash) {
-            QMessageBox msgBox;
-            msgBox.setText("Likely log file incompatibility.");
-            msgBox.setInformativeText(QString("The log file was made with branch %1, UAVO hash %2. "
-                                              "GCS will attempt to play the file.")
-                                          .arg(logGitHashString)
-                                          .arg(logUAVOHashString));
-            msgBox.exec();
+        if (logUAVOHashString != uavoHash && chunked) {
+            warn("Log file made with different objects.",
+                 QString("The log file was made with branch %1, UAVO hash %2. Objects that have "
+                         "changed since will not be replayed; the log carries their definitions "
+                         "for other tools to decode them.")
+                     .arg(logGitHashString)
+                     .arg(logUAVOHashString));
+        } else if (logUAVOHashString != uavoHash) {
+            warn("Likely log file incompatibility.",
+                 QString("The log file was made with branch %1, UAVO hash %2. "
+                         "GCS will attempt to play the file.")
+                     .arg(logGitHashString)
+                     .arg(logUAVOHashString));
         } else if (logGitHashString != gitHash) {
-            QMessageBox msgBox;
-            msgBox.setText("Possible log file incompatibility.");
-            msgBox.setInformativeText(
-                QString("The log file was made with branch %1. GCS will attempt to play the file.")
-                    .arg(logGitHashString));
-            msgBox.exec();
+            warn("Possible log file incompatibility.",
+                 QString("The log file was made with branch %1. GCS will attempt to play the file.")
+                     .arg(logGitHashString));
         }
 
-        QString tmpLine = file.readLine(); // Look for the header/body separation string.
-        int cnt = 0;
-        while (tmpLine != "##\n" && cnt < 10 && !file.atEnd()) {
-            tmpLine = file.readLine().trimmed();
-            cnt++;
-        }
+        // The records of chunked logs were found with their chunks
+        if (!chunked) {
+            QString tmpLine = file.readLine(); // Look for the header/body separation string.
+            int cnt = 0;
+            while (tmpLine != "##\n" && cnt < 10 && !file.atEnd()) {
+                tmpLine = file.readLine().trimmed();
+                cnt++;
+            }
+
+            // Check if we reached the end of the file before finding the separation string
+            if (cnt >= 10 || file.atEnd()) {
+                warn("Corrupted file.", "GCS cannot find the separation byte. GCS will attempt "
+                                        "to play the file."); //<--TODO: add hyperlink to webpage
+                                                              // with better description.
 
-        // Check if we reached the end of the file before finding the separation string
-        if (cnt >= 10 || file.atEnd()) {
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("GCS cannot find the separation byte. GCS will attempt to "
-                                      "play the file."); //<--TODO: add hyperlink to webpage with
-                                                         //better description.
-            msgBox.exec();
-
-            // Since we could not find the file separator, we need to return to the beginning of the
-            // file
-            file.seek(0);
+                // Since we could not find the file separator, we need to return to the beginning
+                // of the file
+                file.seek(0);
+            }
         }
 
     } else {
@@ -161,6 +314,37 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    stopIndexing();
+    index.clear();
+    pendingSeek = -1;
+    emit seekableChanged(false);
+
+    if (logMapped)
+        file.unmap(const_cast<uchar *>(fileData));
+    logMapped = false;
+    fileData = nullptr;
+    fileSize = 0;
+    fileCopy.clear();
+
+    chunks.clear();
+    currentChunk = -1;
+    chunkData.clear();
+    logData = nullptr;
+    logSize = 0;
+
+    // Finish a log being written with what is left, and its end marker
+    if (file.isWritable() && chunked) {
+        flushBlock();
+
+        uchar end[2 * sizeof(quint32)];
+        qToLittleEndian<quint32>(recordCount, end);
+        qToLittleEndian<quint32>(lastTimeStamp, end + sizeof(quint32));
+        LogFormat::writeChunk(&file, "END ", QByteArray((const char *)end, sizeof(end)), false);
+    }
+    chunked = false;
+
+    indexFile.close();
     file.close();
     QIODevice::close();
 }
@@ -172,16 +356,201 @@ qint64 LogFile::writeData(const char *data, qint64 dataSize)
 
     quint32 timeStamp = myTime.elapsed();
 
-    file.write((char *)&timeStamp, sizeof(timeStamp));
-    file.write((char *)&dataSize, sizeof(dataSize));
+    if (indexFile.isOpen()) {
+        qint64 offset = blockOffset + block.size();
+
+        indexFile.write((const char *)&timeStamp, sizeof(timeStamp));
+        indexFile.write((const char *)&offset, sizeof(offset));
+    }
+
+    if (block.isEmpty())
+        blockStarted = timeStamp;
+
+    block.append((const char *)&timeStamp, sizeof(timeStamp));
+    block.append((const char *)&dataSize, sizeof(dataSize));
+    block.append(data, dataSize);
+    recordCount++;
+    lastTimeStamp = timeStamp;
+
+    // A crash loses at most the block being gathered, so keep it short
+    if (block.size() >= LogFormat::BLOCK_SIZE || timeStamp - blockStarted >= 1000)
+        flushBlock();
 
-    qint64 written = file.write(data, dataSize);
-    if (written != -1)
-        emit bytesWritten(written);
+    emit bytesWritten(dataSize);
 
     return dataSize;
 }
 
+/**
+ * Write out the records gathered so far as a chunk.
+ */
+void LogFile::flushBlock()
+{
+    if (block.isEmpty())
+        return;
+
+    if (!LogFormat::writeChunk(&file, "DATA", block, true))
+        qDebug() << "Unable to write log block to " << file.fileName();
+
+    file.flush();
+    indexFile.flush();
+
+    blockOffset += block.size();
+    block.clear();
+}
+
+/**
+ * Read the header of a chunked log and find its chunks. Only the chunk
+ * headers are read here; the records are unpacked as replay reaches them.
+ * @param gitHash the git hash the log was made with
+ * @param uavoHash the UAVO hash the log was made with
+ * @return false if the log cannot be read
+ */
+bool LogFile::readChunkedLog(QString *gitHash, QString *uavoHash)
+{
+    mapLog();
+
+    quint32 version = 0;
+
+    if (fileSize >= LogFormat::FILE_HEADER_SIZE)
+        version = qFromLittleEndian<quint32>(fileData + 8);
+
+    if (version < 2 || version > LogFormat::VERSION) {
+        warn("Unsupported log file.",
+             QString("The log file is format version %1, which this GCS cannot read.")
+                 .arg(version));
+        return false;
+    }
+
+    qint64 pos = LogFormat::FILE_HEADER_SIZE;
+    qint64 recordOffset = 0;
+    LogFormat::Chunk chunk;
+    bool ended = false;
+
+    chunks.clear();
+
+    while (LogFormat::nextChunk(fileData, fileSize, &pos, &chunk)) {
+        if (chunk.type == "DATA") {
+            chunks.append({ chunk, recordOffset });
+            recordOffset += chunk.rawSize;
+        } else if (chunk.type == "META") {
+            QByteArray payload;
+            if (LogFormat::readPayload(fileData, chunk, &payload)) {
+                QMap<QString, QString> meta = LogFormat::decodeMeta(payload);
+                *gitHash = meta.value("githash");
+                *uavoHash = meta.value("uavohash");
+            }
+        } else if (chunk.type == "END ") {
+            ended = true;
+        }
+    }
+
+    if (!ended)
+        qDebug() << "Log " << file.fileName() << " was not closed, replaying the "
+                 << recordOffset << " bytes written before it was cut short";
+
+    return true;
+}
+
+/**
+ * Map the whole log into memory, or failing that read it.
+ */
+void LogFile::mapLog()
+{
+    if (fileData)
+        return;
+
+    fileSize = file.size();
+    fileData = file.map(0, fileSize);
+    logMapped = fileData != nullptr;
+
+    if (!logMapped) {
+        qDebug() << "Unable to map " << file.fileName() << ", reading it instead";
+
+        qint64 pos = file.pos();
+        file.seek(0);
+        fileCopy = file.readAll();
+        file.seek(pos);
+
+        fileData = (const uchar *)fileCopy.constData();
+        fileSize = fileCopy.size();
+    }
+}
+
+/**
+ * Unpack a chunk of a chunked log to replay records from.
+ * @param i which DATA chunk
+ * @return false if the chunk is damaged
+ */
+bool LogFile::loadChunk(int i)
+{
+    if (i == currentChunk)
+        return true;
+
+    if (!LogFormat::readPayload(fileData, chunks[i].chunk, &chunkData))
+        return false;
+
+    currentChunk = i;
+    logData = (const uchar *)chunkData.constData();
+    logSize = chunkData.size();
+
+    return true;
+}
+
+/**
+ * Move replay to an offset into the records, as the index has them.
+ * @param offset where a record starts
+ * @return false if the offset is not in the log
+ */
+bool LogFile::seekRecords(qint64 offset)
+{
+    if (!chunked) {
+        replayPos = offset;
+        return offset <= logSize;
+    }
+
+    auto it = std::upper_bound(
+        chunks.constBegin(), chunks.constEnd(), offset,
+        [](qint64 off, const LogDataChunk &chunk) { return off < chunk.recordOffset; });
+    if (it == chunks.constBegin())
+        return false;
+
+    int i = it - chunks.constBegin() - 1;
+    if (!loadChunk(i))
+        return false;
+
+    replayPos = offset - chunks[i].recordOffset;
+    return true;
+}
+
+/**
+ * Where replay is in the records, as the index counts offsets.
+ */
+qint64 LogFile::recordsOffset() const
+{
+    if (chunked && currentChunk >= 0)
+        return chunks[currentChunk].recordOffset + replayPos;
+
+    return replayPos;
+}
+
+/**
+ * Find the next record from replayPos on, going on to the next chunk of a
+ * chunked log when this one is done. The record is at logData + replayPos.
+ * @return false at the end of the log
+ */
+bool LogFile::nextRecord(quint32 *timestamp, qint64 *dataSize)
+{
+    while (!parseRecord(logData, logSize, &replayPos, timestamp, dataSize)) {
+        if (!chunked || currentChunk + 1 >= chunks.size() || !loadChunk(currentChunk + 1))
+            return false;
+
+        replayPos = 0;
+    }
+
+    return true;
+}
+
 qint64 LogFile::readData(char *data, qint64 maxSize)
 {
     QMutexLocker locker(&mutex);
@@ -198,139 +567,286 @@ qint64 LogFile::bytesAvailable() const
 
 void LogFile::timerFired()
 {
-    qint64 dataSize;
-
-    if (file.bytesAvailable() > 4) {
+    int time = myTime.elapsed();
 
-        int time;
-        time = myTime.elapsed();
+    lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
 
-        // Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset) * playbackSpeed)
-                > (lastTimeStamp - firstTimestamp))) {
-            lastPlayTime += ((time - lastPlayTimeOffset) * playbackSpeed);
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+    // Send every record that is due; replayPos is the next one, logged at lastTimeStamp
+    while (lastPlayTime >= (qint64)lastTimeStamp - firstTimestamp) {
+        quint32 timestamp;
+        qint64 dataSize;
 
-            file.seek(lastTimeStampPos + sizeof(lastTimeStamp));
+        if (!nextRecord(&timestamp, &dataSize)) {
+            stopReplay();
+            return;
+        }
 
-            file.read((char *)&dataSize, sizeof(dataSize));
+        replayPos += RECORD_HEADER_SIZE;
+        replayTimestamp = timestamp;
 
-            if (dataSize < 1 || dataSize > (1024 * 1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if (file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+        mutex.lock();
+        dataBuffer.append((const char *)logData + replayPos, dataSize);
+        mutex.unlock();
+        emit readyRead();
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+        replayPos += dataSize;
 
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+        if (!nextRecord(&lastTimeStamp, &dataSize)) {
+            stopReplay();
+            return;
+        }
+    }
+}
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+/**
+ * Get the log ready to replay from its first record.
+ * @return false if the log has no records
+ */
+bool LogFile::prepareReplay()
+{
+    dataBuffer.clear();
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
-        }
+    // Records are read straight out of the mapped file, or for chunked logs
+    // out of its first chunk
+    bool started;
+    if (chunked) {
+        started = !chunks.isEmpty() && seekRecords(0);
     } else {
-        stopReplay();
+        qint64 dataStart = file.pos();
+        mapLog();
+        logData = fileData;
+        logSize = fileSize;
+        started = seekRecords(dataStart);
     }
+
+    // Playing from the start only needs the first record
+    qint64 dataSize;
+    if (!started || !nextRecord(&lastTimeStamp, &dataSize)) {
+        warn("Empty logfile.", "No log data can be found.");
+        return false;
+    }
+    firstTimestamp = lastTimeStamp;
+
+    return true;
 }
 
 bool LogFile::startReplay()
 {
-    dataBuffer.clear();
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
     playbackSpeed = 1;
 
-    // Read all log timestamps into array
-    timestampBuffer.clear(); // Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
+    if (!prepareReplay()) {
+        stopReplay();
+        return false;
+    }
 
-    while (!file.atEnd()) {
-        qint64 dataSize;
+    // Seeking needs the index: use the one written with the log, or build it
+    if (loadIndex()) {
+        emit seekableChanged(true);
+    } else {
+        if (chunked)
+            indexBuilder = new LogIndexBuilder(fileData, chunks, this);
+        else
+            indexBuilder = new LogIndexBuilder(fileData, replayPos, fileSize, this);
+        connect(indexBuilder, SIGNAL(finished()), this, SLOT(indexBuilt()));
+        indexBuilder->start(QThread::LowPriority);
+    }
 
-        // Get time stamp position
-        timestampPos.append(file.pos());
+    timer.setInterval(10);
+    timer.start();
+    emit replayStarted();
+    return true;
+}
 
-        // Read timestamp and logfile packet size
-        file.read((char *)&lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *)&dataSize, sizeof(dataSize));
+/**
+ * Replay the whole log as fast as it can be read, instead of in step with
+ * the clock. Records are handed on in order through readyRead(), one at a
+ * time so each is stamped with its own time; a reader connected directly
+ * (such as UAVTalk) has decoded the whole log when this returns.
+ * @return the number of records replayed
+ */
+quint32 LogFile::replayAll()
+{
+    if (!prepareReplay())
+        return 0;
 
-        // Check if dataSize sync bytes are correct.
-        // TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN
-        // THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
-            qDebug() << "Wrong sync byte. At file location 0x"
-                     << QString("%1").arg(file.pos(), 0, 16) << "Got 0x"
-                     << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000, 0, 16)
-                     << ", but expected 0x"
-                        "00"
-                        ".";
-            file.seek(timestampPos.last() + 1);
-            timestampPos.pop_back();
-            continue;
-        }
+    quint32 records = 0;
+    quint32 timestamp;
+    qint64 dataSize;
 
-        // Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()) {
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected "
-                                      "behavior"); //<--TODO: add hyperlink to webpage with better
-                                                   //description.
-            msgBox.exec();
+    while (nextRecord(&timestamp, &dataSize)) {
+        replayPos += RECORD_HEADER_SIZE;
+        replayTimestamp = timestamp;
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
-        }
+        mutex.lock();
+        dataBuffer.append((const char *)logData + replayPos, dataSize);
+        mutex.unlock();
+        emit readyRead();
 
-        timestampBuffer.append(lastTimeStamp);
+        replayPos += dataSize;
+        records++;
+    }
 
-        file.seek(timestampPos.last() + sizeof(lastTimeStamp) + sizeof(dataSize) + dataSize);
+    return records;
+}
+
+/**
+ * Tell the user about a problem with the log: in a message box, or on the
+ * console when replaying without a user.
+ */
+void LogFile::warn(const QString &text, const QString &info)
+{
+    if (!interactive) {
+        qWarning() << file.fileName() << ": " << text << info;
+        return;
     }
 
-    // Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0) {
-        QMessageBox msgBox;
-        msgBox.setText("Empty logfile.");
-        msgBox.setInformativeText("No log data can be found.");
-        msgBox.exec();
+    QMessageBox msgBox;
+    msgBox.setText(text);
+    msgBox.setInformativeText(info);
+    msgBox.exec();
+}
 
-        stopReplay();
+/**
+ * Load the sidecar index of the log being replayed, if it matches the log.
+ * @return true if the index was loaded
+ */
+bool LogFile::loadIndex()
+{
+    QFile sidecar(indexFileName(file.fileName()));
+    if (!sidecar.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray raw = sidecar.readAll();
+    quint32 magic, version;
+
+    if (raw.size() < INDEX_HEADER_SIZE + INDEX_ENTRY_SIZE)
+        return false;
+
+    memcpy(&magic, raw.constData(), sizeof(magic));
+    memcpy(&version, raw.constData() + sizeof(magic), sizeof(version));
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION)
         return false;
+
+    // A partly written entry at the end (the GCS stopped mid-write) is dropped
+    QVector<LogIndexEntry> loaded((raw.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE);
+    const char *entry = raw.constData() + INDEX_HEADER_SIZE;
+    bool sequential = true;
+
+    for (int i = 0; i < loaded.size(); i++, entry += INDEX_ENTRY_SIZE) {
+        memcpy(&loaded[i].timestamp, entry, sizeof(loaded[i].timestamp));
+        memcpy(&loaded[i].offset, entry + sizeof(loaded[i].timestamp), sizeof(loaded[i].offset));
+
+        if (i > 0 && loaded[i].timestamp < loaded[i - 1].timestamp)
+            sequential = false;
     }
 
-    // Reset to log beginning.
-    file.seek(logFileStartIdx + sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    // It must start at the first record, and its last record must end the log
+    const LogIndexEntry &last = loaded.last();
+    qint64 start = recordsOffset();
+    bool matches = loaded.first().offset == start && last.offset >= start
+        && seekRecords(last.offset);
+
+    if (matches) {
+        qint64 pos = replayPos;
+        quint32 timestamp;
+        qint64 dataSize;
+
+        matches = parseRecord(logData, logSize, &pos, &timestamp, &dataSize)
+            && pos == replayPos && timestamp == last.timestamp
+            && pos + RECORD_HEADER_SIZE + dataSize == logSize
+            && (!chunked || currentChunk == chunks.size() - 1);
+    }
+
+    // Back to the first record, which is where replay starts
+    seekRecords(start);
+
+    if (!matches) {
+        qDebug() << "Log index " << sidecar.fileName() << " does not match the log, rebuilding it";
+        return false;
+    }
+
+    index = loaded;
+
+    if (!sequential)
+        warn("Corrupted file.", "Timestamps are not sequential. Playback may have unexpected "
+                                "behavior"); //<--TODO: add hyperlink to webpage with better
+                                             // description.
 
-    timer.setInterval(10);
-    timer.start();
-    emit replayStarted();
     return true;
 }
 
+/**
+ * Save the index of the log being replayed next to it, for next time.
+ */
+void LogFile::saveIndex()
+{
+    QFile sidecar(indexFileName(file.fileName()));
+    if (!sidecar.open(QIODevice::WriteOnly)) {
+        qDebug() << "Unable to save the log index to " << sidecar.fileName();
+        return;
+    }
+
+    QByteArray raw;
+    raw.reserve(INDEX_HEADER_SIZE + index.size() * INDEX_ENTRY_SIZE);
+    raw.append((const char *)&INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    raw.append((const char *)&INDEX_VERSION, sizeof(INDEX_VERSION));
+
+    for (const LogIndexEntry &entry : index) {
+        raw.append((const char *)&entry.timestamp, sizeof(entry.timestamp));
+        raw.append((const char *)&entry.offset, sizeof(entry.offset));
+    }
+
+    sidecar.write(raw);
+}
+
+/**
+ * Take the index from the background builder once it is done, and go to
+ * the replay time asked for meanwhile, if any.
+ */
+void LogFile::indexBuilt()
+{
+    // Also reached from a stale signal after stopIndexing() dropped it
+    if (!indexBuilder || !indexBuilder->isFinished())
+        return;
+
+    index = indexBuilder->entries;
+    bool sequential = indexBuilder->isSequential();
+
+    indexBuilder->deleteLater();
+    indexBuilder = nullptr;
+
+    if (!index.isEmpty())
+        saveIndex();
+
+    if (!sequential)
+        warn("Corrupted file.", "Timestamps are not sequential. Playback may have unexpected "
+                                "behavior"); //<--TODO: add hyperlink to webpage with better
+                                             // description.
+
+    emit seekableChanged(isSeekable());
+
+    if (pendingSeek >= 0) {
+        double val = pendingSeek;
+        pendingSeek = -1;
+        setReplayTime(val);
+    }
+}
+
+void LogFile::stopIndexing()
+{
+    if (!indexBuilder)
+        return;
+
+    indexBuilder->requestInterruption();
+    indexBuilder->wait();
+    delete indexBuilder;
+    indexBuilder = nullptr;
+}
+
 bool LogFile::stopReplay()
 {
     close();
@@ -350,21 +866,35 @@ void LogFile::resumeReplay()
 }
 
 /**
- * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @brief LogFile::setReplayTime, sets the playback time. While the index is
+ * still being built, only the latest time asked for is kept, and gone to
+ * once it is done; waiting for it here would hold up the user interface.
+ * @param val, the time in seconds from the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx = 0;
-    while (timestampBuffer[tmpIdx++] <= val * 1000 && tmpIdx <= timestampBufferIdx) {
+    if (indexBuilder) {
+        pendingSeek = qMax(val, 0.0);
+        return;
     }
 
-    lastTimeStampPos = timestampPos[tmpIdx];
-    lastTimeStamp = timestampBuffer[tmpIdx];
-    timestampBufferIdx = tmpIdx;
+    if (!logData || index.isEmpty())
+        return;
+
+    quint32 target = firstTimestamp + qMax(val, 0.0) * 1000;
+
+    auto it = std::lower_bound(
+        index.constBegin(), index.constEnd(), target,
+        [](const LogIndexEntry &entry, quint32 time) { return entry.timestamp < time; });
+    if (it == index.constEnd())
+        it--;
+
+    if (!seekRecords(it->offset))
+        return;
+    lastTimeStamp = it->timestamp;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime = lastTimeStamp;
+    lastPlayTime = (qint64)lastTimeStamp - firstTimestamp;
 
     qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val * 1000;
 }
@@ -33,14 +33,90 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QFile>
+#include <QThread>
+#include <QVector>
 #include "uavobjects/uavobjectmanager.h"
+#include "uavtalk/uavtalk.h"
+#include "logformat.h"
 #include <math.h>
 
-class LogFile : public QIODevice
+/**
+ * One record of a log: the time it was written and where it starts.
+ */
+struct LogIndexEntry
+{
+    quint32 timestamp;
+    qint64 offset;
+};
+
+/**
+ * A DATA chunk of a chunked log, and where its records start among the
+ * records of the whole log (as if every chunk were unpacked in turn).
+ */
+struct LogDataChunk
+{
+    LogFormat::Chunk chunk;
+    qint64 recordOffset;
+};
+
+/**
+ * Scans a mapped log for its records in the background, for logs without
+ * a usable sidecar index. The chunks of a chunked log are unpacked one at a
+ * time.
+ */
+class LogIndexBuilder : public QThread
 {
     Q_OBJECT
 public:
+    LogIndexBuilder(const uchar *data, qint64 start, qint64 size, QObject *parent = nullptr)
+        : QThread(parent)
+        , data(data)
+        , start(start)
+        , size(size)
+        , sequential(true)
+    {
+    }
+
+    LogIndexBuilder(const uchar *data, const QVector<LogDataChunk> &chunks,
+                    QObject *parent = nullptr)
+        : QThread(parent)
+        , data(data)
+        , start(0)
+        , size(0)
+        , chunks(chunks)
+        , sequential(true)
+    {
+    }
+
+    QVector<LogIndexEntry> entries;
+    bool isSequential() const { return sequential; }
+
+protected:
+    void run();
+
+private:
+    void scan(const uchar *records, qint64 pos, qint64 end, qint64 base);
+
+    const uchar *data;
+    qint64 start;
+    qint64 size;
+    QVector<LogDataChunk> chunks;
+    bool sequential;
+};
+
+class LogFile : public QIODevice, public UAVTalkTimeSource
+{
+    Q_OBJECT
+public:
+    /* Each record is a 32 bit timestamp and a 64 bit length, then data */
+    static const qint64 RECORD_HEADER_SIZE = sizeof(quint32) + sizeof(qint64);
+
+    static bool parseRecord(const uchar *data, qint64 size, qint64 *pos, quint32 *timestamp,
+                            qint64 *dataSize);
+
     explicit LogFile(QObject *parent = nullptr);
+    ~LogFile();
     qint64 bytesAvailable() const;
     qint64 bytesToWrite() const { return file.bytesToWrite(); }
     bool open(OpenMode mode);
@@ -49,8 +125,27 @@ public:
     qint64 writeData(const char *data, qint64 dataSize);
     qint64 readData(char *data, qint64 maxlen);
 
+    /**
+     * When the records being replayed were logged, so objects are stamped
+     * with the log's time at any replay speed
+     */
+    qint64 currentTimestamp() const { return replayTimestamp; }
+
     bool startReplay();
     bool stopReplay();
+    quint32 replayAll();
+
+    /**
+     * Set whether problems with the log are shown to the user, or only
+     * logged (for replaying without a user at hand)
+     */
+    void setInteractive(bool interactive) { this->interactive = interactive; }
+
+    /**
+     * Whether the replay can be moved with setReplayTime(); not until the
+     * index of the log is loaded or built
+     */
+    bool isSeekable() const { return !index.isEmpty() && !indexBuilder; }
 
 public slots:
     void setReplaySpeed(double val)
@@ -64,11 +159,13 @@ public slots:
 
 protected slots:
     void timerFired();
+    void indexBuilt();
 
 signals:
     void readReady();
     void replayStarted();
     void replayFinished();
+    void seekableChanged(bool seekable);
 
 protected:
     QByteArray dataBuffer;
@@ -76,18 +173,68 @@ protected:
     QTime myTime;
     QFile file;
     quint32 lastTimeStamp;
-    quint32 lastPlayTime;
+    double lastPlayTime;
     QMutex mutex;
 
     int lastPlayTimeOffset;
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    static QString indexFileName(const QString &logName);
+    bool prepareReplay();
+    void warn(const QString &text, const QString &info);
+    bool readChunkedLog(QString *gitHash, QString *uavoHash);
+    void mapLog();
+    bool loadChunk(int i);
+    bool seekRecords(qint64 offset);
+    qint64 recordsOffset() const;
+    bool nextRecord(quint32 *timestamp, qint64 *dataSize);
+    void flushBlock();
+    bool loadIndex();
+    void saveIndex();
+    void stopIndexing();
+
+    // The log being replayed, mapped (or failing that, read) into memory
+    const uchar *fileData;
+    qint64 fileSize;
+    QByteArray fileCopy;
+    bool logMapped;
+    bool chunked;
+
+    // DATA chunks of a chunked log, found from their headers when it is
+    // opened; each is unpacked into chunkData once replay reaches it
+    QVector<LogDataChunk> chunks;
+    int currentChunk;
+    QByteArray chunkData;
+
+    // Records being replayed from: the whole mapped log, or for chunked logs
+    // the chunk unpacked last
+    const uchar *logData;
+    qint64 logSize;
+
+    // Records not yet written out as a chunk, and where they will start in
+    // the unpacked records
+    QByteArray block;
+    qint64 blockOffset;
+    quint32 blockStarted;
+    quint32 recordCount;
+
+    // Timestamp to offset index of the log, and its sidecar file; offsets of
+    // chunked logs are into the unpacked records, and lead to a chunk
+    // through the recordOffset of each
+    QVector<LogIndexEntry> index;
+    QFile indexFile;
+    LogIndexBuilder *indexBuilder;
+
+    // Replay time (in seconds) asked for while the index was being built,
+    // to go to once it is done; negative if none
+    double pendingSeek;
+
+    qint64 replayPos;
     quint32 firstTimestamp;
+    quint32 replayTimestamp;
+
+    bool interactive;
 };
 
 #endif // LOGFILE_H
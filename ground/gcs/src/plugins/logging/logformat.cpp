@@ -0,0 +1,320 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logformat.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @brief      The chunked dRonin log format
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "logformat.h"
+
+#include <array>
+
+#include <QDebug>
+#include <QtEndian>
+#include <QXmlStreamWriter>
+
+#include "uavobjects/uavobjectmanager.h"
+#include "uavobjects/uavdataobject.h"
+
+const char LogFormat::MAGIC[8] = { 'd', 'R', 'o', 'n', 'L', 'O', 'G', '\n' };
+
+/**
+ * Check whether a log is in the chunked format, without consuming anything.
+ * @param dev the log, positioned at its start
+ * @return true if the log starts with the chunked log file header
+ */
+bool LogFormat::isChunked(QIODevice *dev)
+{
+    return dev->peek(sizeof(MAGIC)) == QByteArray(MAGIC, sizeof(MAGIC));
+}
+
+void LogFormat::writeFileHeader(QIODevice *dev)
+{
+    uchar header[FILE_HEADER_SIZE];
+
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    qToLittleEndian<quint32>(VERSION, header + 8);
+    qToLittleEndian<quint32>(0, header + 12);
+
+    dev->write((const char *)header, sizeof(header));
+}
+
+/**
+ * Append one chunk to a log.
+ * @param dev the log
+ * @param type the four character chunk type
+ * @param payload the chunk contents
+ * @param compress whether to try compressing the payload
+ * @return true if the whole chunk was written
+ */
+bool LogFormat::writeChunk(QIODevice *dev, const char *type, const QByteArray &payload,
+                           bool compress)
+{
+    QByteArray stored = payload;
+    quint32 flags = 0;
+
+    if (compress) {
+        // qCompress prefixes the zlib stream with the big endian raw size;
+        // the chunk header already has that, so store the bare stream
+        QByteArray packed = qCompress(payload).mid(4);
+
+        if (packed.size() < payload.size()) {
+            stored = packed;
+            flags |= COMPRESSED;
+        }
+    }
+
+    QByteArray chunk;
+    chunk.reserve(CHUNK_HEADER_SIZE + stored.size() + CHUNK_TRAILER_SIZE);
+
+    uchar word[4];
+    chunk.append(type, 4);
+    qToLittleEndian<quint32>(flags, word);
+    chunk.append((const char *)word, sizeof(word));
+    qToLittleEndian<quint32>(stored.size(), word);
+    chunk.append((const char *)word, sizeof(word));
+    qToLittleEndian<quint32>(payload.size(), word);
+    chunk.append((const char *)word, sizeof(word));
+    chunk.append(stored);
+
+    qToLittleEndian<quint32>(stored.size(), word);
+    chunk.append((const char *)word, sizeof(word));
+    qToLittleEndian<quint32>(crc32(0, chunk.constData(), chunk.size()), word);
+    chunk.append((const char *)word, sizeof(word));
+
+    return dev->write(chunk) == chunk.size();
+}
+
+/**
+ * Find the next chunk of a log, from its header alone. The payload is not
+ * read, so this is cheap even for a large log; readPayload() checks it.
+ * @param log the contents of the log
+ * @param size the size of the log
+ * @param pos where the chunk starts; advanced past it on success
+ * @param chunk where the chunk is
+ * @return false at the end of the log, or at a chunk that is incomplete
+ */
+bool LogFormat::nextChunk(const uchar *log, qint64 size, qint64 *pos, Chunk *chunk)
+{
+    const uchar *data = log + *pos;
+    qint64 left = size - *pos;
+
+    if (left < CHUNK_HEADER_SIZE + CHUNK_TRAILER_SIZE)
+        return false;
+
+    quint32 storedSize = qFromLittleEndian<quint32>(data + 8);
+
+    // The trailer repeats the length, which a chunk cut short won't have
+    if (storedSize > left - CHUNK_HEADER_SIZE - CHUNK_TRAILER_SIZE
+        || qFromLittleEndian<quint32>(data + CHUNK_HEADER_SIZE + storedSize) != storedSize)
+        return false;
+
+    chunk->type = QByteArray((const char *)data, 4);
+    chunk->flags = qFromLittleEndian<quint32>(data + 4);
+    chunk->offset = *pos;
+    chunk->storedSize = storedSize;
+    chunk->rawSize = qFromLittleEndian<quint32>(data + 12);
+
+    *pos += CHUNK_HEADER_SIZE + storedSize + CHUNK_TRAILER_SIZE;
+    return true;
+}
+
+/**
+ * Check the payload of a chunk and unpack it.
+ * @param log the contents of the log
+ * @param chunk the chunk, as found by nextChunk()
+ * @param payload the (uncompressed) payload; left alone on failure
+ * @return false if the chunk is damaged
+ */
+bool LogFormat::readPayload(const uchar *log, const Chunk &chunk, QByteArray *payload)
+{
+    const uchar *data = log + chunk.offset;
+    const uchar *trailer = data + CHUNK_HEADER_SIZE + chunk.storedSize;
+
+    if (qFromLittleEndian<quint32>(trailer + 4)
+        != crc32(0, (const char *)data, CHUNK_HEADER_SIZE + chunk.storedSize)) {
+        qDebug() << "Damaged log chunk at " << chunk.offset;
+        return false;
+    }
+
+    if (!(chunk.flags & COMPRESSED)) {
+        *payload = QByteArray((const char *)data + CHUNK_HEADER_SIZE, chunk.storedSize);
+        return true;
+    }
+
+    QByteArray packed(4, 0);
+    qToBigEndian<quint32>(chunk.rawSize, (uchar *)packed.data());
+    packed.append((const char *)data + CHUNK_HEADER_SIZE, chunk.storedSize);
+
+    QByteArray unpacked = qUncompress(packed);
+    if ((quint32)unpacked.size() != chunk.rawSize)
+        return false;
+
+    *payload = unpacked;
+    return true;
+}
+
+QByteArray LogFormat::encodeMeta(const QMap<QString, QString> &meta)
+{
+    QByteArray payload;
+
+    for (auto it = meta.constBegin(); it != meta.constEnd(); ++it)
+        payload += it.key().toUtf8() + "=" + it.value().toUtf8() + "\n";
+
+    return payload;
+}
+
+QMap<QString, QString> LogFormat::decodeMeta(const QByteArray &payload)
+{
+    QMap<QString, QString> meta;
+
+    for (const QString &line : QString::fromUtf8(payload).split('\n', QString::SkipEmptyParts)) {
+        int sep = line.indexOf('=');
+
+        if (sep > 0)
+            meta.insert(line.left(sep), line.mid(sep + 1));
+    }
+
+    return meta;
+}
+
+/**
+ * Describe the layout of every data object, in the same XML form as the
+ * object definitions (plus the object ID, and the value of each enum
+ * option), so a log can be decoded by tools that have no definitions of
+ * their own for it.
+ * @param objManager the objects to describe
+ * @return the descriptions, as a <uavobjects> document
+ */
+QByteArray LogFormat::describeObjects(UAVObjectManager *objManager)
+{
+    QByteArray xml;
+    QXmlStreamWriter out(&xml);
+
+    out.writeStartDocument();
+    out.writeStartElement("uavobjects");
+
+    for (const QVector<UAVObject *> &instances : objManager->getObjectsVector()) {
+        UAVDataObject *obj = instances.isEmpty() ? nullptr
+                                                 : qobject_cast<UAVDataObject *>(instances.first());
+        if (!obj)
+            continue;
+
+        UAVObject::Metadata meta = obj->getDefaultMetadata();
+
+        out.writeStartElement("object");
+        out.writeAttribute("name", obj->getName());
+        out.writeAttribute("id", QString("0x%1").arg(obj->getObjID(), 8, 16, QChar('0')));
+        out.writeAttribute("singleinstance", obj->isSingleInstance() ? "true" : "false");
+        out.writeAttribute("settings", obj->isSettings() ? "true" : "false");
+        out.writeTextElement("description", obj->getDescription());
+
+        out.writeEmptyElement("access");
+        out.writeAttribute("gcs", UAVObject::GetGcsAccess(meta) == UAVObject::ACCESS_READONLY
+                               ? "readonly"
+                               : "readwrite");
+        out.writeAttribute("flight",
+                           UAVObject::GetFlightAccess(meta) == UAVObject::ACCESS_READONLY
+                               ? "readonly"
+                               : "readwrite");
+
+        // Update rates don't matter for decoding a log; these keep the
+        // description a valid object definition
+        for (const char *tag : { "telemetrygcs", "telemetryflight", "logging" }) {
+            out.writeEmptyElement(tag);
+            out.writeAttribute("updatemode", "manual");
+            out.writeAttribute("period", "0");
+        }
+
+        // Fields are described in the order they are packed
+        for (UAVObjectField *field : obj->getFields()) {
+            QString type = field->getTypeAsString();
+            if (field->getType() == UAVObjectField::FLOAT32)
+                type = "float";
+
+            out.writeStartElement("field");
+            out.writeAttribute("name", field->getName());
+            out.writeAttribute("units", field->getUnits());
+            out.writeAttribute("type", type);
+
+            QStringList names = field->getElementNames();
+            if (names.isEmpty() || names.first() == "0") {
+                out.writeAttribute("elements", QString::number(field->getNumElements()));
+            } else {
+                out.writeStartElement("elementnames");
+                for (const QString &name : names)
+                    out.writeTextElement("elementname", name);
+                out.writeEndElement();
+            }
+
+            if (field->getType() == UAVObjectField::ENUM) {
+                QStringList options = field->getOptions();
+                QList<int> values = field->getOptionIndices();
+
+                out.writeStartElement("options");
+                for (int i = 0; i < options.size(); i++) {
+                    out.writeStartElement("option");
+                    if (i < values.size())
+                        out.writeAttribute("value", QString::number(values[i]));
+                    out.writeCharacters(options[i]);
+                    out.writeEndElement();
+                }
+                out.writeEndElement();
+            }
+
+            out.writeEndElement();
+        }
+
+        out.writeEndElement();
+    }
+
+    out.writeEndElement();
+    out.writeEndDocument();
+
+    return xml;
+}
+
+/**
+ * The CRC-32 of zlib (and of Python's zlib.crc32).
+ */
+quint32 LogFormat::crc32(quint32 crc, const char *data, qint64 length)
+{
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> t;
+
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 c = i;
+
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+            t[i] = c;
+        }
+
+        return t;
+    }();
+
+    crc = ~crc;
+    for (qint64 i = 0; i < length; i++)
+        crc = table[(crc ^ (quint8)data[i]) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logformat.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @brief      The chunked dRonin log format
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMap>
+
+class UAVObjectManager;
+
+/**
+ * The chunked log format. After a 16 byte file header ("dRonLOG\n", then
+ * the format version and flags as little endian 32 bit words) the log is a
+ * sequence of chunks:
+ *
+ *   [type: 4 chars][flags: u32][stored length: u32][raw length: u32]
+ *   [payload: stored length bytes]
+ *   [stored length: u32][crc32 of everything before it in the chunk: u32]
+ *
+ * A chunk only counts once its trailer is there and checks out, so a log
+ * cut short by a crash is readable up to its last complete chunk.
+ *
+ * META holds "key=value" lines (git hash, UAVO hash), UAVO the XML
+ * description of every object in the log so that it can be decoded without
+ * the matching build, and DATA a block of records laid out as in the
+ * legacy format. END closes a log that was written out completely.
+ */
+class LogFormat
+{
+public:
+    static const char MAGIC[8];
+    static const quint32 VERSION = 2;
+    static const int FILE_HEADER_SIZE = 16;
+    static const int CHUNK_HEADER_SIZE = 16;
+    static const int CHUNK_TRAILER_SIZE = 8;
+
+    // Chunk flags
+    static const quint32 COMPRESSED = 1;
+
+    // Records are gathered into DATA chunks of about this size
+    static const int BLOCK_SIZE = 64 * 1024;
+
+    /**
+     * Where a chunk is in a log, as told by its header; its payload is only
+     * checked and unpacked once it is needed
+     */
+    struct Chunk
+    {
+        QByteArray type;
+        quint32 flags;
+        qint64 offset;
+        quint32 storedSize;
+        quint32 rawSize;
+    };
+
+    static bool isChunked(QIODevice *dev);
+    static void writeFileHeader(QIODevice *dev);
+    static bool writeChunk(QIODevice *dev, const char *type, const QByteArray &payload,
+                           bool compress);
+    static bool nextChunk(const uchar *log, qint64 size, qint64 *pos, Chunk *chunk);
+    static bool readPayload(const uchar *log, const Chunk &chunk, QByteArray *payload);
+
+    static QByteArray encodeMeta(const QMap<QString, QString> &meta);
+    static QMap<QString, QString> decodeMeta(const QByteArray &payload);
+    static QByteArray describeObjects(UAVObjectManager *objManager);
+
+private:
+    static quint32 crc32(quint32 crc, const char *data, qint64 length);
+};
+
+#endif // LOGFORMAT_H
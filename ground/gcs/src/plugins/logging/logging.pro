@@ -13,6 +13,7 @@ include(../../plugins/uavtalk/uavtalk.pri)
 
 HEADERS += loggingplugin.h \
     logfile.h \
+    logformat.h \
     logginggadgetwidget.h \
     logginggadget.h \
     logginggadgetfactory.h \
@@ -21,6 +22,7 @@ HEADERS += loggingplugin.h \
 
 SOURCES += loggingplugin.cpp \
     logfile.cpp \
+    logformat.cpp \
     logginggadgetwidget.cpp \
     logginggadget.cpp \
     logginggadgetfactory.cpp \
@@ -60,6 +60,11 @@ void LoggingGadgetWidget::setPlugin(LoggingPlugin *p)
     connect(m_logging->jumpToTimeSpinBox, SIGNAL(valueChanged(double)), p->getLogfile(),
             SLOT(setReplayTime(double)));
 
+    // Jumping needs the index of the log, which may still be being built
+    m_logging->jumpToTimeSpinBox->setEnabled(p->getLogfile()->isSeekable());
+    connect(p->getLogfile(), SIGNAL(seekableChanged(bool)), m_logging->jumpToTimeSpinBox,
+            SLOT(setEnabled(bool)));
+
     void pauseReplay();
     void resumeReplay();
 }
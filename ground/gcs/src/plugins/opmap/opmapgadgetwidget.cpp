@@ -210,6 +210,7 @@ OPMapGadgetWidget::OPMapGadgetWidget(QWidget *parent)
     m_widget->labelMousePos->setText("---");
     m_widget->labelMapZoom->setText("---");
     m_widget->labelNEDCoords->setText("---");
+    m_widget->labelTileCache->setText("---");
 
     m_widget->progressBarMap->setMaximum(1);
 
@@ -297,6 +298,8 @@ OPMapGadgetWidget::OPMapGadgetWidget(QWidget *parent)
     m_statusUpdateTimer = new QTimer();
     m_statusUpdateTimer->setInterval(200);
     connect(m_statusUpdateTimer, &QTimer::timeout, this, &OPMapGadgetWidget::updateMousePos);
+    connect(m_statusUpdateTimer, &QTimer::timeout, this,
+            &OPMapGadgetWidget::updateTileCacheStats);
     m_statusUpdateTimer->start();
     // **************
 
@@ -735,6 +738,31 @@ void OPMapGadgetWidget::updateMousePos()
     m_widget->labelNEDCoords->setText(s2);
 }
 
+/**
+  Update the Plugin UI with how well the decoded tile images are reused
+  */
+void OPMapGadgetWidget::updateTileCacheStats()
+{
+    if (!m_widget || !m_map)
+        return;
+
+    diagnostics diag = m_map->GetDiagnostics();
+    int drawn = diag.pixmapHits + diag.pixmapMisses;
+    if (drawn == 0)
+        return;
+
+    double hitRate = 100.0 * diag.pixmapHits / drawn;
+    double decodeTime = diag.pixmapMisses ? diag.decodeTimeMs / diag.pixmapMisses : 0;
+
+    m_widget->labelTileCache->setText(
+        tr("tiles hit:%1% dec:%2ms").arg(hitRate, 0, 'f', 0).arg(decodeTime, 0, 'f', 1));
+    m_widget->labelTileCache->setToolTip(
+        tr("Tile image cache: %1 hits, %2 misses, %3 ms decoding in total")
+            .arg(diag.pixmapHits)
+            .arg(diag.pixmapMisses)
+            .arg(diag.decodeTimeMs, 0, 'f', 0));
+}
+
 // *************************************************************************************
 // map signals
 
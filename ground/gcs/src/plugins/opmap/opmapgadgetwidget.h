@@ -140,6 +140,7 @@ private slots:
     void updatePosition();
 
     void updateMousePos();
+    void updateTileCacheStats();
 
     void zoomIn();
     void zoomOut();
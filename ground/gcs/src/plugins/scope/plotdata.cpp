@@ -40,8 +40,7 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName)
-    : yDataHistory(nullptr)
-    , dataUpdated(false)
+    : dataUpdated(false)
 {
     uavObjectName = p_uavObject;
 
@@ -59,13 +58,9 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName)
 
     xData = new QVector<double>();
     yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     yMinimum = 0;
     yMaximum = 120;
 
@@ -102,9 +97,6 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName)
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     xMinimum = 0;
     xMaximum = 16;
     yMinimum = 0;
@@ -119,8 +111,6 @@ Plot2dData::~Plot2dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 Plot3dData::~Plot3dData()
@@ -138,25 +128,23 @@ Plot3dData::~Plot3dData()
 }
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief getFieldHandle Find the plotted element in an updated UAVO. It is
+ * looked up by name the first time only, so that plotting fast updates does
+ * no string handling.
+ * @param obj UAVO with new data
+ * @return The plotted element, or an invalid handle if obj is not the plotted UAVO
  */
-double PlotData::valueAsDouble(UAVObject *obj, UAVObjectField *field, bool haveSubField,
-                               QString uavSubFieldName)
+const UAVObjectFieldHandle &PlotData::getFieldHandle(UAVObject *obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
+    static const UAVObjectFieldHandle none;
+
+    if (fieldHandle.isValid() && fieldHandle.getObject() == obj)
+        return fieldHandle;
+
+    if (uavObjectName != obj->getName())
+        return none;
 
-    if (haveSubField) {
-        int indexOfSubField = field->getElementNames().indexOf(
-            QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    } else
-        value = field->getValue();
+    fieldHandle = obj->getFieldHandle(uavFieldName, haveSubField ? uavSubFieldName : QString());
 
-    return value.toDouble();
+    return fieldHandle;
 }
@@ -44,8 +44,7 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject *obj, UAVObjectField *field, bool haveSubField,
-                         QString uavSubFieldName);
+    const UAVObjectFieldHandle &getFieldHandle(UAVObject *obj);
 
     // Setter functions
     void setXMinimum(double val) { xMinimum = val; }
@@ -100,14 +99,11 @@ protected:
     QString uavFieldName;
     QString uavSubFieldName;
     bool haveSubField;
+    UAVObjectFieldHandle fieldHandle;
 
     int scalePower; // This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
-
-    double correctionSum;
-    int correctionCount;
 
 private:
 };
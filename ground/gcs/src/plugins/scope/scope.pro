@@ -21,6 +21,7 @@ HEADERS += scopeplugin.h \
     scopes3d/spectrogramplotdata.h \
     scopes3d/spectrogramscopeconfig.h \
     scopes2d/plotdata2d.h \
+    scopes2d/plotsamples.h \
     scopes2d/scopes2dconfig.h \
     scopes3d/plotdata3d.h \
     scopes3d/scopes3dconfig.h \
@@ -36,6 +37,7 @@ HEADERS += scopegadgetfactory.h
 SOURCES += scopeplugin.cpp \
     scopes2d/histogramplotdata.cpp \
     scopes2d/histogramscopeconfig.cpp \
+    scopes2d/plotsamples.cpp \
     scopes2d/scatterplotdata.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
@@ -47,6 +49,10 @@ SOURCES += scopegadget.cpp
 SOURCES += scopegadgetfactory.cpp
 SOURCES += scopegadgetwidget.cpp
 
+contains(DEFINES, WITH_TESTS) {
+    SOURCES += scopetests.cpp
+}
+
 OTHER_FILES += ScopeGadget.pluginspec
 
 FORMS += scopegadgetoptionspage.ui
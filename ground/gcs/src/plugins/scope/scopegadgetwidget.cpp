@@ -46,6 +46,7 @@
 
 #include "qwt/src/qwt_legend.h"
 #include "qwt/src/qwt_legend_label.h"
+#include "qwt/src/qwt_plot_curve.h"
 #include "qwt/src/qwt_scale_widget.h"
 
 #include <iostream>
@@ -73,6 +74,12 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent)
 {
     m_grid = new QwtPlotGrid;
 
+    m_frameTimesLabel = new QwtPlotTextLabel;
+    m_frameTimesLabel->setZ(1000);
+    m_frameTimesLabel->attach(this);
+    m_frameTimesLabel->hide();
+    resetFrameTimes();
+
     setMouseTracking(true);
     //	canvas()->setMouseTracking(true);
 
@@ -125,6 +132,12 @@ void ScopeGadgetWidget::popUpMenu(const QPoint &mousePosition)
 
     // Add copy to clipboard item to menu
     connect(action, &QAction::triggered, this, &ScopeGadgetWidget::copyToClipboardAsImage);
+
+    // Add frame time display to menu
+    action = menu.addAction(tr("Show Frame Times"));
+    action->setCheckable(true);
+    action->setChecked(m_frameTimesLabel->isVisible());
+    connect(action, &QAction::toggled, this, &ScopeGadgetWidget::showFrameTimes);
     menu.addSeparator();
 
     // Add options dialog to clipboard
@@ -361,15 +374,106 @@ void ScopeGadgetWidget::replotNewData()
     if (!isVisible() || m_scope == NULL)
         return;
 
+    QElapsedTimer timer;
+    timer.start();
+
     // Update the data in the scopes
     foreach (PlotData *plotData, m_dataSources.values()) {
         plotData->plotNewData(plotData, m_scope, this);
     }
 
+    if (m_frameTimesLabel->isVisible())
+        updateFrameTimes(timer.nsecsElapsed());
+
     // Repaint the scopes
     replot();
 }
 
+/**
+ * @brief ScopeGadgetWidget::drawCanvas Draws the plot items, timing it when
+ * the frame times are shown. The canvas paints some time after replot(), so
+ * this is where the drawing cost can be seen.
+ * @param painter
+ */
+void ScopeGadgetWidget::drawCanvas(QPainter *painter)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QwtPlot::drawCanvas(painter);
+
+    if (m_frameTimesLabel->isVisible()) {
+        qint64 nsecs = timer.nsecsElapsed();
+
+        m_draws++;
+        m_drawNsecs += nsecs;
+        m_maxDrawNsecs = qMax(m_maxDrawNsecs, nsecs);
+    }
+}
+
+/**
+ * @brief ScopeGadgetWidget::showFrameTimes Shows or hides the frame times
+ * @param show
+ */
+void ScopeGadgetWidget::showFrameTimes(bool show)
+{
+    resetFrameTimes();
+    m_frameTimesLabel->setText(QwtText());
+    m_frameTimesLabel->setVisible(show);
+
+    replot();
+}
+
+/**
+ * @brief ScopeGadgetWidget::updateFrameTimes Accounts the update of a frame,
+ * and refreshes the frame time label once a second
+ * @param updateNsecs Time taken to update the curves
+ */
+void ScopeGadgetWidget::updateFrameTimes(qint64 updateNsecs)
+{
+    m_updates++;
+    m_updateNsecs += updateNsecs;
+    m_maxUpdateNsecs = qMax(m_maxUpdateNsecs, updateNsecs);
+
+    if (m_frameTimesPeriod.isValid() && m_frameTimesPeriod.elapsed() < 1000)
+        return;
+
+    size_t points = 0;
+    foreach (QwtPlotItem *item, itemList(QwtPlotItem::Rtti_PlotCurve))
+        points += static_cast<QwtPlotCurve *>(item)->dataSize();
+
+    double meanUpdate = m_updateNsecs / 1e6 / m_updates;
+    double meanDraw = m_draws ? m_drawNsecs / 1e6 / m_draws : 0;
+
+    QwtText text(tr("Update: %1 ms (max %2 ms)\nDraw: %3 ms (max %4 ms)\nPoints drawn: %5")
+                     .arg(meanUpdate, 0, 'f', 2)
+                     .arg(m_maxUpdateNsecs / 1e6, 0, 'f', 2)
+                     .arg(meanDraw, 0, 'f', 2)
+                     .arg(m_maxDrawNsecs / 1e6, 0, 'f', 2)
+                     .arg(points));
+    text.setRenderFlags(Qt::AlignLeft | Qt::AlignTop);
+    text.setBackgroundBrush(QBrush(QColor(255, 255, 255, 192)));
+    m_frameTimesLabel->setText(text);
+
+    resetFrameTimes();
+    m_frameTimesPeriod.start();
+}
+
+/**
+ * @brief ScopeGadgetWidget::resetFrameTimes Starts a new period of frame time
+ * accounting
+ */
+void ScopeGadgetWidget::resetFrameTimes()
+{
+    m_frameTimesPeriod.invalidate();
+    m_updates = 0;
+    m_updateNsecs = 0;
+    m_maxUpdateNsecs = 0;
+    m_draws = 0;
+    m_drawNsecs = 0;
+    m_maxDrawNsecs = 0;
+}
+
 /**
  * @brief ScopeGadgetWidget::clearPlotWidget
  */
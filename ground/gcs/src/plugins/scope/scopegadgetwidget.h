@@ -46,37 +46,31 @@ class UAVDataObject;
 #include "qwt/src/qwt_plot.h"
 #include "qwt/src/qwt_plot_grid.h"
 #include "qwt/src/qwt_plot_layout.h"
+#include "qwt/src/qwt_plot_textlabel.h"
 #include "qwt/src/qwt_scale_draw.h"
 
 #include "uavobjects/uavobject.h"
 #include "plotdata.h"
 
+#include <QElapsedTimer>
 #include <QTimer>
 #include <QTime>
 #include <QVector>
 
 /*!
   \brief This class is used to render the time values on the horizontal axis for the
-  ChronoPlot.
+  ChronoPlot. Samples are timed by the vehicle's clock or the GCS monotonic clock
+  (see UAVObject::getTimestamp()), so this shows the time elapsed on that clock.
   */
 class TimeScaleDraw : public QwtScaleDraw
 {
 public:
-    TimeScaleDraw()
-    {
-        // baseTime = QDateTime::currentDateTime().toTime_t();
-    }
+    TimeScaleDraw() {}
     virtual QwtText label(double v) const
     {
-        uint seconds = (uint)(v);
-        QDateTime upTime = QDateTime::fromTime_t(seconds);
-        QTime timePart = upTime.time().addMSecs((v - seconds) * 1000);
-        upTime.setTime(timePart);
-        return upTime.toLocalTime().toString("hh:mm:ss");
+        QTime elapsed = QTime(0, 0).addMSecs(qRound64(qMax(v, 0.0) * 1000) % (24 * 3600 * 1000));
+        return elapsed.toString("hh:mm:ss");
     }
-
-private:
-    //    double baseTime;
 };
 
 class ScopeGadgetWidget : public QwtPlot
@@ -105,6 +99,8 @@ public:
     QwtLegend *m_legend;
     void setScopeName(QString val) { scopeName = val; }
 
+    virtual void drawCanvas(QPainter *painter);
+
 protected:
     void mousePressEvent(QMouseEvent *e);
     void mouseReleaseEvent(QMouseEvent *e);
@@ -123,8 +119,12 @@ private slots:
     void clearPlot();
     void copyToClipboardAsImage();
     void showOptionDialog();
+    void showFrameTimes(bool show);
 
 private:
+    void updateFrameTimes(qint64 updateNsecs);
+    void resetFrameTimes();
+
     int m_refreshInterval;
     ScopeConfig *m_scope;
     QMap<QString, PlotData *> m_dataSources;
@@ -132,6 +132,17 @@ private:
     static QTimer *replotTimer;
     QList<QString> m_connectedUAVObjects;
     QString scopeName;
+
+    // Time spent updating the curves and drawing them, shown on the canvas
+    // about once a second when asked for
+    QwtPlotTextLabel *m_frameTimesLabel;
+    QElapsedTimer m_frameTimesPeriod;
+    int m_updates;
+    qint64 m_updateNsecs;
+    qint64 m_maxUpdateNsecs;
+    int m_draws;
+    qint64 m_drawNsecs;
+    qint64 m_maxDrawNsecs;
 };
 
 #endif /* SCOPEGADGETWIDGET_H_ */
@@ -43,6 +43,15 @@ public:
     bool initialize(const QStringList &arguments, QString *errorString);
     void shutdown();
 
+#ifdef WITH_TESTS
+private Q_SLOTS:
+    void testPlotSamples();
+    void testRunningStats();
+    void testPlotEnvelope();
+    void testTimeSeriesTimestamps();
+    void testAppendBenchmark();
+#endif
+
 private:
     ScopeGadgetFactory *mf;
 };
@@ -96,7 +96,7 @@ bool HistogramData::append(UAVObject *obj)
     if (uavObjectName == obj->getName()) {
 
         // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
+        const UAVObjectFieldHandle &field = getFieldHandle(obj);
 
         // Bad place to do this
         double step = binWidth;
@@ -106,9 +106,8 @@ bool HistogramData::append(UAVObject *obj)
         if (numberOfBins > MAX_NUMBER_OF_INTERVALS)
             numberOfBins = MAX_NUMBER_OF_INTERVALS;
 
-        if (field) {
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+        if (field.isValid()) {
+            double currentValue = field.getDouble() * pow(10, scalePower);
 
             // Extend interval, if necessary
             if (!histogramInterval->empty()) {
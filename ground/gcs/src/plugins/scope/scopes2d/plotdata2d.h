@@ -44,8 +44,6 @@ public:
     Plot2dData(QString uavObject, QString uavField);
     ~Plot2dData();
 
-    QVector<double> *yDataHistory; // Used for scatterplots
-
     virtual void setUpdatedFlagToTrue() { dataUpdated = true; }
     virtual bool readAndResetUpdatedFlag()
     {
@@ -0,0 +1,370 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotsamples.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sample storage for the 2D scopes
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scopes2d/plotsamples.h"
+
+#include <math.h>
+
+// What Qwt reports as the bounds of no samples at all
+static const QRectF NO_BOUNDS(1.0, 1.0, -2.0, -2.0);
+
+PlotSamples::PlotSamples(int capacity)
+    : buffer(capacity)
+    , head(0)
+    , count(0)
+    , boundsValid(false)
+{
+}
+
+/**
+ * @brief PlotSamples::setCapacity Resize the ring, keeping the newest samples
+ * that fit
+ * @param capacity Number of samples the ring holds
+ */
+void PlotSamples::setCapacity(int capacity)
+{
+    if (capacity == buffer.size())
+        return;
+
+    int keep = qMin(count, capacity);
+    QVector<QPointF> resized(capacity);
+
+    for (int i = 0; i < keep; i++)
+        resized[i] = at(count - keep + i);
+
+    buffer.swap(resized);
+    head = 0;
+    count = keep;
+    boundsValid = false;
+}
+
+/**
+ * @brief PlotSamples::append Add a sample, dropping the oldest if full
+ */
+void PlotSamples::append(double x, double y)
+{
+    if (buffer.isEmpty())
+        return;
+
+    int tail = head + count;
+    if (tail >= buffer.size())
+        tail -= buffer.size();
+
+    buffer[tail] = QPointF(x, y);
+
+    if (count < buffer.size()) {
+        count++;
+    } else if (++head == buffer.size()) {
+        head = 0;
+    }
+
+    boundsValid = false;
+}
+
+/**
+ * @brief PlotSamples::removeFirst Drop the oldest sample
+ */
+void PlotSamples::removeFirst()
+{
+    if (count == 0)
+        return;
+
+    if (++head == buffer.size())
+        head = 0;
+
+    count--;
+    boundsValid = false;
+}
+
+void PlotSamples::clear()
+{
+    head = 0;
+    count = 0;
+    boundsValid = false;
+}
+
+/**
+ * @brief PlotSamples::boundingRect The smallest rectangle holding every sample
+ */
+QRectF PlotSamples::boundingRect() const
+{
+    if (boundsValid)
+        return bounds;
+
+    if (count == 0) {
+        bounds = NO_BOUNDS;
+    } else {
+        double minX = first().x(), maxX = minX;
+        double minY = first().y(), maxY = minY;
+
+        for (int i = 1; i < count; i++) {
+            const QPointF &p = at(i);
+
+            minX = qMin(minX, p.x());
+            maxX = qMax(maxX, p.x());
+            minY = qMin(minY, p.y());
+            maxY = qMax(maxY, p.y());
+        }
+
+        bounds = QRectF(minX, minY, maxX - minX, maxY - minY);
+    }
+
+    boundsValid = true;
+    return bounds;
+}
+
+PlotEnvelope::PlotEnvelope()
+    : head(0)
+    , count(0)
+    , width(0)
+{
+}
+
+/**
+ * @brief PlotEnvelope::setColumnWidth Set the span of x covered by a pixel
+ * column; this starts over
+ */
+void PlotEnvelope::setColumnWidth(double width)
+{
+    this->width = width;
+    clear();
+}
+
+/**
+ * @brief PlotEnvelope::append Take in a sample, which is expected not to be
+ * older than the ones before it
+ */
+void PlotEnvelope::append(double x, double y)
+{
+    if (width <= 0)
+        return;
+
+    qint64 index = static_cast<qint64>(floor(x / width));
+    QPointF p(x, y);
+
+    if (count > 0) {
+        int pos = head + count - 1;
+        if (pos >= buffer.size())
+            pos -= buffer.size();
+
+        Column &last = buffer[pos];
+
+        if (last.index == index) {
+            if (y < last.low.y())
+                last.low = p;
+            if (y > last.high.y())
+                last.high = p;
+
+            return;
+        }
+    }
+
+    if (count == buffer.size()) {
+        // About one column per pixel is kept, so this settles quickly
+        QVector<Column> grown(qMax(2 * buffer.size(), 64));
+
+        for (int i = 0; i < count; i++)
+            grown[i] = column(i);
+
+        buffer.swap(grown);
+        head = 0;
+    }
+
+    int tail = head + count;
+    if (tail >= buffer.size())
+        tail -= buffer.size();
+
+    buffer[tail] = { index, p, p };
+    count++;
+}
+
+/**
+ * @brief PlotEnvelope::removeBefore Drop the columns that lie wholly before x
+ */
+void PlotEnvelope::removeBefore(double x)
+{
+    if (width <= 0)
+        return;
+
+    qint64 index = static_cast<qint64>(floor(x / width));
+
+    while (count > 0 && column(0).index < index) {
+        if (++head == buffer.size())
+            head = 0;
+
+        count--;
+    }
+}
+
+void PlotEnvelope::clear()
+{
+    head = 0;
+    count = 0;
+}
+
+/**
+ * @brief PlotEnvelope::at The low and high point of each column, in the
+ * order they were sampled
+ */
+QPointF PlotEnvelope::at(int i) const
+{
+    const Column &c = column(i / 2);
+    bool lowFirst = c.low.x() <= c.high.x();
+
+    if ((i % 2 == 0) == lowFirst)
+        return c.low;
+
+    return c.high;
+}
+
+size_t PlotSeriesData::size() const
+{
+    if (decimated())
+        return envelope->size();
+
+    return samples->size();
+}
+
+QPointF PlotSeriesData::sample(size_t i) const
+{
+    QPointF p = decimated() ? envelope->at(i) : samples->at(i);
+
+    if (indexed)
+        p.setX(p.x() - samples->first().x());
+
+    return p;
+}
+
+QRectF PlotSeriesData::boundingRect() const
+{
+    QRectF bounds;
+
+    if (decimated()) {
+        // The envelope holds the extremes, in fewer points
+        double minY = envelope->at(0).y(), maxY = minY;
+
+        for (int i = 1; i < envelope->size(); i++) {
+            minY = qMin(minY, envelope->at(i).y());
+            maxY = qMax(maxY, envelope->at(i).y());
+        }
+
+        double minX = samples->first().x(), maxX = samples->last().x();
+        bounds = QRectF(minX, minY, maxX - minX, maxY - minY);
+    } else {
+        bounds = samples->boundingRect();
+    }
+
+    if (indexed && !samples->isEmpty()) {
+        bounds.setLeft(0);
+        bounds.setRight(samples->size() - 1);
+    }
+
+    return bounds;
+}
+
+RunningStats::RunningStats(int window)
+    : head(0)
+    , n(0)
+    , m(0)
+    , m2(0)
+    , sinceRecompute(0)
+{
+    setWindow(window);
+}
+
+/**
+ * @brief RunningStats::setWindow Set how many of the latest values to cover;
+ * this starts over
+ */
+void RunningStats::setWindow(int window)
+{
+    history.fill(0, qMax(window, 1));
+    clear();
+}
+
+void RunningStats::clear()
+{
+    head = 0;
+    n = 0;
+    m = 0;
+    m2 = 0;
+    sinceRecompute = 0;
+}
+
+void RunningStats::append(double value)
+{
+    if (n < history.size()) {
+        int tail = head + n;
+        if (tail >= history.size())
+            tail -= history.size();
+
+        history[tail] = value;
+        n++;
+
+        double delta = value - m;
+        m += delta / n;
+        m2 += delta * (value - m);
+    } else {
+        // Replace the oldest value with the new one
+        double oldest = history[head];
+        double oldMean = m;
+
+        history[head] = value;
+        if (++head == history.size())
+            head = 0;
+
+        m += (value - oldest) / n;
+        m2 += (value - oldest) * (value - m + oldest - oldMean);
+    }
+
+    // Rounding leaves a little behind with every value taken out, so start
+    // afresh once per window; that keeps the cost constant per value
+    if (++sinceRecompute >= history.size())
+        recompute();
+}
+
+double RunningStats::standardDeviation() const
+{
+    double var = variance();
+
+    return var > 0 ? sqrt(var) : 0;
+}
+
+void RunningStats::recompute()
+{
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += history[i];
+
+    m = n ? sum / n : 0;
+
+    double squares = 0;
+    for (int i = 0; i < n; i++)
+        squares += (history[i] - m) * (history[i] - m);
+
+    m2 = squares;
+    sinceRecompute = 0;
+}
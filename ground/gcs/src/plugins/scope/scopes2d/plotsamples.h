@@ -0,0 +1,196 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotsamples.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sample storage for the 2D scopes
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PLOTSAMPLES_H
+#define PLOTSAMPLES_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+/**
+ * @brief The PlotSamples class A ring of (x, y) samples. Appending to a full
+ * ring drops its oldest sample, so adding and expiring samples both take
+ * constant time.
+ */
+class PlotSamples
+{
+public:
+    PlotSamples(int capacity = 0);
+
+    void setCapacity(int capacity);
+    int capacity() const { return buffer.size(); }
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    bool isFull() const { return count == buffer.size(); }
+
+    void append(double x, double y);
+    void removeFirst();
+    void clear();
+
+    /*!
+      \brief The i'th oldest sample
+      */
+    const QPointF &at(int i) const
+    {
+        int pos = head + i;
+        if (pos >= buffer.size())
+            pos -= buffer.size();
+
+        return buffer.at(pos);
+    }
+
+    const QPointF &first() const { return at(0); }
+    const QPointF &last() const { return at(count - 1); }
+
+    QRectF boundingRect() const;
+
+private:
+    QVector<QPointF> buffer;
+    int head;
+    int count;
+
+    // Worked out when a replot asks for it, not on every sample
+    mutable QRectF bounds;
+    mutable bool boundsValid;
+};
+
+/**
+ * @brief The PlotEnvelope class The lowest and highest sample in each pixel
+ * column of a plot, kept up to date as samples arrive and expire. Drawing the
+ * envelope looks the same as drawing every sample, at a cost that depends on
+ * the plot width instead of the number of samples.
+ */
+class PlotEnvelope
+{
+public:
+    PlotEnvelope();
+
+    void setColumnWidth(double width);
+    double columnWidth() const { return width; }
+
+    void append(double x, double y);
+    void removeBefore(double x);
+    void clear();
+
+    /*!
+      \brief Number of points, two per column
+      */
+    int size() const { return 2 * count; }
+    QPointF at(int i) const;
+
+private:
+    struct Column
+    {
+        qint64 index;
+        QPointF low;
+        QPointF high;
+    };
+
+    const Column &column(int i) const
+    {
+        int pos = head + i;
+        if (pos >= buffer.size())
+            pos -= buffer.size();
+
+        return buffer.at(pos);
+    }
+
+    QVector<Column> buffer;
+    int head;
+    int count;
+    double width;
+};
+
+/**
+ * @brief The PlotSeriesData class Hands the samples of a PlotSamples ring to
+ * a Qwt curve in place, or their envelope when that has fewer points. With
+ * indexed set, x counts from the oldest sample, for plots that scroll by
+ * sample count.
+ */
+class PlotSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    PlotSeriesData(const PlotSamples *samples, const PlotEnvelope *envelope = nullptr,
+                   bool indexed = false)
+        : samples(samples)
+        , envelope(envelope)
+        , indexed(indexed)
+    {
+    }
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    bool decimated() const
+    {
+        return envelope && envelope->size() > 0 && envelope->size() < samples->size();
+    }
+
+    const PlotSamples *samples;
+    const PlotEnvelope *envelope;
+    bool indexed;
+};
+
+/**
+ * @brief The RunningStats class Mean and sample variance of the most recent
+ * values, updated in constant time per value with Welford's method (a value
+ * leaving the window is taken out the same way it went in).
+ */
+class RunningStats
+{
+public:
+    RunningStats(int window = 1);
+
+    void setWindow(int window);
+    int window() const { return history.size(); }
+
+    void append(double value);
+    void clear();
+
+    int count() const { return n; }
+    double mean() const { return m; }
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+    double standardDeviation() const;
+
+private:
+    void recompute();
+
+    QVector<double> history;
+    int head;
+    int n;
+    double m;
+    double m2;
+
+    int sinceRecompute;
+};
+
+#endif // PLOTSAMPLES_H
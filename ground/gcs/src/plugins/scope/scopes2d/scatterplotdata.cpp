@@ -37,6 +37,11 @@
 #include "qwt/src/qwt_plot.h"
 #include "qwt/src/qwt_plot_curve.h"
 
+// Bounds on the samples a time series keeps; at the top, a long window of
+// fast data loses its oldest part
+static const int MIN_TIME_SAMPLES = 256;
+static const int MAX_TIME_SAMPLES = 1 << 20;
+
 /**
  * @brief Scatterplot2dScopeConfig::plotNewData Update plot with new data
  * @param scopeGadgetWidget
@@ -46,15 +51,20 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
-    // Plot new data
+    updateEnvelope(scopeGadgetWidget);
+
+    // Plot new data; the curve reads the samples in place
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        curve->itemChanged();
+
+    // Scroll with this curve's own latest sample, not with the wall clock or
+    // whichever object arrived last: objects may be stamped on different
+    // clocks (the vehicle's, the log's or the GCS's)
+    if (samples.isEmpty())
+        return;
 
-    QDateTime NOW = QDateTime::currentDateTime();
-    double toTime = NOW.toTime_t();
-    toTime += NOW.time().msec() / 1000.0;
+    double toTime = samples.last().x();
 
     scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, toTime - m_xWindowSize, toTime);
 }
@@ -68,11 +78,63 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
+    updateEnvelope(scopeGadgetWidget);
 
-    // Plot new data
+    // Plot new data; the curve reads the samples in place
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        curve->itemChanged();
+}
+
+/**
+ * @brief ScatterplotData::applyMathFunction Perform scope math, if necessary
+ * @param value The latest value of the field
+ * @return The value to plot
+ */
+double ScatterplotData::applyMathFunction(double value)
+{
+    if (mathFunction != "Boxcar average" && mathFunction != "Standard deviation")
+        return value;
+
+    if (stats.window() != (int)meanSamples)
+        stats.setWindow(meanSamples);
+
+    stats.append(value);
+
+    if (mathFunction == "Standard deviation")
+        return stats.standardDeviation();
+
+    return stats.mean();
+}
+
+/**
+ * @brief ScatterplotData::appendSample Add a sample to the buffer and to its
+ * envelope
+ */
+void ScatterplotData::appendSample(double x, double y)
+{
+    samples.append(x, y);
+
+    envelope.append(x, y);
+    envelope.removeBefore(samples.first().x());
+}
+
+/**
+ * @brief ScatterplotData::updateEnvelope Match the envelope columns to the
+ * pixel columns of the plot, rebuilding it when they change
+ * @param scopeGadgetWidget The plot
+ */
+void ScatterplotData::updateEnvelope(ScopeGadgetWidget *scopeGadgetWidget)
+{
+    int columns = qMax(scopeGadgetWidget->canvas()->width(), 1);
+    double columnWidth = getXWindowSize() / columns;
+
+    if (columnWidth == envelope.columnWidth())
+        return;
+
+    envelope.setColumnWidth(columnWidth);
+
+    for (int i = 0; i < samples.size(); i++)
+        envelope.append(samples.at(i).x(), samples.at(i).y());
 }
 
 /**
@@ -82,64 +144,23 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject *obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            // Perform scope math, if necessary
-            if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
-                // Put the new value at the front
-                yDataHistory->append(currentValue);
-
-                // calculate average value
-                meanSum += currentValue;
-                if (yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum += currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg = meanSum / yDataHistory->size();
-
-                if (mathFunction == "Standard deviation") {
-                    // Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum = 0;
-                    for (int i = 0; i < yDataHistory->size(); i++) {
-                        stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
-                    }
-                    yData->append(sqrt(stdSum));
-                } else {
-                    yData->append(boxcarAvg);
-                }
-            } else {
-                yData->append(currentValue);
-            }
-
-            if (yData->size()
-                > getXWindowSize()) { // If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
-
-            return true;
-        }
-    }
-
-    return false;
+    // Get the field of interest
+    const UAVObjectFieldHandle &field = getFieldHandle(obj);
+
+    if (!field.isValid())
+        return false;
+
+    double currentValue = field.getDouble() * pow(10, scalePower);
+
+    // The window is a number of samples; once it is full, new data
+    // pushes out the oldest
+    int windowSize = qMax((int)getXWindowSize(), 1);
+    if (samples.capacity() != windowSize)
+        samples.setCapacity(windowSize);
+
+    appendSample(sampleIndex++, applyMathFunction(currentValue));
+
+    return true;
 }
 
 /**
@@ -149,63 +170,30 @@ bool SeriesPlotData::append(UAVObject *obj)
  */
 bool TimeSeriesPlotData::append(UAVObject *obj)
 {
-    if (uavObjectName == obj->getName()) {
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); // THINK ABOUT REIMPLEMENTING THIS TO SHOW
-                                                          // UAVO TIME, NOT SYSTEM TIME
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            // Perform scope math, if necessary
-            if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
-                // Put the new value at the back
-                yDataHistory->append(currentValue);
-
-                // calculate average value
-                meanSum += currentValue;
-                if (yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum += currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg = meanSum / yDataHistory->size();
-
-                if (mathFunction == "Standard deviation") {
-                    // Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum = 0;
-                    for (int i = 0; i < yDataHistory->size(); i++) {
-                        stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
-                    }
-                    yData->append(sqrt(stdSum));
-                } else {
-                    yData->append(boxcarAvg);
-                }
-            } else {
-                yData->append(currentValue);
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
-
-            // Remove stale data
-            removeStaleData();
-
-            return true;
-        }
-    }
-
-    return false;
+    // Get the field of interest
+    const UAVObjectFieldHandle &field = getFieldHandle(obj);
+
+    if (!field.isValid())
+        return false;
+
+    double valueX = obj->getTimestamp() / 1000.0;
+    double currentValue = field.getDouble() * pow(10, scalePower);
+
+    // The clock starts over when a log is replayed again, or the vehicle
+    // restarts; what was plotted before doesn't line up with it any more
+    if (!samples.isEmpty() && valueX < samples.last().x())
+        clearPlots();
+
+    // Remove stale data, then make room if the window holds more
+    // samples than the buffer does at this rate
+    removeStaleData();
+
+    if (samples.isFull() && samples.capacity() < MAX_TIME_SAMPLES)
+        samples.setCapacity(qBound(MIN_TIME_SAMPLES, 2 * samples.capacity(), MAX_TIME_SAMPLES));
+
+    appendSample(valueX, applyMathFunction(currentValue));
+
+    return true;
 }
 
 /**
@@ -213,22 +201,18 @@ bool TimeSeriesPlotData::append(UAVObject *obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
-
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    if (samples.isEmpty())
+        return;
+
+    double newestValue = samples.last().x();
+
+    while (!samples.isEmpty() && newestValue - samples.first().x() > getXWindowSize())
+        samples.removeFirst();
+
+    if (samples.isEmpty())
+        envelope.clear();
+    else
+        envelope.removeBefore(samples.first().x());
 }
 
 /**
@@ -240,6 +224,16 @@ void TimeSeriesPlotData::removeStaleDataTimeout()
     removeStaleData();
 }
 
+/**
+ * @brief ScatterplotData::setCurve Plot the data with a curve
+ * @param val The curve, which reads the samples from here without copying
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    curve->setSamples(createSeriesData());
+}
+
 /**
  * @brief ScatterplotData::deletePlots Delete all plot data
  */
@@ -256,6 +250,7 @@ void ScatterplotData::deletePlots(PlotData *scatterplotData)
  */
 void ScatterplotData::clearPlots()
 {
-    yData->clear();
-    xData->clear();
+    samples.clear();
+    envelope.clear();
+    stats.clear();
 }
@@ -28,6 +28,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/plotsamples.h"
 #include "uavobjects/uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -52,10 +53,23 @@ public:
     virtual void deletePlots(PlotData *);
     void clearPlots();
 
-    void setCurve(QwtPlotCurve *val) { curve = val; }
+    void setCurve(QwtPlotCurve *val);
+
+    const PlotSamples &getSamples() const { return samples; }
 
 protected:
+    double applyMathFunction(double value);
+    void appendSample(double x, double y);
+    void updateEnvelope(ScopeGadgetWidget *scopeGadgetWidget);
+    virtual PlotSeriesData *createSeriesData()
+    {
+        return new PlotSeriesData(&samples, &envelope);
+    }
+
     QwtPlotCurve *curve;
+    PlotSamples samples;
+    PlotEnvelope envelope;
+    RunningStats stats;
 };
 
 /**
@@ -68,6 +82,7 @@ class SeriesPlotData : public ScatterplotData
 public:
     SeriesPlotData(QString uavObject, QString uavField)
         : ScatterplotData(uavObject, uavField)
+        , sampleIndex(0)
     {
     }
     ~SeriesPlotData() {}
@@ -82,11 +97,22 @@ public:
       */
     virtual void removeStaleData() {}
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
+
+protected:
+    virtual PlotSeriesData *createSeriesData()
+    {
+        return new PlotSeriesData(&samples, &envelope, true);
+    }
+
+private:
+    // Counts the samples, so that they keep their place in the envelope
+    double sampleIndex;
 };
 
 /**
  * @brief The TimeSeriesPlotData class The chrono plot has a variable sized buffer of data,
- * where the data is for a specified time period.
+ * where the data is for a specified time period. The buffer grows to fit the
+ * time period at the rate the data comes in.
  */
 class TimeSeriesPlotData : public ScatterplotData
 {
@@ -297,9 +297,8 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         QwtPlotCurve *plotCurve = new QwtPlotCurve(curveNameScaledMath);
         plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine,
                                Qt::SquareCap, Qt::BevelJoin));
-        plotCurve->setSamples(*(scatterplotData->getXData()), *(scatterplotData->getYData()));
-        plotCurve->attach(scopeGadgetWidget);
         scatterplotData->setCurve(plotCurve);
+        plotCurve->attach(scopeGadgetWidget);
 
         // Keep the curve details for later
         scopeGadgetWidget->insertDataSources(curveNameScaledMath, scatterplotData);
@@ -420,8 +419,9 @@ void Scatterplot2dScopeConfig::configureAxes(ScopeGadgetWidget *scopeGadgetWidge
     case TIMESERIES2D: {
         // Configure axes
         scopeGadgetWidget->setAxisScaleDraw(QwtPlot::xBottom, new TimeScaleDraw());
-        uint NOW = QDateTime::currentDateTime().toTime_t();
-        scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, NOW - timeHorizon / 1000, NOW);
+        // Until there is data, show the time on the GCS clock
+        double now = UAVObject::monotonicTimestamp() / 1000.0;
+        scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, now - timeHorizon / 1000, now);
         break;
     }
     case SERIES2D:
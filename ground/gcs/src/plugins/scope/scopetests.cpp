@@ -0,0 +1,273 @@
+/**
+ ******************************************************************************
+ * @file       scopetests.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief      Tests and benchmarks of the scope sample storage
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "scopeplugin.h"
+
+#include "scopes2d/plotsamples.h"
+#include "scopes2d/scatterplotdata.h"
+#include "gyros.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+#include <math.h>
+#include <memory>
+
+void ScopePlugin::testPlotSamples()
+{
+    PlotSamples samples(4);
+
+    for (int i = 0; i < 6; i++)
+        samples.append(i, 10 * i);
+
+    // The two oldest were pushed out
+    QCOMPARE(samples.size(), 4);
+    QCOMPARE(samples.first(), QPointF(2, 20));
+    QCOMPARE(samples.last(), QPointF(5, 50));
+    QCOMPARE(samples.boundingRect(), QRectF(2, 20, 3, 30));
+
+    samples.removeFirst();
+    QCOMPARE(samples.size(), 3);
+    QCOMPARE(samples.first(), QPointF(3, 30));
+
+    // Growing and shrinking keep the newest samples in order
+    samples.setCapacity(8);
+    samples.append(6, 60);
+    QCOMPARE(samples.size(), 4);
+    QCOMPARE(samples.at(0), QPointF(3, 30));
+    QCOMPARE(samples.at(3), QPointF(6, 60));
+
+    samples.setCapacity(2);
+    QCOMPARE(samples.size(), 2);
+    QCOMPARE(samples.first(), QPointF(5, 50));
+    QCOMPARE(samples.last(), QPointF(6, 60));
+
+    PlotSeriesData indexed(&samples, nullptr, true);
+    QCOMPARE(indexed.size(), (size_t)2);
+    QCOMPARE(indexed.sample(1), QPointF(1, 60));
+    QCOMPARE(indexed.boundingRect(), QRectF(0, 50, 1, 10));
+
+    samples.clear();
+    QVERIFY(samples.isEmpty());
+    QVERIFY(!samples.boundingRect().isValid());
+}
+
+void ScopePlugin::testRunningStats()
+{
+    const int window = 50;
+    RunningStats stats(window);
+    QVector<double> values;
+
+    // A big offset is where the naive sum of squares falls apart
+    qsrand(1234);
+    for (int i = 0; i < 20000; i++) {
+        double value = 1e6 + (qrand() % 2000) / 100.0 + 5 * sin(i / 100.0);
+
+        values.append(value);
+        stats.append(value);
+
+        int n = qMin(values.size(), window);
+        double sum = 0;
+        for (int j = values.size() - n; j < values.size(); j++)
+            sum += values[j];
+        double mean = sum / n;
+
+        double squares = 0;
+        for (int j = values.size() - n; j < values.size(); j++)
+            squares += (values[j] - mean) * (values[j] - mean);
+        double stddev = n > 1 ? sqrt(squares / (n - 1)) : 0;
+
+        QCOMPARE(stats.count(), n);
+        QVERIFY(fabs(stats.mean() - mean) < 1e-6);
+        QVERIFY(fabs(stats.standardDeviation() - stddev) < 1e-6);
+    }
+}
+
+void ScopePlugin::testPlotEnvelope()
+{
+    const double width = 0.5;
+    PlotSamples samples(1000);
+    PlotEnvelope envelope;
+
+    envelope.setColumnWidth(width);
+
+    qsrand(4321);
+    for (int i = 0; i < 3000; i++) {
+        double x = i * 0.013;
+        double y = (qrand() % 1000) / 10.0;
+
+        samples.append(x, y);
+        envelope.append(x, y);
+        envelope.removeBefore(samples.first().x());
+    }
+
+    // Each column holds the extremes of the samples that fall in it
+    QVector<QPointF> lows, highs;
+    qint64 index = -1;
+
+    for (int i = 0; i < samples.size(); i++) {
+        const QPointF &p = samples.at(i);
+        qint64 pIndex = static_cast<qint64>(floor(p.x() / width));
+
+        if (pIndex != index) {
+            lows.append(p);
+            highs.append(p);
+            index = pIndex;
+        } else {
+            if (p.y() < lows.last().y())
+                lows.last() = p;
+            if (p.y() > highs.last().y())
+                highs.last() = p;
+        }
+    }
+
+    // The oldest column may still hold samples that have since expired
+    QCOMPARE(envelope.size(), 2 * lows.size());
+
+    for (int i = 1; i < lows.size(); i++) {
+        QPointF a = envelope.at(2 * i), b = envelope.at(2 * i + 1);
+
+        QCOMPARE(qMin(a.y(), b.y()), lows[i].y());
+        QCOMPARE(qMax(a.y(), b.y()), highs[i].y());
+        QVERIFY(a.x() <= b.x());
+    }
+
+    // Far fewer points than samples go to the curve, with the same extent
+    PlotSeriesData data(&samples, &envelope);
+    QCOMPARE(data.size(), (size_t)envelope.size());
+    QCOMPARE(data.boundingRect().left(), samples.first().x());
+    QCOMPARE(data.boundingRect().right(), samples.last().x());
+
+    envelope.removeBefore(samples.last().x());
+    QCOMPARE(envelope.size(), 2);
+
+    envelope.setColumnWidth(1);
+    QCOMPARE(envelope.size(), 0);
+}
+
+void ScopePlugin::testTimeSeriesTimestamps()
+{
+    TimeSeriesPlotData data("Gyros", "x");
+    data.setXWindowSize(1);
+
+    Gyros gyros;
+    Gyros::DataFields fields = gyros.getData();
+
+    // Samples are placed by the time the vehicle stamped them with, however
+    // fast they arrive
+    for (int i = 0; i < 300; i++) {
+        fields.x = i;
+        gyros.setData(fields);
+        gyros.setTimestamp(5000 + 10 * i);
+
+        QVERIFY(data.append(&gyros));
+    }
+
+    const PlotSamples &samples = data.getSamples();
+    QCOMPARE(samples.last(), QPointF(7.99, 299));
+
+    // About a second's worth is kept
+    QVERIFY(samples.last().x() - samples.first().x() <= 1.01);
+    QVERIFY(samples.size() >= 100 && samples.size() <= 102);
+
+    // Going back in time starts over
+    gyros.setTimestamp(100);
+    QVERIFY(data.append(&gyros));
+    QCOMPARE(samples.size(), 1);
+    QCOMPARE(samples.first(), QPointF(0.1, 299));
+
+    // Updates made in the GCS are stamped on its own clock when made
+    qint64 before = UAVObject::monotonicTimestamp();
+    gyros.setData(fields);
+    qint64 stamped = gyros.getTimestamp();
+    QVERIFY(stamped >= before && stamped <= UAVObject::monotonicTimestamp());
+    QTest::qWait(20);
+    QCOMPARE(gyros.getTimestamp(), stamped);
+}
+
+/**
+ * Feeds a dozen curves from a synthetic gyro object as fast as it can be
+ * updated, the load of a scope plotting fast telemetry or a log replay.
+ */
+void ScopePlugin::testAppendBenchmark()
+{
+    const int updates = 200000;
+    const char *axes[] = { "x", "y", "z" };
+    const char *maths[] = { "None", "Boxcar average", "Standard deviation", "None" };
+
+    std::vector<std::unique_ptr<ScatterplotData>> curves;
+
+    for (const char *math : maths) {
+        for (const char *axis : axes) {
+            ScatterplotData *data;
+
+            // Half plot the last 60 s, half the last 2000 samples
+            if (curves.size() % 2) {
+                data = new SeriesPlotData("Gyros", axis);
+                data->setXWindowSize(2000);
+            } else {
+                data = new TimeSeriesPlotData("Gyros", axis);
+                data->setXWindowSize(60);
+            }
+
+            data->setMeanSamples(100);
+            data->setMathFunction(math);
+
+            curves.emplace_back(data);
+        }
+    }
+
+    Gyros gyros;
+    Gyros::DataFields fields = gyros.getData();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < updates; i++) {
+        fields.x = sin(i * 0.01f);
+        fields.y = cos(i * 0.01f);
+        fields.z = i % 100;
+        gyros.setData(fields);
+
+        for (auto &curve : curves)
+            curve->append(&gyros);
+    }
+
+    qint64 elapsed = qMax(timer.elapsed(), (qint64)1);
+
+    qDebug() << curves.size() << "curves," << updates << "updates in" << elapsed << "ms:"
+             << updates * 1000 / elapsed << "updates/s";
+
+    for (size_t i = 0; i < curves.size(); i++)
+        QCOMPARE(curves[i]->getSamples().size(), i % 2 ? 2000 : updates);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -57,6 +57,14 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent)
     SystemAlarms *obj = SystemAlarms::GetInstance(objManager);
     connect(obj, &UAVObject::objectUpdated, this, &SystemHealthGadgetWidget::updateAlarms);
 
+    UAVObjectField *field = obj->getField("Alarm");
+    Q_ASSERT(field);
+    if (field) {
+        alarmNames = field->getElementNames();
+        for (int i = 0; i < field->getNumElements(); ++i)
+            alarmHandles.append(UAVObjectFieldHandle(field, i));
+    }
+
     // Listen to autopilot connection events
     TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
     connect(telMngr, &TelemetryManager::connected, this,
@@ -85,7 +93,21 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
 
 void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
 {
+    Q_UNUSED(systemAlarm);
+
     static QList<QString> warningClean;
+
+    QStringList values;
+    for (const UAVObjectFieldHandle &alarm : alarmHandles)
+        values.append(alarm.getValue().toString());
+
+    // SystemAlarms is sent over and over with the same alarms set; only
+    // rebuild the indicators when one of them changes
+    if (values == shownAlarms)
+        return;
+
+    shownAlarms = values;
+
     // This code does not know anything about alarms beforehand, and
     // I found no efficient way to locate items inside the scene by
     // name, so it's just as simple to reset the scene:
@@ -96,14 +118,9 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
         delete item; // removeItem does _not_ delete the item.
     }
 
-    UAVObjectField *field = systemAlarm->getField("Alarm");
-    Q_ASSERT(field);
-    if (field == NULL)
-        return;
-
-    for (auto i = 0; i < field->getNumElements(); ++i) {
-        QString element = field->getElementNames()[i];
-        QString value = field->getValue(i).toString();
+    for (int i = 0; i < alarmHandles.size(); ++i) {
+        const QString &element = alarmNames[i];
+        const QString &value = values[i];
         if (m_renderer->elementExists(element)) {
             QMatrix blockMatrix = m_renderer->matrixForElement(element);
             qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
@@ -171,6 +188,7 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
             if (telMngr->isConnected()) {
                 onAutopilotConnect();
                 SystemAlarms *obj = SystemAlarms::GetInstance(objManager);
+                shownAlarms.clear();
                 updateAlarms(obj);
             }
         }
@@ -37,6 +37,7 @@
 #include <QMap>
 #include <QFile>
 #include <QTimer>
+#include <QVector>
 
 class SystemHealthGadgetWidget : public QGraphicsView
 {
@@ -68,6 +69,13 @@ private:
     // Simple flag to skip rendering if the
     bool fgenabled; // layer does not exist.
 
+    // The elements of SystemAlarms.Alarm, resolved once
+    QStringList alarmNames;
+    QVector<UAVObjectFieldHandle> alarmHandles;
+
+    // The alarm states drawn now, to only redraw on a change
+    QStringList shownAlarms;
+
     void showAlarmDescriptionForItemId(const QString itemId, const QPoint &location);
     void showAllAlarmDescriptions(const QPoint &location);
     QString getAlarmDescriptionFileName(const QString itemId);
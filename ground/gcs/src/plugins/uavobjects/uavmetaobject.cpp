@@ -106,6 +106,7 @@ UAVObject::Metadata UAVMetaObject::getDefaultMetadata()
 void UAVMetaObject::setData(const Metadata &mdata)
 {
     parentMetadata = mdata;
+    setTimestamp(monotonicTimestamp());
     emit objectUpdatedAuto(this); // trigger object updated event
     emit objectUpdated(this);
 }
@@ -36,6 +36,7 @@
 #include "uavobject.h"
 #include <QtEndian>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonValue>
 
@@ -63,6 +64,7 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString &name)
     this->instID = 0;
     this->isSingleInst = isSingleInst;
     this->name = name;
+    this->timestamp = -1;
 }
 
 /**
@@ -180,6 +182,7 @@ void UAVObject::requestUpdateAllInstances()
  */
 void UAVObject::updated()
 {
+    setTimestamp(monotonicTimestamp());
     emit objectUpdatedManual(this);
     emit objectUpdated(this);
 }
@@ -250,6 +253,23 @@ UAVObjectField *UAVObject::getField(const QString &name)
     return NULL;
 }
 
+/**
+ * Resolve one element of a field once, so that it can be read on every
+ * update without looking up the names again
+ * \param[in] fieldName The field
+ * \param[in] elementName The element, or empty for the first
+ * @returns The handle, invalid if the field or element does not exist
+ */
+UAVObjectFieldHandle UAVObject::getFieldHandle(const QString &fieldName,
+                                               const QString &elementName)
+{
+    UAVObjectField *field = getField(fieldName);
+    if (!field)
+        return UAVObjectFieldHandle();
+
+    return field->getHandle(elementName);
+}
+
 /**
  * Pack the object data into a byte array
  * @returns The number of bytes copied
@@ -283,6 +303,36 @@ qint32 UAVObject::unpack(const quint8 *dataIn)
     return numBytes;
 }
 
+/**
+ * Get the time of the latest update, in milliseconds. This is the time the
+ * telemetry link stamped the update with: the vehicle's clock when the frame
+ * carried it, otherwise the time it was received or logged. Updates made in
+ * the GCS are stamped with monotonicTimestamp() when they are made, and
+ * objects never updated report the current monotonicTimestamp().
+ */
+qint64 UAVObject::getTimestamp()
+{
+    if (timestamp >= 0)
+        return timestamp;
+
+    return monotonicTimestamp();
+}
+
+/**
+ * Milliseconds on a clock that starts with the GCS and never steps, unlike
+ * the wall clock
+ */
+qint64 UAVObject::monotonicTimestamp()
+{
+    static const QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+
+    return clock.elapsed();
+}
+
 /**
  * Return a string with the object information
  */
@@ -61,6 +61,7 @@
 #define UAVOBJ_UPDATE_MODE_MASK 0x3
 
 class UAVObjectField;
+class UAVObjectFieldHandle;
 
 class UAVOBJECTS_EXPORT UAVObject : public QObject
 {
@@ -133,6 +134,11 @@ public:
     qint32 getNumFields();
     QList<UAVObjectField *> getFields();
     UAVObjectField *getField(const QString &name);
+    UAVObjectFieldHandle getFieldHandle(const QString &fieldName,
+                                        const QString &elementName = QString());
+    void setTimestamp(qint64 timestamp) { this->timestamp = timestamp; }
+    qint64 getTimestamp();
+    static qint64 monotonicTimestamp();
     QString toString();
     QString toStringBrief();
     QString toStringData();
@@ -251,6 +257,7 @@ protected:
     quint32 numBytes;
     quint8 *data;
     QList<UAVObjectField *> fields;
+    qint64 timestamp;
     void initializeFields(QList<UAVObjectField *> &fields, quint8 *data, quint32 numBytes);
     void setDescription(const QString &description);
 };
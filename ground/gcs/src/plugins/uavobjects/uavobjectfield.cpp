@@ -615,6 +615,18 @@ int UAVObjectField::getElementIndex(const QString &name) const
     return -1;
 }
 
+UAVObjectFieldHandle UAVObjectField::getHandle(const QString &elementName)
+{
+    if (elementName.isEmpty())
+        return UAVObjectFieldHandle(this);
+
+    int index = getElementIndex(elementName);
+    if (index < 0)
+        return UAVObjectFieldHandle();
+
+    return UAVObjectFieldHandle(this, index);
+}
+
 UAVObject *UAVObjectField::getObject() const
 {
     return obj;
@@ -647,6 +659,11 @@ QStringList UAVObjectField::getOptions() const
     return options;
 }
 
+QList<int> UAVObjectField::getOptionIndices() const
+{
+    return indices;
+}
+
 bool UAVObjectField::hasOption(const QString &option)
 {
     return options.contains(option);
@@ -1006,8 +1023,41 @@ void UAVObjectField::setValue(const QVariant &value, int index)
     }
 }
 
+/**
+ * @brief Get the value of an element as a double, without going through a
+ * QVariant for the numeric types
+ * @param index Element index
+ * @return the value, or 0 for an index out of bounds
+ */
 double UAVObjectField::getDouble(int index) const
 {
+    if (index < 0 || index >= numElements)
+        return 0;
+
+    const void *d = &data[offset + elementSize * static_cast<unsigned>(index)];
+
+    switch (type) {
+    case INT8:
+        return *static_cast<const qint8 *>(d);
+    case INT16:
+        return *static_cast<const qint16 *>(d);
+    case INT32:
+        return *static_cast<const qint32 *>(d);
+    case UINT8:
+        return *static_cast<const quint8 *>(d);
+    case UINT16:
+        return *static_cast<const quint16 *>(d);
+    case UINT32:
+        return *static_cast<const quint32 *>(d);
+    case FLOAT32:
+        return *static_cast<const float *>(d);
+    case ENUM:
+    case BITFIELD:
+    case STRING:
+        break;
+    }
+
+    // The rest convert from their text, as they always have
     return getValue(index).toDouble();
 }
 
@@ -36,6 +36,7 @@
 #include <QMap>
 
 class UAVObject;
+class UAVObjectFieldHandle;
 
 class UAVOBJECTS_EXPORT UAVObjectField : public QObject
 {
@@ -86,6 +87,11 @@ public:
     QString getElementName(int index = 0) const;
     int getElementIndex(const QString &name) const;
     QStringList getOptions() const;
+    /**
+     * @brief getOptionIndices Get the enum value of each option
+     * @return values in the same order as getOptions()
+     */
+    QList<int> getOptionIndices() const;
     /**
      * @brief hasOption Check if the given option exists
      * @param option Option value
@@ -99,6 +105,12 @@ public:
     void setValue(const QVariant &data, int index = 0);
     double getDouble(int index = 0) const;
     void setDouble(double value, int index = 0);
+    /**
+     * @brief Resolve an element by name, for reading it repeatedly
+     * @param elementName Element name, or empty for the first element
+     * @return handle to the element, invalid if there is no such element
+     */
+    UAVObjectFieldHandle getHandle(const QString &elementName = QString());
     size_t getNumBytes() const;
     bool isNumeric() const;
     bool isText() const;
@@ -160,6 +172,35 @@ protected:
     void limitsInitialize(const QString &limits);
 };
 
+/**
+ * @brief A single element of a field, looked up by name once. Reading it back
+ * takes no name lookups and no allocation, for consumers that read the same
+ * element on every object update.
+ */
+class UAVOBJECTS_EXPORT UAVObjectFieldHandle
+{
+public:
+    explicit UAVObjectFieldHandle(UAVObjectField *field = nullptr, int index = 0)
+        : field(field)
+        , index(index)
+    {
+        if (field && (index < 0 || index >= field->getNumElements()))
+            this->field = nullptr;
+    }
+
+    bool isValid() const { return field != nullptr; }
+    UAVObjectField *getField() const { return field; }
+    UAVObject *getObject() const { return field ? field->getObject() : nullptr; }
+    int getIndex() const { return index; }
+
+    double getDouble() const { return field->getDouble(index); }
+    QVariant getValue() const { return field->getValue(index); }
+
+private:
+    UAVObjectField *field;
+    int index;
+};
+
 #endif // UAVOBJECTFIELD_H
 
 /**
@@ -27,8 +27,9 @@
 #ifndef UAVOBJECTSINIT_H
 #define UAVOBJECTSINIT_H
 
+#include "uavobjects_global.h"
 #include "uavobjectmanager.h"
 
-void UAVObjectsInitialize(UAVObjectManager *objMngr);
+UAVOBJECTS_EXPORT void UAVObjectsInitialize(UAVObjectManager *objMngr);
 
 #endif // UAVOBJECTSINIT_H
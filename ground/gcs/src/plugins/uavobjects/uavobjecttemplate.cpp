@@ -108,6 +108,7 @@ void $(NAME)::setData(const DataFields& data)
     // Update object if the access mode permits
     if (UAVObject::GetGcsAccess(mdata) == ACCESS_READWRITE) {
         this->data = data;
+        setTimestamp(monotonicTimestamp());
         emit objectUpdatedAuto(this); // trigger object updated event
         emit objectUpdated(this);
     }
@@ -720,6 +720,11 @@ Telemetry::TelemetryStats Telemetry::getStats()
     stats.txObjects = utalkStats.txObjects;
     stats.txErrors = utalkStats.txErrors + txErrors;
     stats.rxErrors = utalkStats.rxErrors;
+    stats.rxSyncErrors = utalkStats.rxSyncErrors;
+    stats.rxVersionErrors = utalkStats.rxVersionErrors;
+    stats.rxSizeErrors = utalkStats.rxSizeErrors;
+    stats.rxCrcErrors = utalkStats.rxCrcErrors;
+    stats.rxObjectErrors = utalkStats.rxObjectErrors;
     stats.txRetries = txRetries;
 
     txErrors = 0;
@@ -78,6 +78,11 @@ public:
         quint32 txObjects;
         quint32 txErrors;
         quint32 rxErrors;
+        quint32 rxSyncErrors;
+        quint32 rxVersionErrors;
+        quint32 rxSizeErrors;
+        quint32 rxCrcErrors;
+        quint32 rxObjectErrors;
         quint32 txRetries;
     } TelemetryStats;
 
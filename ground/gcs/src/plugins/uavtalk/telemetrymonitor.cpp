@@ -33,6 +33,7 @@
 #include "telemetrymonitor.h"
 #include "coreplugin/connectionmanager.h"
 #include "coreplugin/icore.h"
+#include "coreplugin/coreconstants.h"
 #include "firmwareiapobj.h"
 
 // Number of retries for initial session object fetching
@@ -67,6 +68,8 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel,
     , numberOfObjects(0)
     , retries(0)
     , requestsInFlight(0)
+    , tableUnsupported(false)
+    , tableIndex(0)
     , isManaged(true)
     , sessions(sessions)
 {
@@ -77,6 +80,7 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel,
     flightStatsObj = FlightTelemetryStats::GetInstance(objMngr);
 
     sessionObj = SessionManaging::GetInstance(objMngr);
+    tableObj = SessionObjectTable::GetInstance(objMngr);
 
     // Listen for flight stats updates
     connect(flightStatsObj, &UAVObject::objectUpdated, this, &TelemetryMonitor::flightStatsUpdated);
@@ -101,6 +105,9 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel,
     connect(this, &TelemetryMonitor::telemetryUpdated, cm,
             &Core::ConnectionManager::telemetryUpdated);
     connect(sessionObj, &UAVObject::objectUnpacked, this, &TelemetryMonitor::sessionObjUnpackedCB);
+    connect(tableObj, &UAVObject::objectUnpacked, this, &TelemetryMonitor::tableObjUnpackedCB);
+    connect(tableObj, QOverload<UAVObject *, bool>::of(&UAVObject::transactionCompleted), this,
+            &TelemetryMonitor::tableTransactionCompleted);
     connect(objMngr, &UAVObjectManager::newInstance, this, &TelemetryMonitor::newInstanceSlot);
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -140,7 +147,8 @@ void TelemetryMonitor::startRetrievingObjects()
     objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
     foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects().values()) {
         UAVObject *obj = map.first();
-        if (obj->getObjID() == SessionManaging::OBJID) {
+        if (obj->getObjID() == SessionManaging::OBJID
+            || obj->getObjID() == SessionObjectTable::OBJID) {
             continue;
         }
         UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
@@ -201,9 +209,9 @@ void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool
                 QString("%0 Object %1 has %2 instances on hw and %3 on the GCS")
                     .arg(Q_FUNC_INFO)
                     .arg(dobj->getName())
-                    .arg(sessionObj->getObjectInstances())
+                    .arg(instID)
                     .arg(currentInstances));
-            if (currentInstances < sessionObj->getObjectInstances()) {
+            if (currentInstances < instID) {
                 TELEMETRYMONITOR_QXTLOG_DEBUG(
                     QString("%0 cloned and registered object %1 INSTID=%2")
                         .arg(Q_FUNC_INFO)
@@ -413,6 +421,10 @@ void TelemetryMonitor::sessionObjUnpackedCB(UAVObject *obj)
     case CON_SESSION_INITIALIZING:
         startSessionRetrieving(obj);
         break;
+    case CON_SESSION_TABLE:
+        // The flight side echoes the session ID it was handed with the
+        // table; nothing to do until the table is complete
+        break;
     case CON_RETRIEVING_OBJECTS:
         TELEMETRYMONITOR_QXTLOG_DEBUG(
             QString(
@@ -445,6 +457,122 @@ void TelemetryMonitor::sessionInitialRetrieveTimeoutCB()
             sessionObj->updated();
             sessionInitialRetrieveTimeout->start(SESSION_INITIAL_RETRIEVE_TIMEOUT);
         }
+    } else if (connectionStatus == CON_SESSION_TABLE) {
+        if (sessionObjRetries < SESSION_OBJ_RETRIEVE_RETRIES) {
+            TELEMETRYMONITOR_QXTLOG_DEBUG(
+                QString("%0 object table page %1 timeout try=%2, going to retry")
+                    .arg(Q_FUNC_INFO)
+                    .arg(tableIndex)
+                    .arg(sessionObjRetries));
+            ++sessionObjRetries;
+            requestTablePage(tableIndex);
+        } else {
+            qInfo() << QString("%0 no object table from the autopilot, asking object by object")
+                           .arg(Q_FUNC_INFO);
+            tableUnsupported = true;
+            startSessionRetrieving(NULL);
+        }
+    }
+}
+
+/**
+ * Ask the autopilot for a page of its object table.
+ * @param firstIndex the index of the first object wanted
+ */
+void TelemetryMonitor::requestTablePage(int firstIndex)
+{
+    connectionStatus = CON_SESSION_TABLE;
+    tableIndex = firstIndex;
+
+    tableObj->setSessionID(sessionID);
+    tableObj->setFirstIndex(firstIndex);
+    tableObj->updated();
+
+    sessionInitialRetrieveTimeout->start(SESSION_INITIAL_RETRIEVE_TIMEOUT);
+}
+
+/**
+ * Firmware without the object table NACKs the request; go back to
+ * negotiating the session one object at a time.
+ */
+void TelemetryMonitor::tableTransactionCompleted(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+
+    if (success || connectionStatus != CON_SESSION_TABLE)
+        return;
+
+    qInfo() << QString("%0 autopilot has no object table, asking object by object")
+                   .arg(Q_FUNC_INFO);
+    sessionInitialRetrieveTimeout->stop();
+    tableUnsupported = true;
+    startSessionRetrieving(NULL);
+}
+
+/**
+ * A page of the object table arrived: mark what is on the hardware, and
+ * ask for the next page or move on to fetching the objects.
+ */
+void TelemetryMonitor::tableObjUnpackedCB(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    if (connectionStatus != CON_SESSION_TABLE)
+        return;
+
+    // Stale or repeated page; the timeout asks again if need be
+    if (tableObj->getSessionID() != sessionID || tableObj->getFirstIndex() != tableIndex)
+        return;
+
+    sessionObjRetries = 0;
+    sessionInitialRetrieveTimeout->stop();
+
+    if (tableIndex == 0) {
+        QByteArray hash;
+        for (quint32 i = 0; i < SessionObjectTable::UAVOHASH_NUMELEM; i++)
+            hash.append((char)tableObj->getUAVOHash(i));
+
+        QString gcsHash = QString::fromLatin1(Core::Constants::UAVOSHA1_STR)
+                              .replace("\"{ ", "")
+                              .replace(" }\"", "")
+                              .replace(",", "")
+                              .replace("0x", "");
+
+        if (!gcsHash.isEmpty() && hash.toHex() != gcsHash.toLatin1())
+            qInfo() << QString("%0 autopilot objects (%1) differ from the GCS ones (%2)")
+                           .arg(Q_FUNC_INFO)
+                           .arg(QString::fromLatin1(hash.toHex()))
+                           .arg(gcsHash);
+    }
+
+    int objectCount = tableObj->getNumberOfObjects();
+
+    for (quint32 i = 0; i < SessionObjectTable::OBJECTID_NUMELEM; i++) {
+        if (tableIndex + (int)i >= objectCount)
+            break;
+
+        quint32 objID = tableObj->getObjectID(i);
+        quint32 instances = tableObj->getObjectInstances(i);
+
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(objMngr->getObject(objID));
+        if (!dobj)
+            continue;
+
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 RECEIVED INDEX:%1 object:%2 instances:%3")
+                                          .arg(Q_FUNC_INFO)
+                                          .arg(tableIndex + i)
+                                          .arg(dobj->getName())
+                                          .arg(instances));
+        dobj->setIsPresentOnHardware(true);
+        if (instances > 1 && !dobj->isSingleInstance())
+            changeObjectInstances(objID, instances, true);
+    }
+
+    if (tableIndex + (int)SessionObjectTable::OBJECTID_NUMELEM < objectCount) {
+        requestTablePage(tableIndex + SessionObjectTable::OBJECTID_NUMELEM);
+    } else {
+        saveSession();
+        startRetrievingObjects();
     }
 }
 
@@ -503,6 +631,15 @@ void TelemetryMonitor::startSessionRetrieving(UAVObject *session)
         if (objectCount == 0)
             return;
         sessionID = QDateTime::currentDateTime().toTime_t();
+        if (!tableUnsupported) {
+            TELEMETRYMONITOR_QXTLOG_DEBUG(
+                QString("%0 SESSION SETUP from the object table, sessionID:%1")
+                    .arg(Q_FUNC_INFO)
+                    .arg(sessionID));
+            sessionObjRetries = 0;
+            requestTablePage(0);
+            return;
+        }
         sessionObj->setSessionID(sessionID);
         sessionObj->setObjectOfInterestIndex(0);
         TELEMETRYMONITOR_QXTLOG_DEBUG(
@@ -568,6 +705,14 @@ void TelemetryMonitor::processStatsUpdates()
     gcsStats.RxDataRate = (float)telStats.rxBytes / ((float)statsTimer->interval() / 1000.0);
     gcsStats.TxDataRate = (float)telStats.txBytes / ((float)statsTimer->interval() / 1000.0);
     gcsStats.RxFailures += telStats.rxErrors;
+
+    if (telStats.rxErrors) {
+        TELEMETRYMONITOR_QXTLOG_DEBUG(
+                QString("Rx errors: %0 sync bytes, %1 version, %2 size, %3 CRC, %4 object")
+                .arg(telStats.rxSyncErrors).arg(telStats.rxVersionErrors)
+                .arg(telStats.rxSizeErrors).arg(telStats.rxCrcErrors)
+                .arg(telStats.rxObjectErrors));
+    }
     gcsStats.TxFailures += telStats.txErrors;
     gcsStats.TxRetries += telStats.txRetries;
 
@@ -618,6 +763,7 @@ void TelemetryMonitor::processStatsUpdates()
         sessionInitialRetrieveTimeout->start(SESSION_INITIAL_RETRIEVE_TIMEOUT);
         sessionObj->requestUpdate();
         isManaged = true;
+        tableUnsupported = false;
     }
     if (gcsStats.Status == GCSTelemetryStats::STATUS_DISCONNECTED && gcsStats.Status != oldStatus) {
         statsTimer->setInterval(STATS_CONNECT_PERIOD_MS);
@@ -45,6 +45,7 @@
 #include "systemstats.h"
 #include "telemetry.h"
 #include "sessionmanaging.h"
+#include "sessionobjecttable.h"
 #include <coreplugin/generalsettings.h>
 #include <extensionsystem/pluginmanager.h>
 
@@ -75,6 +76,8 @@ public slots:
     void flightStatsUpdated(UAVObject *obj);
 private slots:
     void sessionObjUnpackedCB(UAVObject *obj);
+    void tableObjUnpackedCB(UAVObject *obj);
+    void tableTransactionCompleted(UAVObject *obj, bool success);
     void objectRetrieveTimeoutCB();
     void sessionInitialRetrieveTimeoutCB();
     void saveSession();
@@ -86,6 +89,7 @@ private:
         CON_DISCONNECTED,
         CON_INITIALIZING,
         CON_SESSION_INITIALIZING,
+        CON_SESSION_TABLE,
         CON_RETRIEVING_OBJECTS,
         CON_CONNECTED_UNMANAGED,
         CON_CONNECTED_MANAGED
@@ -103,6 +107,7 @@ private:
     QTimer *statsTimer;
     QTime *connectionTimer;
     SessionManaging *sessionObj;
+    SessionObjectTable *tableObj;
     void startRetrievingObjects();
     void retrieveNextObject();
     quint16 sessionID;
@@ -114,6 +119,9 @@ private:
 
     void changeObjectInstances(quint32 objID, quint32 instID, bool delayed);
     void startSessionRetrieving(UAVObject *session);
+    void requestTablePage(int firstIndex);
+    bool tableUnsupported;
+    int tableIndex;
     void sessionFallback();
     bool isManaged;
     QHash<quint16, QList<objStruc>> sessions;
@@ -33,6 +33,7 @@
  */
 
 #include "uavtalk.h"
+#include "uavtalk_crc.h"
 #include <QtEndian>
 #include <QDebug>
 #include <extensionsystem/pluginmanager.h>
@@ -47,25 +48,6 @@
 
 #define SYNC_VAL 0x3C
 
-const quint8 UAVTalk::crc_table[256] = {
-    0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
-    0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
-    0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
-    0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
-    0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
-    0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
-    0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
-    0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
-    0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
-    0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
-    0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
-    0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
-    0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
-    0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
-    0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
-    0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
-};
-
 /**
  * Constructor
  */
@@ -80,6 +62,12 @@ UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr)
 
     memset(&stats, 0, sizeof(ComStats));
 
+    timeSource = dynamic_cast<UAVTalkTimeSource *>(iodev);
+    rxTimestamp = -1;
+    vehicleTime = 0;
+    lastVehicleTimestamp = 0;
+    vehicleTimeValid = false;
+
     connect(io.data(), &QIODevice::readyRead, this, &UAVTalk::processInputStream);
 }
 
@@ -207,44 +195,86 @@ bool UAVTalk::receiveFileChunk(quint32 fileId, quint8 *data, quint32 length)
 }
 
 /**
- * Process a frame from input, if available.
- * \return False if there was insufficient data for a frame, true if trying
- * again is worthwhile.
+ * Count a receive error against its cause and the overall total.
  */
-bool UAVTalk::processInput()
+void UAVTalk::countRxError(quint32 &cause, quint32 count)
 {
-    unsigned int bytesAvail = filledBytes - startOffset;
+    cause += count;
+    stats.rxErrors += count;
+}
 
-    if (bytesAvail < sizeof(UAVTalkHeader)) {
-        return false;
-    }
+/**
+ * Find the next plausible frame header in the input buffer.  Instead of
+ * stepping one byte at a time after a framing error, memchr skips straight
+ * to each sync byte candidate, and the fixed header fields are checked
+ * before we wait on or checksum the rest of the frame.  startOffset is
+ * left pointing at the header returned.
+ * \return The header, or nullptr if more data is needed to find one
+ */
+UAVTalk::UAVTalkHeader *UAVTalk::findHeader()
+{
+    while (startOffset < filledBytes) {
+        quint8 *start = rxBuffer + startOffset;
+        quint8 *sync = (quint8 *) memchr(start, SYNC_VAL,
+                filledBytes - startOffset);
 
-    UAVTalkHeader *hdr = (UAVTalkHeader *) (rxBuffer + startOffset);
+        if (sync == nullptr) {
+            countRxError(stats.rxSyncErrors, filledBytes - startOffset);
+            startOffset = filledBytes;
 
-    /* Basic framing checks.  If these fail, skip forward one byte and retry
-     * to capture stream sync.
-     */
-    if (hdr->sync != SYNC_VAL) {
-        startOffset++;
-        stats.rxErrors++;
+            return nullptr;
+        }
 
-        return true;
-    }
+        if (sync != start) {
+            countRxError(stats.rxSyncErrors, sync - start);
+            startOffset += sync - start;
+        }
 
-    if ((hdr->type & VER_MASK) != TYPE_VER) {
-        startOffset++;
-        stats.rxErrors++;
+        if (filledBytes - startOffset < sizeof(UAVTalkHeader)) {
+            return nullptr;
+        }
 
-        return true;
+        UAVTalkHeader *hdr = (UAVTalkHeader *) sync;
+
+        if ((hdr->type & VER_MASK) != TYPE_VER) {
+            countRxError(stats.rxVersionErrors);
+            startOffset++;
+
+            continue;
+        }
+
+        /* Anything longer can't be a frame; waiting for it would only
+         * stall the stream.
+         */
+        if (hdr->size < sizeof(UAVTalkHeader) ||
+                hdr->size > MAX_PACKET_LENGTH - CHECKSUM_LENGTH) {
+            countRxError(stats.rxSizeErrors);
+            startOffset++;
+
+            continue;
+        }
+
+        return hdr;
     }
 
-    if (hdr->size < sizeof(UAVTalkHeader)) {
-        startOffset++;
-        stats.rxErrors++;
+    return nullptr;
+}
 
-        return true;
+/**
+ * Process a frame from input, if available.
+ * \return False if there was insufficient data for a frame, true if trying
+ * again is worthwhile.
+ */
+bool UAVTalk::processInput()
+{
+    UAVTalkHeader *hdr = findHeader();
+
+    if (hdr == nullptr) {
+        return false;
     }
 
+    unsigned int bytesAvail = filledBytes - startOffset;
+
     /* OK, let's ensure we have enough bytes for the whole frame. 
      * Size doesn't include CRC, so add one.
      */
@@ -258,11 +288,11 @@ bool UAVTalk::processInput()
 
     if (ourCrc != *theirCrc) {
         /* Since we can't trust hdr->size for sure, we should just skip
-         * forward one byte.
+         * forward to the next sync byte.
          */
 
         startOffset++;
-        stats.rxErrors++;
+        countRxError(stats.rxCrcErrors);
 
         return true;
     }
@@ -289,7 +319,7 @@ bool UAVTalk::processInput()
     UAVObject *rxObj = objMngr->getObject(rxObjId);
 
     if (rxObj == nullptr) {
-        stats.rxErrors++;
+        countRxError(stats.rxObjectErrors);
         UAVTALK_QXTLOG_DEBUG("UAVTalk: unknown object");
 
         if (rxType == TYPE_OBJ_REQ || rxType == TYPE_OBJ_ACK) {
@@ -309,20 +339,38 @@ bool UAVTalk::processInput()
         payloadBytes -= 2;
     }
 
-    /* XXX timestamps */
+    /* Stamp the object with the vehicle's time if the frame carries it,
+     * otherwise with when we got it.
+     */
+    if (hdr->type & TYPE_TIMESTAMPED) {
+        if (payloadBytes < TIMESTAMP_LENGTH) {
+            countRxError(stats.rxObjectErrors);
+
+            return true;
+        }
+
+        rxTimestamp = vehicleTimestamp(qFromLittleEndian<quint16>(payload));
+
+        payload += TIMESTAMP_LENGTH;
+        payloadBytes -= TIMESTAMP_LENGTH;
+    } else if (timeSource) {
+        rxTimestamp = timeSource->currentTimestamp();
+    } else {
+        rxTimestamp = UAVObject::monotonicTimestamp();
+    }
 
     // Check data length
     if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
         if (payloadBytes != 0) {
             UAVTALK_QXTLOG_DEBUG("UAVTalk: Unexpected data in req/ack/nack");
-            stats.rxErrors++;
+            countRxError(stats.rxObjectErrors);
 
             return true;
         }
     } else {
         if (payloadBytes != rxObj->getNumBytes()) {
             UAVTALK_QXTLOG_DEBUG("UAVTalk: Unexpected payload size for obj");
-            stats.rxErrors++;
+            countRxError(stats.rxObjectErrors);
 
             return true;
         }
@@ -462,6 +510,27 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
     return !error;
 }
 
+/**
+ * Extend the 16 bit timestamp of a frame to the vehicle's full clock, by
+ * counting the time since the previous timestamped frame.  Gaps of more
+ * than a wrap (65 seconds) without one can't be told apart.
+ * \param[in] timestamp Low 16 bits of the vehicle time, in milliseconds
+ * \return The vehicle time in milliseconds
+ */
+qint64 UAVTalk::vehicleTimestamp(quint16 timestamp)
+{
+    if (vehicleTimeValid) {
+        vehicleTime += (quint16)(timestamp - lastVehicleTimestamp);
+    } else {
+        vehicleTime = timestamp;
+        vehicleTimeValid = true;
+    }
+
+    lastVehicleTimestamp = timestamp;
+
+    return vehicleTime;
+}
+
 /**
  * Update the data of an object from a byte array (unpack).
  * If the object instance could not be found in the list, then a
@@ -488,10 +557,12 @@ UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
         if (!objMngr->registerObject(instobj)) {
             return nullptr;
         }
+        instobj->setTimestamp(rxTimestamp);
         instobj->unpack(data);
         return instobj;
     } else {
         // Unpack data into object instance
+        obj->setTimestamp(rxTimestamp);
         obj->unpack(data);
         return obj;
     }
@@ -672,25 +743,14 @@ bool UAVTalk::transmitSingleObject(UAVObject *obj, quint8 type, bool allInstance
 /**
  * Update the crc value with new data.
  *
- * Generated by pycrc v0.7.5, http://www.tty1.net/pycrc/
- * using the configuration:
- *    Width        = 8
- *    Poly         = 0x07
- *    XorIn        = 0x00
- *    ReflectIn    = False
- *    XorOut       = 0x00
- *    ReflectOut   = False
- *    Algorithm    = table-driven
+ * CRC-8, poly 0x07, computed eight bytes at a time; see uavtalk_crc.h.
  *
  * \param crc      The current crc value.
  * \param data     Pointer to a buffer of \a data_len bytes.
  * \param length   Number of bytes in the \a data buffer.
  * \return         The updated crc value.
  */
-
 quint8 UAVTalk::updateCRC(quint8 crc, const quint8 *data, qint32 length)
 {
-    while (length--)
-        crc = crc_table[crc ^ *data++];
-    return crc;
+    return uavtalk_crc_update(crc, data, length);
 }
@@ -43,6 +43,22 @@
 #include "uavtalk_global.h"
 #include <QtNetwork/QUdpSocket>
 
+/**
+ * Implemented by devices that know when the data they hand out was first
+ * received, such as a log being replayed, so objects are stamped with that
+ * time instead of when the data was read back.
+ */
+class UAVTALK_EXPORT UAVTalkTimeSource
+{
+public:
+    virtual ~UAVTalkTimeSource() {}
+
+    /**
+     * The time the data now available was received, in milliseconds
+     */
+    virtual qint64 currentTimestamp() const = 0;
+};
+
 class UAVTALK_EXPORT UAVTalk : public QObject
 {
     Q_OBJECT
@@ -57,7 +73,12 @@ public:
         quint32 rxObjects;
         quint32 txObjects;
         quint32 txErrors;
-        quint32 rxErrors;
+        quint32 rxErrors; // Sum of all the causes below
+        quint32 rxSyncErrors; // Bytes discarded looking for a sync byte
+        quint32 rxVersionErrors; // Candidate frames with a bad version
+        quint32 rxSizeErrors; // Candidate frames with an impossible size
+        quint32 rxCrcErrors; // Frames failing the CRC check
+        quint32 rxObjectErrors; // Valid frames for unknown objects or of the wrong length
     };
 
     UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr);
@@ -87,6 +108,7 @@ protected:
     // Constants
     static const int VER_MASK = 0x70;
     static const int TYPE_MASK = 0x0f;
+    static const int TYPE_TIMESTAMPED = 0x80;
 
     static const int TYPE_VER = 0x20;
     static const int TYPE_OBJ = 0x00;
@@ -99,6 +121,7 @@ protected:
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = MIN_HEADER_LENGTH + 2; // instance ID(2, not used in single objs)
+    static const int TIMESTAMP_LENGTH = 2; // After the instance ID in timestamped frames
 
     static const int CHECKSUM_LENGTH = 1;
 
@@ -110,7 +133,6 @@ protected:
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
     static const int TX_BACKLOG_SIZE = 2 * 1024;
-    static const quint8 crc_table[256];
 
 #pragma pack(push)
 #pragma pack(1)
@@ -147,12 +169,24 @@ protected:
 
     ComStats stats;
 
+    // The time objects being received are stamped with. Timestamped frames
+    // carry the low 16 bits of the vehicle's millisecond clock, which are
+    // extended here as they wrap.
+    UAVTalkTimeSource *timeSource;
+    qint64 rxTimestamp;
+    qint64 vehicleTime;
+    quint16 lastVehicleTimestamp;
+    bool vehicleTimeValid;
+
     // Methods
+    UAVTalkHeader *findHeader();
+    void countRxError(quint32 &cause, quint32 count = 1);
     bool objectTransaction(UAVObject *obj, quint8 type, bool allInstances);
     bool receiveObject(quint8 type, quint32 objId, quint16 instId,
             quint8 *data, quint32 length);
     bool receiveFileChunk(quint32 fileId, quint8 *data, quint32 length);
     UAVObject *updateObject(quint32 objId, quint16 instId, quint8 *data);
+    qint64 vehicleTimestamp(quint16 timestamp);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject *obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject *obj, quint8 type, bool allInstances);
@@ -5,4 +5,5 @@ SUBDIRS = \
     libs \
     plugins \
     app \
+    logreplay \
     crashreporterapp
@@ -0,0 +1,327 @@
+"""
+Reads and writes the chunked dRonin log format.
+
+Copyright (C) 2016 dRonin, http://dronin.org
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+
+After a 16 byte file header (b'dRonLOG\\n', then the format version and flags)
+a log is a sequence of chunks:
+
+    [type: 4 bytes][flags: u32][stored length: u32][raw length: u32]
+    [payload]
+    [stored length: u32][crc32 of everything before it in the chunk: u32]
+
+A chunk only counts once its trailer is there and checks out, so a log that
+was cut short is readable up to its last complete chunk.  META chunks hold
+"key=value" lines, UAVO the XML description of the objects in the log, DATA
+a zlib compressed block of records in the legacy GCS layout (timestamp,
+length, UAVTalk frame), and END marks a log that was closed properly.
+"""
+
+import struct
+import time
+import zlib
+
+MAGIC = b'dRonLOG\n'
+VERSION = 2
+
+FLAG_COMPRESSED = 1
+
+BLOCK_SIZE = 65536
+
+file_header_fmt = struct.Struct('<8sII')
+chunk_header_fmt = struct.Struct('<4sIII')
+chunk_trailer_fmt = struct.Struct('<II')
+record_header_fmt = struct.Struct('<IQ')
+
+def is_chunked_log(file_obj):
+    """ Checks (without moving) whether a file is a chunked log. """
+    pos = file_obj.tell()
+    magic = file_obj.read(len(MAGIC))
+    file_obj.seek(pos)
+
+    return magic == MAGIC
+
+def read_chunks(file_obj):
+    """ Generates the (type, payload) of each intact chunk of a log, from the
+    current position of file_obj; stops at the first damaged one. """
+
+    while True:
+        header = file_obj.read(chunk_header_fmt.size)
+
+        if len(header) < chunk_header_fmt.size:
+            return
+
+        (kind, flags, stored_len, raw_len) = chunk_header_fmt.unpack(header)
+
+        payload = file_obj.read(stored_len)
+        trailer = file_obj.read(chunk_trailer_fmt.size)
+
+        if len(trailer) < chunk_trailer_fmt.size:
+            return
+
+        (trailer_len, crc) = chunk_trailer_fmt.unpack(trailer)
+
+        if trailer_len != stored_len or \
+                crc != zlib.crc32(header + payload) & 0xffffffff:
+            return
+
+        if flags & FLAG_COMPRESSED:
+            payload = zlib.decompress(payload)
+
+            if len(payload) != raw_len:
+                return
+
+        yield (kind, payload)
+
+def decode_meta(payload):
+    meta = {}
+
+    for line in payload.decode('utf-8').split('\n'):
+        key, sep, value = line.partition('=')
+
+        if sep:
+            meta[key] = value
+
+    return meta
+
+def encode_meta(meta):
+    return ''.join('%s=%s\n' % (k, v) for k, v in sorted(meta.items())).encode('utf-8')
+
+def collection_from_description(payload):
+    """ Builds a UAVOCollection from the UAVO chunk of a log. """
+    from .uavo import etree
+    from . import uavo, uavo_collection
+
+    collection = uavo_collection.UAVOCollection()
+
+    unprocessed = etree.fromstring(payload).findall('object')
+    some_processed = True
+
+    # Objects with enums taken from another object need it done first
+    while unprocessed and some_processed:
+        some_processed = False
+        pending = []
+
+        for obj in unprocessed:
+            wrapper = etree.Element('xml')
+            wrapper.append(obj)
+
+            try:
+                u = uavo.make_class(collection, etree.tostring(wrapper),
+                        update_globals=False)
+            except Exception:
+                pending.append(obj)
+                continue
+
+            collection.update([('{0:08x}'.format(u._id), u)])
+            some_processed = True
+
+        unprocessed = pending
+
+    for obj in unprocessed:
+        print("Unable to decode object %s from the log" % (obj.get('name')))
+
+    return collection
+
+def describe_collection(collection):
+    """ Describes the objects of a UAVOCollection, as a UAVO chunk. """
+    from .uavo import etree
+    import copy
+
+    root = etree.Element('uavobjects')
+
+    for u in collection.values():
+        obj = copy.deepcopy(u.to_xml_description())
+        obj.set('id', '0x%08x' % (u._id))
+        root.append(obj)
+
+    return etree.tostring(root)
+
+class LogReader(object):
+    """ Reads a chunked log: its metadata, the objects it was made with, and
+    its records. """
+
+    def __init__(self, file_obj):
+        self.f = file_obj
+
+        header = self.f.read(file_header_fmt.size)
+
+        if len(header) < file_header_fmt.size:
+            raise IOError("truncated log header")
+
+        (magic, self.version, flags) = file_header_fmt.unpack(header)
+
+        if magic != MAGIC:
+            raise IOError("not a chunked log")
+
+        if self.version > VERSION:
+            raise IOError("log format version %d is not supported" % (self.version))
+
+        self.meta = {}
+        self.uavo_defs = None
+        self.ended = False
+
+        self.chunks = read_chunks(self.f)
+        self.pending = []
+
+        # The metadata and object descriptions come before the first block
+        for kind, payload in self.chunks:
+            if kind == b'DATA':
+                self.pending.append(payload)
+                break
+
+            self.__handle(kind, payload)
+
+    def __handle(self, kind, payload):
+        if kind == b'META':
+            self.meta.update(decode_meta(payload))
+        elif kind == b'UAVO':
+            self.uavo_defs = collection_from_description(payload)
+        elif kind == b'END ':
+            self.ended = True
+
+    def githash(self):
+        return self.meta.get('githash')
+
+    def read_block(self):
+        """ Returns the next block of records (in the legacy GCS layout), or
+        b'' at the end of the log. """
+
+        if self.pending:
+            return self.pending.pop(0)
+
+        for kind, payload in self.chunks:
+            if kind == b'DATA':
+                return payload
+
+            self.__handle(kind, payload)
+
+        return b''
+
+    def records(self):
+        """ Generates the (timestamp, UAVTalk frame) of each record. """
+        while True:
+            block = self.read_block()
+
+            if block == b'':
+                return
+
+            pos = 0
+
+            while pos + record_header_fmt.size <= len(block):
+                (timestamp, size) = record_header_fmt.unpack_from(block, pos)
+                pos += record_header_fmt.size
+
+                yield (timestamp, block[pos:pos + size])
+                pos += size
+
+class LogWriter(object):
+    """ Writes a chunked log. """
+
+    def __init__(self, file_obj, uavo_defs, meta={}):
+        self.f = file_obj
+        self.block = []
+        self.block_len = 0
+        self.records = 0
+        self.last_timestamp = 0
+
+        self.f.write(file_header_fmt.pack(MAGIC, VERSION, 0))
+
+        meta = dict(meta)
+        meta.setdefault('created',
+                time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime()))
+
+        self.write_chunk(b'META', encode_meta(meta), compress=False)
+        self.write_chunk(b'UAVO', describe_collection(uavo_defs))
+
+    def write_chunk(self, kind, payload, compress=True):
+        flags = 0
+        stored = payload
+
+        if compress:
+            packed = zlib.compress(payload)
+
+            if len(packed) < len(payload):
+                stored = packed
+                flags |= FLAG_COMPRESSED
+
+        header = chunk_header_fmt.pack(kind, flags, len(stored), len(payload))
+        crc = zlib.crc32(header + stored) & 0xffffffff
+
+        self.f.write(header + stored + chunk_trailer_fmt.pack(len(stored), crc))
+
+    def write_record(self, timestamp, frame):
+        self.block.append(record_header_fmt.pack(timestamp, len(frame)))
+        self.block.append(frame)
+        self.block_len += record_header_fmt.size + len(frame)
+
+        self.records += 1
+        self.last_timestamp = timestamp
+
+        if self.block_len >= BLOCK_SIZE:
+            self.flush()
+
+    def flush(self):
+        if self.block_len:
+            self.write_chunk(b'DATA', b''.join(self.block))
+            self.block = []
+            self.block_len = 0
+
+    def close(self):
+        self.flush()
+        self.write_chunk(b'END ',
+                struct.pack('<II', self.records, self.last_timestamp),
+                compress=False)
+
+def convert_legacy(src, dst, githash=None):
+    """ Converts a legacy GCS log (git hash header, then timestamped records)
+    to the chunked format, embedding the definitions of the objects it was
+    made with.
+
+     - src: legacy log, opened for binary reading
+     - dst: file to write the chunked log to, opened for binary writing
+     - githash: override the git hash from the log header
+    """
+    from . import uavo_collection
+
+    sig = src.readline()
+    if not (sig.endswith(b'dRonin git hash:\n') or sig.endswith(b'Tau Labs git hash:\n')):
+        raise IOError("no legacy log header signature")
+
+    log_githash = src.readline().strip().decode('latin-1')
+    uavohash = src.readline().strip().decode('latin-1')
+
+    # GCS logs have a divider before the records
+    pos = src.tell()
+    if src.readline() != b'##\n':
+        src.seek(pos)
+
+    uavo_defs = uavo_collection.UAVOCollection()
+    uavo_defs.from_git_hash(githash or log_githash)
+
+    writer = LogWriter(dst, uavo_defs,
+            { 'githash' : log_githash, 'uavohash' : uavohash })
+
+    while True:
+        header = src.read(record_header_fmt.size)
+
+        if len(header) < record_header_fmt.size:
+            break
+
+        (timestamp, size) = record_header_fmt.unpack(header)
+
+        # Same sanity check as the GCS; lost sync ends the conversion
+        if size & 0xFFFFFFFFFFFF0000:
+            print("Lost sync at offset %d, stopping" % (src.tell()))
+            break
+
+        frame = src.read(size)
+        if len(frame) < size:
+            break
+
+        writer.write_record(timestamp, frame)
+
+    writer.close()
+
+    return writer.records
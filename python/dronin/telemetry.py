@@ -12,7 +12,7 @@ import errno
 import sys
 from threading import Condition
 
-from . import uavtalk, uavo_collection, uavo
+from . import uavtalk, uavo_collection, uavo, drlog
 
 import os
 
@@ -27,7 +27,8 @@ class TelemetryBase(with_metaclass(ABCMeta)):
 
     def __init__(self, githash=None, service_in_iter=True,
             iter_blocks=True, use_walltime=True, do_handshaking=False,
-            gcs_timestamps=False, name=None, progress_callback=None):
+            gcs_timestamps=False, name=None, progress_callback=None,
+            uavo_defs=None):
 
         """Instantiates a telemetry instance.  Called only by derived classes.
          - githash: revision control id of the UAVO's used to communicate.
@@ -47,16 +48,19 @@ class TelemetryBase(with_metaclass(ABCMeta)):
          - name: a filename to store into .filename for legacy purposes
          - progress_callback: a function to call periodically with progress
              information
+         - uavo_defs: the UAVO definitions to use, instead of looking them up
+             by githash
         """
 
-        uavo_defs = uavo_collection.UAVOCollection()
+        if uavo_defs is None:
+            uavo_defs = uavo_collection.UAVOCollection()
 
-        if githash:
-            uavo_defs.from_git_hash(githash)
-        else:
-            xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
-                                    "shared", "uavobjectdefinition")
-            uavo_defs.from_uavo_xml_path(xml_path)
+            if githash:
+                uavo_defs.from_git_hash(githash)
+            else:
+                xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
+                                        "shared", "uavobjectdefinition")
+                uavo_defs.from_uavo_xml_path(xml_path)
 
         self.uavo_defs = uavo_defs
 
@@ -917,8 +921,22 @@ class FileTelemetry(TelemetryBase):
         """
 
         self.f = file_obj
+        self.log_reader = None
 
-        if parse_header:
+        if drlog.is_chunked_log(self.f):
+            # Chunked logs describe their own objects; no githash needed
+            self.log_reader = drlog.LogReader(self.f)
+
+            print("Log file is based on git hash: %s" % (self.log_reader.githash()))
+
+            if self.log_reader.uavo_defs is not None:
+                kwargs.pop('githash', None)
+            kwargs['gcs_timestamps'] = True
+
+            TelemetryBase.__init__(self, iter_blocks=True,
+                do_handshaking=False, use_walltime=False,
+                uavo_defs=self.log_reader.uavo_defs, *args, **kwargs)
+        elif parse_header:
             # Check the header signature
             #    First line is "dRonin git hash:" or "Tau Labs git hash:"
             #    Second line is the actual git hash
@@ -967,6 +985,9 @@ class FileTelemetry(TelemetryBase):
     def _receive(self, finish_time):
         """ Fetch available data from file """
 
+        if self.log_reader is not None:
+            return self.log_reader.read_block()
+
         buf = self.f.read(524288)   # 512k
 
         return buf
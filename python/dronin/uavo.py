@@ -371,10 +371,10 @@ def make_class(collection, xml_file, update_globals=True):
                     for ii, option_text in enumerate(field.get('options').split(',')):
                         info['options'][option_text.strip()] = ii
                 else:
-                    # we must have some 'option' elements in this sub-tree
-                    for ii, option_text in enumerate([option.text
-                            for option in field.findall('options/option')]):
-                        info['options'][option_text.strip()] = ii
+                    # we must have some 'option' elements in this sub-tree;
+                    # descriptions embedded in logs give each one's value
+                    for ii, option in enumerate(field.findall('options/option')):
+                        info['options'][option.text.strip()] = int(option.get('value', ii))
 
             # convert type string to an int
             info['type_val'] = type_enum_map[info['type']]
@@ -460,6 +460,10 @@ def make_class(collection, xml_file, update_globals=True):
 
     uavo_id = hash_calc.get_hash()
 
+    # Descriptions embedded in logs carry the ID the object was sent with
+    if subs['object'].get('id') is not None:
+        uavo_id = int(subs['object'].get('id'), 16)
+
     ##### FORM A STRUCT TO PACK/UNPACK THIS UAVO'S CONTENT #####
     formats = []
     num_subelems = []
@@ -19,7 +19,7 @@ import time
 
 __all__ = [ "send_object", "process_stream" ]
 
-from six import int2byte, indexbytes, byte2int, iterbytes
+from six import int2byte, indexbytes, byte2int
 
 # Constants used for UAVTalk parsing
 (MIN_HEADER_LENGTH, MAX_HEADER_LENGTH, MAX_PAYLOAD_LENGTH) = (8, 12, (256-12))
@@ -371,14 +371,17 @@ def acknowledge_object(obj):
 
     return packet
 
-def calcCRC(s):
+def calcCRC(s, cs=0, table=tuple(crc_table)):
     """
     Calculate a CRC consistently with how they are computed on the firmware side
-    """
 
-    cs = 0
+    Slicing tables (see shared/api/uavtalk_crc.h) do not pay off in the
+    interpreter, where the cost is per operation rather than the dependency
+    between lookups; binding the table locally and iterating a bytearray is
+    what helps here.
+    """
 
-    for c in iterbytes(s):
-        cs = crc_table[cs ^ c]
+    for c in bytearray(s):
+        cs = table[cs ^ c]
 
     return cs
@@ -86,7 +86,7 @@ setup(
         'all': ['pyserial', 'numpy', 'matplotlib', 'dronin-pyqtgraph', 'PyQt5'],
     },
 
-    scripts = [ 'dronin-dumplog', 'dronin-halt',
+    scripts = [ 'dronin-dumplog', 'dronin-convertlog', 'dronin-halt',
         'dronin-getconfig', 'dronin-logfsimport',
         'dronin-shell' ],
 #    package_data={